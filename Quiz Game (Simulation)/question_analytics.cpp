@@ -0,0 +1,210 @@
+#include "question_analytics.h"
+#include "../SRMS/profiler.h"
+#include "../SRMS/work_pool.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+// ---------- Matching ----------
+QuestionMatcher::QuestionMatcher(const QuestionBank& bank) : fingerprints(bank.size()) {
+    byFingerprint.reserve(bank.size());
+    for (size_t q = 0; q < bank.size(); ++q) {
+        fingerprints[q] = question_fingerprint(bank, q);
+        byFingerprint.emplace(fingerprints[q], (uint32_t)q);   // duplicates are the same question
+    }
+}
+
+size_t QuestionMatcher::find(const SessionResult::Answer& a) const {
+    if (a.fingerprint == 0) return SIZE_MAX;
+    if (a.question < fingerprints.size() && fingerprints[a.question] == a.fingerprint) return a.question;
+    auto it = byFingerprint.find(a.fingerprint);
+    return it == byFingerprint.end() ? SIZE_MAX : it->second;
+}
+
+// ---------- Columns ----------
+void AnswerColumns::resize(size_t questions, size_t options) {
+    for (std::vector<uint64_t>* c : {&shown, &answered, &correct, &tenths, &pairs, &pairCorrect}) c->assign(questions, 0);
+    for (std::vector<double>* c : {&sumRest, &sumRest2, &sumRestCorrect}) c->assign(questions, 0);
+    picks.assign(options, 0);
+    sessions = answers = unmatched = moved = 0;
+}
+
+void AnswerColumns::add(const QuestionBank& bank, const QuestionMatcher& match, const SessionResult& r) {
+    sessions++;
+    uint32_t taken = 0, right = 0;
+    for (const SessionResult::Answer& a : r.answers) {
+        if (a.choice == 0xFF) continue;
+        taken++;
+        right += a.correct;
+    }
+    for (const SessionResult::Answer& a : r.answers) {
+        answers++;
+        size_t q = match.find(a);
+        if (q >= shown.size()) {
+            unmatched++;
+            continue;
+        }
+        moved += q != a.question;
+        shown[q]++;
+        if (a.choice == 0xFF) continue;
+        answered[q]++;
+        correct[q] += a.correct;
+        tenths[q] += a.tenths;
+        if (a.choice < bank.optionCount(q)) picks[bank.question(q).firstOption + a.choice]++;
+        if (taken > 1) {
+            double x = (double)(right - a.correct) / (taken - 1);
+            pairs[q]++;
+            pairCorrect[q] += a.correct;
+            sumRest[q] += x;
+            sumRest2[q] += x * x;
+            if (a.correct) sumRestCorrect[q] += x;
+        }
+    }
+}
+
+void AnswerColumns::merge(const AnswerColumns& o) {
+    auto addAll = [](auto& to, const auto& from) {
+        for (size_t i = 0; i < to.size(); ++i) to[i] += from[i];
+    };
+    addAll(shown, o.shown);
+    addAll(answered, o.answered);
+    addAll(correct, o.correct);
+    addAll(tenths, o.tenths);
+    addAll(pairs, o.pairs);
+    addAll(pairCorrect, o.pairCorrect);
+    addAll(sumRest, o.sumRest);
+    addAll(sumRest2, o.sumRest2);
+    addAll(sumRestCorrect, o.sumRestCorrect);
+    addAll(picks, o.picks);
+    sessions += o.sessions;
+    answers += o.answers;
+    unmatched += o.unmatched;
+    moved += o.moved;
+}
+
+size_t AnswerColumns::bytes() const {
+    return shown.size() * (6 * sizeof(uint64_t) + 3 * sizeof(double)) + picks.size() * sizeof(uint64_t);
+}
+
+// ---------- Analytics ----------
+QuestionAnalytics::QuestionAnalytics(const QuestionBank& bank) : bank(bank), match(bank) {
+    cols.resize(bank.size(), bank.totalOptions());
+}
+
+size_t QuestionAnalytics::recompute(const std::string& logPath, unsigned threads) {
+    cols.resize(bank.size(), bank.totalOptions());
+    seq = 0;
+    return update(logPath, threads);
+}
+
+size_t QuestionAnalytics::update(const std::string& logPath, unsigned threads) {
+    PROFILE_SCOPE("QuestionAnalytics::update");
+    WorkStealingPool pool(threads);
+    // A partial set of columns per worker, made on its first session; the
+    // calling thread (worker 0) adds straight into the totals.
+    std::vector<AnswerColumns> partial(pool.size());
+    uint64_t before = cols.answers;
+    size_t n = for_each_result_parallel(logPath, pool, seq, [&](const SessionResult& r, unsigned worker) {
+        AnswerColumns& c = worker == 0 ? cols : partial[worker];
+        if (worker != 0 && c.shown.empty()) c.resize(bank.size(), bank.totalOptions());
+        c.add(bank, match, r);
+    }, &seq);
+    for (const AnswerColumns& c : partial)
+        if (!c.shown.empty()) cols.merge(c);
+    PROFILE_COUNT("answers analysed", cols.answers - before);
+    return n;
+}
+
+void QuestionAnalytics::add(const SessionResult& r) {
+    cols.add(bank, match, r);
+    seq = std::max(seq, r.seq);
+}
+
+double QuestionAnalytics::pValue(size_t q) const {
+    return cols.answered[q] ? (double)cols.correct[q] / cols.answered[q] : 0;
+}
+
+double QuestionAnalytics::discrimination(size_t q) const {
+    double n = (double)cols.pairs[q], sy = (double)cols.pairCorrect[q];
+    double sx = cols.sumRest[q], sxx = cols.sumRest2[q], sxy = cols.sumRestCorrect[q];
+    // Pearson r with y in {0, 1}, so sum(y^2) = sum(y).
+    double vx = n * sxx - sx * sx, vy = n * sy - sy * sy;
+    if (n < 2 || vx <= 0 || vy <= 0) return 0;
+    return (n * sxy - sx * sy) / std::sqrt(vx * vy);
+}
+
+double QuestionAnalytics::skipRate(size_t q) const {
+    return cols.shown[q] ? 1.0 - (double)cols.answered[q] / cols.shown[q] : 0;
+}
+
+double QuestionAnalytics::meanSeconds(size_t q) const {
+    return cols.answered[q] ? cols.tenths[q] / 10.0 / cols.answered[q] : 0;
+}
+
+double QuestionAnalytics::optionRate(size_t q, size_t k) const {
+    return cols.answered[q] ? (double)cols.picks[bank.question(q).firstOption + k] / cols.answered[q] : 0;
+}
+
+int QuestionAnalytics::difficultyFor(double p) {
+    // Midpoints between the priors.
+    if (p >= 0.825) return 1;
+    if (p >= 0.675) return 2;
+    if (p >= 0.525) return 3;
+    if (p >= 0.375) return 4;
+    return 5;
+}
+
+size_t QuestionAnalytics::applyDifficulty(QuestionBank& target, uint64_t minAnswers) const {
+    size_t changed = 0;
+    for (size_t q = 0; q < target.size() && q < cols.answered.size(); ++q) {
+        if (cols.answered[q] < std::max<uint64_t>(minAnswers, 1)) continue;
+        int d = difficultyFor(pValue(q));
+        if (d == target.difficulty(q)) continue;
+        target.setDifficulty(q, d);
+        changed++;
+    }
+    return changed;
+}
+
+// ---------- Report ----------
+static std::string csv_quote(std::string_view s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+bool QuestionAnalytics::writeReport(const std::string& path, std::string* why) const {
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        if (why) *why = "cannot write " + tmp;
+        return false;
+    }
+    fprintf(f, "question,topic,difficulty,measured_difficulty,shown,answered,p_value,discrimination,skip_rate,mean_seconds,option_rates,text\n");
+    for (size_t q = 0; q < bank.size(); ++q) {
+        std::string rates;
+        for (size_t k = 0; k < bank.optionCount(q); ++k) {
+            char buf[32];
+            snprintf(buf, sizeof buf, "%s%s%.3f", k ? ";" : "", bank.isCorrect(q, k) ? "*" : "", optionRate(q, k));
+            rates += buf;
+        }
+        fprintf(f, "%zu,%s,%d,%d,%llu,%llu,%.4f,%.4f,%.4f,%.2f,%s,%s\n", q + 1, csv_quote(bank.topicName(bank.topic(q))).c_str(),
+                bank.difficulty(q), cols.answered[q] ? difficultyFor(pValue(q)) : 0, (unsigned long long)cols.shown[q],
+                (unsigned long long)cols.answered[q], pValue(q), discrimination(q), skipRate(q), meanSeconds(q), rates.c_str(),
+                csv_quote(bank.text(q)).c_str());
+    }
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    if (!ok || ec) {
+        if (why) *why = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
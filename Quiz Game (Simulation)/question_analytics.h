@@ -0,0 +1,93 @@
+// Per-question statistics from recorded answers, fed back as difficulty (no raylib dependency)
+
+#pragma once
+#include "question_bank.h"
+#include "results_log.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Which bank question a recorded answer was for: the one at its index when
+// the fingerprints agree, else the one with its fingerprint (questions.txt
+// was edited since), else none.
+struct QuestionMatcher {
+    explicit QuestionMatcher(const QuestionBank& bank);
+    // SIZE_MAX for an answer recorded without a fingerprint, or for a
+    // question no longer in the bank (or since changed).
+    size_t find(const SessionResult::Answer& a) const;
+
+    std::vector<uint32_t> fingerprints;               // per question
+    std::unordered_map<uint32_t, uint32_t> byFingerprint;
+};
+
+// Running sums per question, one column each, plus picks per bank option.
+// Every statistic is a ratio of these sums, so partial sets add up exactly:
+// each worker fills its own and they are added together at the end.
+struct AnswerColumns {
+    std::vector<uint64_t> shown, answered, correct, tenths;
+    // Discrimination: answers whose session had at least one other answer,
+    // with x = the session's fraction right on its other questions.
+    std::vector<uint64_t> pairs, pairCorrect;
+    std::vector<double> sumRest, sumRest2, sumRestCorrect;
+    std::vector<uint64_t> picks;
+    uint64_t sessions = 0, answers = 0;
+    uint64_t unmatched = 0;   // answers QuestionMatcher couldn't place, left out
+    uint64_t moved = 0;       // answers placed by fingerprint at another index
+
+    void resize(size_t questions, size_t options);
+    void add(const QuestionBank& bank, const QuestionMatcher& match, const SessionResult& r);
+    void merge(const AnswerColumns& o);
+    size_t bytes() const;
+};
+
+// Item analysis over the results log:
+//   p-value         share of answers that were right (skips not counted)
+//   discrimination  point-biserial correlation between getting the question
+//                   right and the session's score on its other questions;
+//                   near 0 or negative flags a question that doesn't tell
+//                   strong players from weak ones, or a wrong answer key
+//   option rates    share of answers picking each option (the distractors)
+//   skip rate, mean time to answer
+// Answers are placed by QuestionMatcher, so editing questions.txt never
+// credits an old answer to a different question; answers to questions that
+// changed, and those logged before answers carried fingerprints, are left
+// out.
+class QuestionAnalytics {
+public:
+    explicit QuestionAnalytics(const QuestionBank& bank);
+
+    // Forgets everything and reads the whole log.
+    size_t recompute(const std::string& logPath, unsigned threads = 0);
+    // Adds the sessions logged since the last recompute/update/add; returns
+    // how many.
+    size_t update(const std::string& logPath, unsigned threads = 0);
+    // One session, as it is appended (r.seq set).
+    void add(const SessionResult& r);
+    uint64_t lastSeq() const { return seq; }
+
+    const AnswerColumns& columns() const { return cols; }
+    uint64_t answered(size_t q) const { return cols.answered[q]; }
+    double pValue(size_t q) const;
+    double discrimination(size_t q) const;   // 0 with too few answers to tell
+    double skipRate(size_t q) const;
+    double meanSeconds(size_t q) const;
+    double optionRate(size_t q, size_t k) const;
+
+    // Difficulty 1-5 for a p-value: the level whose prior in QuestionStats
+    // (0.9, 0.75, 0.6, 0.45, 0.3) is nearest.
+    static int difficultyFor(double pValue);
+    // Sets the difficulty of every question with at least minAnswers answers
+    // from its p-value; returns how many changed. bank must be the one the
+    // analytics was built for.
+    size_t applyDifficulty(QuestionBank& bank, uint64_t minAnswers = 30) const;
+
+    // One CSV row per question, with its option rates and text.
+    bool writeReport(const std::string& path, std::string* why = nullptr) const;
+
+private:
+    const QuestionBank& bank;
+    QuestionMatcher match;
+    AnswerColumns cols;
+    uint64_t seq = 0;
+};
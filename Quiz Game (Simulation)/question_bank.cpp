@@ -0,0 +1,327 @@
+#include "question_bank.h"
+#include "../SRMS/mapped_file.h"
+#include "../SRMS/profiler.h"
+#include "../SRMS/work_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+static double now_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------- Building ----------
+void QuestionBank::clear() {
+    // Swapping with empties releases the memory, which clear() alone keeps.
+    std::string().swap(arena);
+    std::vector<Question>().swap(questions);
+    std::vector<Option>().swap(options);
+    topicNames.assign(1, std::string());
+}
+
+void QuestionBank::reserve(size_t questionCount, size_t optionCount, size_t textBytes) {
+    questions.reserve(questionCount);
+    options.reserve(optionCount);
+    arena.reserve(textBytes);
+}
+
+void QuestionBank::addQuestion(std::string_view text) {
+    Question q;
+    q.textOff = (uint32_t)arena.size();
+    q.textLen = (uint32_t)text.size();
+    q.firstOption = (uint32_t)options.size();
+    arena.append(text.data(), text.size());
+    arena.push_back('\0');
+    questions.push_back(q);
+}
+
+void QuestionBank::addOption(std::string_view text, bool correct) {
+    if (questions.empty()) return;
+    Option o;
+    o.textOff = (uint32_t)arena.size();
+    o.textLen = (uint32_t)text.size();
+    o.correct = correct;
+    arena.append(text.data(), text.size());
+    arena.push_back('\0');
+    options.push_back(o);
+    questions.back().optionCount++;
+}
+
+// Banks have a handful of topics, so a scan beats keeping a map alongside.
+int QuestionBank::findTopic(std::string_view name) const {
+    for (size_t t = 0; t < topicNames.size(); ++t)
+        if (topicNames[t] == name) return (int)t;
+    return -1;
+}
+
+int QuestionBank::internTopic(std::string_view name) {
+    int t = findTopic(name);
+    if (t >= 0) return t;
+    if (topicNames.size() > UINT16_MAX) return 0;
+    topicNames.emplace_back(name);
+    return (int)topicNames.size() - 1;
+}
+
+void QuestionBank::setTopic(std::string_view name) {
+    if (questions.empty()) return;
+    questions.back().topic = (uint16_t)internTopic(name);
+}
+
+void QuestionBank::setDifficulty(int difficulty) {
+    if (questions.empty() || difficulty < 1 || difficulty > 5) return;
+    questions.back().difficulty = (uint8_t)difficulty;
+}
+
+void QuestionBank::setDifficulty(size_t q, int difficulty) {
+    if (q >= questions.size() || difficulty < 0 || difficulty > 5) return;
+    questions[q].difficulty = (uint8_t)difficulty;
+}
+
+size_t QuestionBank::bytes() const {
+    return (arena.capacity() > 15 ? arena.capacity() + 1 : 0) + questions.capacity() * sizeof(Question) +
+           options.capacity() * sizeof(Option);
+}
+
+// ---------- Loading ----------
+static bool is_blank(std::string_view line) {
+    if (!line.empty() && !isspace((unsigned char)line[0])) return false;
+    for (char c : line)
+        if (!isspace((unsigned char)c)) return false;
+    return true;
+}
+
+// "@topic Name" or "@difficulty N"; anything else is ignored.
+static void parse_tag(std::string_view line, QuestionBank& bank) {
+    size_t sp = line.find_first_of(" \t");
+    std::string_view key = line.substr(1, sp == std::string_view::npos ? std::string_view::npos : sp - 1);
+    std::string_view value = sp == std::string_view::npos ? std::string_view() : line.substr(sp);
+    while (!value.empty() && isspace((unsigned char)value.front())) value.remove_prefix(1);
+    while (!value.empty() && isspace((unsigned char)value.back())) value.remove_suffix(1);
+    if (key == "topic" && !value.empty()) bank.setTopic(value);
+    else if (key == "difficulty" && value.size() == 1) bank.setDifficulty(value[0] - '0');
+}
+
+size_t parse_questions(const char* data, size_t size, QuestionBank& bank) {
+    size_t before = bank.size();
+    const char* p = data;
+    const char* end = data + size;
+    bool inBlock = false;
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* eol = nl ? nl : end;
+        std::string_view line(p, eol - p);
+        p = nl ? nl + 1 : end;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (is_blank(line)) {
+            inBlock = false;
+            continue;
+        }
+        if (!inBlock) {
+            bank.addQuestion(line);
+            inBlock = true;
+            continue;
+        }
+        size_t bar = line.find('|');
+        if (bar == std::string_view::npos) {
+            if (line[0] == '@') parse_tag(line, bank);
+            continue;
+        }
+        bank.addOption(line.substr(0, bar), line.substr(bar + 1) == "1");
+    }
+    return bank.size() - before;
+}
+
+// ---------- Parallel Loading ----------
+// Sizes a bank for size bytes of questions from the counts in the first 64 KB.
+static void reserve_for(QuestionBank& bank, const char* data, size_t size) {
+    size_t sample = std::min<size_t>(size, 64 << 10);
+    size_t bars = std::count(data, data + sample, '|');
+    size_t lines = std::count(data, data + sample, '\n') + 1;
+    double scale = sample ? 1.1 * size / sample : 1.0;
+    // One option per '|'; a block is typically its question line plus a blank
+    // one. Each text's NUL takes the place of its newline, so the arena never
+    // needs more than the bytes.
+    bank.reserve((size_t)(((lines - std::min(bars, lines)) / 2 + 1) * scale), (size_t)(bars * scale) + 1, size + 1);
+}
+
+// Start of the first line after a blank one, at or past the line after pos:
+// a block boundary. size if there is none.
+static size_t next_block_start(const char* data, size_t size, size_t pos) {
+    const char* end = data + size;
+    const char* p = (const char*)memchr(data + pos, '\n', size - pos);
+    while (p && ++p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        if (is_blank(std::string_view(p, (nl ? nl : end) - p))) return nl ? (size_t)(nl + 1 - data) : size;
+        p = nl;
+    }
+    return size;
+}
+
+size_t parse_questions_parallel(const char* data, size_t size, QuestionBank& bank, const QuestionLoadOptions& opt,
+                                QuestionLoadStats* stats) {
+    double t0 = now_sec();
+    bank.clear();
+    QuestionLoadStats st;
+    st.bytes = size;
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    // A few chunks per thread, so a thread that finishes early can take over work.
+    size_t step = std::max<size_t>(opt.chunkBytes, size / ((size_t)threads * 4) + 1);
+    std::vector<size_t> cuts = {0};
+    while (threads > 1 && size - cuts.back() > step) {
+        size_t c = next_block_start(data, size, cuts.back() + step);
+        if (c >= size) break;
+        cuts.push_back(c);
+    }
+    cuts.push_back(size);
+    st.chunks = cuts.size() - 1;
+
+    if (st.chunks == 1) {
+        reserve_for(bank, data, size);
+        parse_questions(data, size, bank);
+        st.parseSec = now_sec() - t0;
+        if (stats) *stats = st;
+        return bank.size();
+    }
+    WorkStealingPool pool(threads);
+    std::vector<QuestionBank> parts(st.chunks);
+    pool.run(st.chunks, [&](size_t i, unsigned) {
+        reserve_for(parts[i], data + cuts[i], cuts[i + 1] - cuts[i]);
+        parse_questions(data + cuts[i], cuts[i + 1] - cuts[i], parts[i]);
+    });
+    double t1 = now_sec();
+    st.parseSec = t1 - t0;
+
+    // Where each part lands in the merged arrays.
+    std::vector<size_t> q0(st.chunks + 1, 0), o0(st.chunks + 1, 0), a0(st.chunks + 1, 0);
+    for (size_t i = 0; i < st.chunks; ++i) {
+        q0[i + 1] = q0[i] + parts[i].questions.size();
+        o0[i + 1] = o0[i] + parts[i].options.size();
+        a0[i + 1] = a0[i] + parts[i].arena.size();
+    }
+    // Topic numbers are per part; renumber them in file order of first use.
+    std::vector<std::vector<uint16_t>> topicMap(st.chunks);
+    for (size_t i = 0; i < st.chunks; ++i)
+        for (const std::string& name : parts[i].topicNames) topicMap[i].push_back((uint16_t)bank.internTopic(name));
+    bank.questions.resize(q0.back());
+    bank.options.resize(o0.back());
+    bank.arena.resize(a0.back());
+    pool.run(st.chunks, [&](size_t i, unsigned) {
+        QuestionBank& part = parts[i];
+        memcpy(&bank.arena[a0[i]], part.arena.data(), part.arena.size());
+        for (size_t k = 0; k < part.questions.size(); ++k) {
+            QuestionBank::Question q = part.questions[k];
+            q.textOff += (uint32_t)a0[i];
+            q.firstOption += (uint32_t)o0[i];
+            q.topic = topicMap[i][q.topic];
+            bank.questions[q0[i] + k] = q;
+        }
+        for (size_t k = 0; k < part.options.size(); ++k) {
+            QuestionBank::Option o = part.options[k];
+            o.textOff += (uint32_t)a0[i];
+            bank.options[o0[i] + k] = o;
+        }
+        part.clear();
+    });
+    st.mergeSec = now_sec() - t1;
+    if (stats) *stats = st;
+    return bank.size();
+}
+
+bool load_questions(const std::string& path, QuestionBank& bank, const QuestionLoadOptions& opt, QuestionLoadStats* stats) {
+    PROFILE_SCOPE("load_questions");
+    double t = now_sec();
+    MappedFile f;
+    if (!f.open(path)) return false;
+    double mapSec = now_sec() - t;
+    PROFILE_COUNT("question bytes read", f.size());
+    size_t n = parse_questions_parallel(f.data(), f.size(), bank, opt, stats);
+    if (stats) stats->mapSec = mapSec;
+    PROFILE_COUNT("questions loaded", n);
+    return true;
+}
+
+bool save_difficulties(const std::string& path, const QuestionBank& bank, std::string* why) {
+    MappedFile f;
+    if (!f.open(path)) {
+        if (why) *why = "cannot read " + path;
+        return false;
+    }
+    std::string out;
+    out.reserve(f.size() + 16 * bank.size());
+    const char* p = f.data();
+    const char* end = p + f.size();
+    size_t q = 0;
+    bool inBlock = false, same = true;
+    // Walks the blocks as parse_questions() does, copying each line whole.
+    while (p < end && same) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        std::string_view raw(p, (nl ? nl + 1 : end) - p);
+        std::string_view line(p, (nl ? nl : end) - p);
+        p = nl ? nl + 1 : end;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (is_blank(line)) {
+            inBlock = false;
+            out.append(raw);
+            continue;
+        }
+        if (!inBlock) {
+            same = q < bank.size() && line == bank.text(q);
+            // A block the bank doesn't have, or has as another question.
+            if (!same) break;
+            inBlock = true;
+            out.append(raw);
+            if (bank.difficulty(q)) {
+                std::string_view eol = raw.substr(line.size());
+                if (eol.empty()) {
+                    eol = "\n";
+                    out.append(eol);
+                }
+                out += "@difficulty ";
+                out += (char)('0' + bank.difficulty(q));
+                out.append(eol);
+            }
+            q++;
+            continue;
+        }
+        bool difficultyTag = line[0] == '@' && line.find('|') == std::string_view::npos && line.substr(1, 10) == "difficulty" &&
+                             (line.size() == 11 || isspace((unsigned char)line[11]));
+        if (!difficultyTag) out.append(raw);
+    }
+    f.close();
+    if (!same || q != bank.size()) {
+        if (why) *why = path + " has changed since it was loaded; difficulties not saved";
+        return false;
+    }
+    std::string tmp = path + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (!fp) {
+        if (why) *why = "cannot write " + tmp;
+        return false;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+    ok = fclose(fp) == 0 && ok;
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    if (!ok || ec) {
+        if (why) *why = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+uint32_t question_fingerprint(const QuestionBank& bank, size_t q) {
+    // FNV-1a, with a separator after each text so "ab"+"c" and "a"+"bc" differ.
+    uint32_t h = 2166136261u;
+    auto mix = [&](std::string_view s, char sep) {
+        for (char c : s) h = (h ^ (uint8_t)c) * 16777619u;
+        h = (h ^ (uint8_t)sep) * 16777619u;
+    };
+    mix(bank.text(q), 0);
+    for (size_t k = 0; k < bank.optionCount(q); ++k) mix(bank.optionText(q, k), bank.isCorrect(q, k) ? 2 : 1);
+    return h ? h : 1;
+}
@@ -0,0 +1,120 @@
+// Question bank: contiguous questions and options over one text arena (no raylib dependency)
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct QuestionLoadOptions {
+    unsigned threads = 0;            // 0 = std::thread::hardware_concurrency()
+    size_t chunkBytes = 4 << 20;     // smallest chunk handed to one thread
+};
+
+struct QuestionLoadStats {
+    size_t bytes = 0;
+    size_t chunks = 0;
+    double mapSec = 0;     // opening the memory map
+    double parseSec = 0;   // cutting and parsing the chunks
+    double mergeSec = 0;   // stitching them into one bank, in file order
+};
+
+class QuestionBank;
+size_t parse_questions_parallel(const char* data, size_t size, QuestionBank& bank, const QuestionLoadOptions& opt,
+                                QuestionLoadStats* stats);
+
+// questions.txt holds blocks separated by blank lines. The first line of a
+// block is the question and each later "text|1" or "text|0" line is an
+// option (1 = correct). A block may also carry "@topic Name" and
+// "@difficulty N" lines (N from 1, easy, to 5, hard); other lines without a
+// '|' are ignored, as older loaders ignore these.
+//
+// All text lives in one arena. Questions and options are plain arrays that
+// refer to it by offset, and a question's options are a contiguous run of
+// the option array. Loading is one pass with no per-node allocation, and
+// clear() (or the destructor) frees the whole bank at once. Each text is
+// followed by a NUL, so text(q).data() can go straight to raylib. Offsets are
+// 32 bits, so a bank holds up to 4 GB of text. Topics are numbered in order of
+// first appearance; topic 0 is the unnamed one of untagged questions.
+class QuestionBank {
+public:
+    struct Question {
+        uint32_t textOff = 0, textLen = 0;
+        uint32_t firstOption = 0;
+        uint32_t optionCount = 0;
+        uint16_t topic = 0;
+        uint8_t difficulty = 0;   // 0 = not given
+    };
+    struct Option {
+        uint32_t textOff = 0, textLen = 0;
+        bool correct = false;
+    };
+
+    size_t size() const { return questions.size(); }
+    bool empty() const { return questions.empty(); }
+    // Questions are numbered from 0 in file order (the old list ids were q + 1).
+    std::string_view text(size_t q) const { return view(questions[q].textOff, questions[q].textLen); }
+    size_t optionCount(size_t q) const { return questions[q].optionCount; }
+    std::string_view optionText(size_t q, size_t k) const { const Option& o = option(q, k); return view(o.textOff, o.textLen); }
+    bool isCorrect(size_t q, size_t k) const { return option(q, k).correct; }
+    const Question& question(size_t q) const { return questions[q]; }
+    const Option& option(size_t q, size_t k) const { return options[questions[q].firstOption + k]; }
+    size_t totalOptions() const { return options.size(); }
+    int topic(size_t q) const { return questions[q].topic; }
+    int difficulty(size_t q) const { return questions[q].difficulty; }
+    size_t topicCount() const { return topicNames.size(); }
+    const std::string& topicName(int t) const { return topicNames[t]; }
+    // -1 if no question has that topic.
+    int findTopic(std::string_view name) const;
+
+    // Building: options, topics and difficulties attach to the question added last.
+    void clear();
+    void reserve(size_t questionCount, size_t optionCount, size_t textBytes);
+    void addQuestion(std::string_view text);
+    void addOption(std::string_view text, bool correct);
+    void setTopic(std::string_view name);
+    void setDifficulty(int difficulty);
+    // For measured difficulties: 1-5, or 0 to clear.
+    void setDifficulty(size_t q, int difficulty);
+
+    // Heap bytes held (capacity, not size).
+    size_t bytes() const;
+
+private:
+    friend size_t parse_questions_parallel(const char*, size_t, QuestionBank&, const QuestionLoadOptions&, QuestionLoadStats*);
+    std::string_view view(uint32_t off, uint32_t len) const { return std::string_view(arena.data() + off, len); }
+
+    int internTopic(std::string_view name);
+
+    std::string arena;
+    std::vector<Question> questions;
+    std::vector<Option> options;
+    std::vector<std::string> topicNames = {""};
+};
+
+// Parses questions.txt content; blocks are appended to bank. Returns the
+// number of questions added.
+size_t parse_questions(const char* data, size_t size, QuestionBank& bank);
+// Replaces bank with the questions in data. The bytes are cut into chunks at
+// blank lines (block boundaries, where parsing needs no carried state),
+// the chunks are parsed on a WorkStealingPool and the parts are copied into
+// bank in file order, so the result is the same as parse_questions'. Small
+// inputs and threads = 1 parse in place. Returns bank.size().
+size_t parse_questions_parallel(const char* data, size_t size, QuestionBank& bank,
+                                const QuestionLoadOptions& opt = QuestionLoadOptions(), QuestionLoadStats* stats = nullptr);
+// Replaces bank with the file's questions, read through a memory map and
+// parsed in parallel; false if it cannot be read.
+bool load_questions(const std::string& path, QuestionBank& bank, const QuestionLoadOptions& opt = QuestionLoadOptions(),
+                    QuestionLoadStats* stats = nullptr);
+// Rewrites the @difficulty line of every block in the questions.txt at path
+// to bank's difficulty (adding one after the question line, or dropping it
+// for 0), through <path>.tmp and a rename. Every other line, and the line
+// endings, stay as they are. Fails without writing if the file's questions
+// are no longer bank's, in the same order.
+bool save_difficulties(const std::string& path, const QuestionBank& bank, std::string* why = nullptr);
+
+// A 32-bit hash of question q's text, option texts and answer key; never 0.
+// Recorded answers carry it, so they can be matched to the question they
+// were given for after questions.txt gains, loses or reorders questions.
+uint32_t question_fingerprint(const QuestionBank& bank, size_t q);
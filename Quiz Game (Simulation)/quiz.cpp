@@ -1,111 +1,29 @@
-// g++ quiz.cpp -o quiz.exe -L"C:\\raylib\\lib" -I"C:\\raylib\\include" -lraylib -lopengl32 -lgdi32 -lwinmm -std=c++17
+// g++ quiz.cpp question_bank.cpp quiz_session.cpp quiz_sim.cpp results_log.cpp question_analytics.cpp text_layout.cpp ../SRMS/profiler.cpp ../SRMS/work_pool.cpp ../SRMS/mapped_file.cpp -o quiz.exe -L"C:\\raylib\\lib" -I"C:\\raylib\\include" -lraylib -lopengl32 -lgdi32 -lwinmm -std=c++17 -pthread
 
 #include "raylib.h"
+#include "question_bank.h"
+#include "quiz_session.h"
+#include "quiz_sim.h"
+#include "question_analytics.h"
+#include "results_log.h"
+#include "text_layout.h"
+#include "../SRMS/profiler.h"
 #include <string>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <algorithm>
-
-// -------------------------
-// Data Structures
-// -------------------------
-struct Question;
-
-struct Option {
-    std::string text;
-    bool correct;
-    Option* next;
-    Option(const std::string &t = "", bool c = false) : text(t), correct(c), next(nullptr) {}
-};
-
-struct Question {
-    int id;
-    std::string text;
-    Option* options;
-    Question* next;
-    Question(int i = 0, const std::string &t = "")
-        : id(i), text(t), options(nullptr), next(nullptr) {}
-};
-
-// -------------------------
-// Linked List Helpers
-// -------------------------
-void addOption(Question* q, const std::string& text, bool correct) {
-    Option* n = new Option(text, correct);
-    if (!q->options) { q->options = n; return; }
-    Option* p = q->options;
-    while (p->next) p = p->next;
-    p->next = n;
-}
-
-void appendQuestion(Question*& head, Question* node) {
-    if (!head) { head = node; return; }
-    Question* t = head;
-    while (t->next) t = t->next;
-    t->next = node;
-}
-
-void freeQuiz(Question* head) {
-    while (head) {
-        Option* o = head->options;
-        while (o) {
-            Option* temp = o;
-            o = o->next;
-            delete temp;
-        }
-        Question* qTemp = head;
-        head = head->next;
-        delete qTemp;
-    }
-}
-
-// -------------------------
-// Load from questions.txt
-// -------------------------
-Question* loadQuestionsFromFile(const std::string& filename) {
-    std::ifstream fin(filename);
-    if (!fin.is_open()) return nullptr;
-
-    std::string line;
-    std::vector<std::string> block;
-    Question* head = nullptr;
-    int idCounter = 1;
-
-    auto flushBlock = [&]() {
-        if (block.empty()) return;
-        Question* q = new Question(idCounter++, block[0]);
-
-        for (size_t i = 1; i < block.size(); i++) {
-            size_t pos = block[i].find('|');
-            if (pos == std::string::npos) continue;
-
-            std::string txt = block[i].substr(0, pos);
-            bool correct = (block[i].substr(pos + 1) == "1");
-            addOption(q, txt, correct);
-        }
-
-        appendQuestion(head, q);
-        block.clear();
-    };
-
-    while (std::getline(fin, line)) {
-        if (!line.empty() && line.back() == '\r') line.pop_back();
-        bool blank = std::all_of(line.begin(), line.end(),
-                                 [](char c){ return isspace((unsigned char)c); });
-        if (blank) flushBlock();
-        else block.push_back(line);
-    }
-    flushBlock();
-
-    return head;
-}
+#include <optional>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
 
 // -------------------------
 // Drawing Helpers
 // -------------------------
-bool DrawRoundedButton(Rectangle rec, const std::string& text) {
+// Line breaks and label widths, measured once per text, size and width
+static TextLayoutCache textCache(MeasureText);
+
+bool DrawRoundedButton(Rectangle rec, const char* text) {
     Vector2 mouse = GetMousePosition();
     bool hover = CheckCollisionPointRec(mouse, rec);
 
@@ -116,60 +34,230 @@ bool DrawRoundedButton(Rectangle rec, const std::string& text) {
     DrawRectangleRoundedLines(rec, 0.15f, 8, border);
 
     int fontSize = std::clamp((int)(rec.height * 0.40f), 22, 32);
-    int w = MeasureText(text.c_str(), fontSize);
-    DrawText(text.c_str(), rec.x + rec.width/2 - w/2,
+    int w = textCache.width(text, fontSize);
+    DrawText(text, rec.x + rec.width/2 - w/2,
              rec.y + rec.height/2 - fontSize/2, fontSize, BLACK);
 
     return hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
 }
 
 // Manual wrapped text (Raylib compatibility)
-void DrawWrappedText(const std::string &text, float x, float y, float maxWidth, int fontSize, Color color) {
-    std::istringstream ss(text);
-    std::string word, line;
-    float offsetY = 0;
-
-    while (ss >> word) {
-        std::string testLine = line.empty() ? word : (line + " " + word);
-        int width = MeasureText(testLine.c_str(), fontSize);
-
-        if (width > maxWidth) {
-            DrawText(line.c_str(), x, y + offsetY, fontSize, color);
-            offsetY += fontSize + 6;
-            line = word;
-        } else {
-            line = testLine;
-        }
-    }
-
-    if (!line.empty())
-        DrawText(line.c_str(), x, y + offsetY, fontSize, color);
+void DrawWrappedText(std::string_view text, float x, float y, float maxWidth, int fontSize, Color color) {
+    PROFILE_SCOPE("DrawWrappedText");
+    const TextLayout& layout = textCache.wrapped(text, fontSize, maxWidth);
+    for (size_t i = 0; i < layout.lineCount(); i++)
+        DrawText(layout.line(i), x, y + i * (fontSize + 6), fontSize, color);
 }
 
 // Centered text
 void DrawCenteredText(const std::string& text, float y, int sw, int size, Color col) {
-    int w = MeasureText(text.c_str(), size);
+    int w = textCache.width(text, size);
     DrawText(text.c_str(), sw/2 - w/2, y, size, col);
 }
 
+// Profiling overlay (F3): frame-time percentiles and per-zone cost
+void DrawProfileOverlay(int fontSize) {
+    std::vector<std::string> lines = profile_overlay_lines();
+    int w = 0;
+    for (const std::string& l : lines) w = std::max(w, MeasureText(l.c_str(), fontSize));
+    int lh = fontSize + 4;
+    int x = GetScreenWidth() - w - 16, y = 8;
+    DrawRectangle(x - 8, y - 4, w + 16, lh * (int)lines.size() + 8, Fade(BLACK, 0.75f));
+    for (size_t i = 0; i < lines.size(); i++)
+        DrawText(lines[i].c_str(), x, y + (int)i * lh, fontSize, i == 0 ? YELLOW : WHITE);
+}
+
+// Top n of a leaderboard, one line each
+void DrawLeaderboard(const char* title, const std::vector<LeaderEntry>* top, float x, float y, int n) {
+    DrawText(title, x, y, 26, DARKBLUE);
+    if (!top || top->empty()) {
+        DrawText("no sessions yet", x, y + 34, 22, GRAY);
+        return;
+    }
+    for (int i = 0; i < n && i < (int)top->size(); i++) {
+        const LeaderEntry& e = (*top)[i];
+        DrawText(TextFormat("%d. %s  %u/%u", i + 1, e.player.c_str(), e.score, e.questions),
+                 x, y + 34 + i * 28, 22, BLACK);
+    }
+}
+
+// EndDrawing() with the overlay on top, then the frame is counted
+void EndFrame(bool showProfile) {
+    if (showProfile) DrawProfileOverlay(20);
+    EndDrawing();
+    profile_frame();
+}
+
 // -------------------------
 // MAIN
 // -------------------------
-int main() {
-    Question* head = loadQuestionsFromFile("questions.txt");
-    if (!head) {
+// quiz.exe [--profile metrics.json] [--trace trace.json] [--headless] [--player NAME]
+// quiz.exe --simulate [--sessions N] [--concurrent N] [--length N (0 = all)]
+//          [--accuracy PCT] [--spread PCT] [--skip PCT] [--threads N] [--seed N]
+// quiz.exe --analyze [--report FILE] [--min-answers N] [--threads N] [--apply]
+// --headless loads the questions without opening a window, prints the
+// metrics and writes the files. --simulate plays the quiz headlessly for
+// many players at once and prints throughput and the score distribution.
+// --analyze reads results.log, writes per-question statistics to
+// item_report.csv and prints the questions to look at; --apply also writes
+// the measured difficulties into questions.txt's @difficulty lines.
+// Finished sessions go to results.log under --player, or the login name,
+// and their answers adjust question difficulty for the adaptive order.
+int main(int argc, char** argv) {
+    ProfileArgs profileArgs = profile_parse_args(argc, argv);
+    bool headless = argc > 1 && std::string(argv[1]) == "--headless";
+    bool simulate = argc > 1 && std::string(argv[1]) == "--simulate";
+    bool analyze = argc > 1 && std::string(argv[1]) == "--analyze";
+
+    QuestionBank bank;
+    if (!load_questions("questions.txt", bank) || bank.empty()) {
         std::cout << "Could not open questions.txt\n";
         return 1;
     }
+    if (simulate) {
+        SimOptions sim;
+        for (int i = 2; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            char* end = nullptr;
+            long long v = std::strtoll(argv[i + 1], &end, 10);
+            if (end == argv[i + 1] || *end || v < 0) {
+                std::cout << flag << " takes a whole number, 0 or more\n";
+                return 1;
+            }
+            if (flag == "--length" && v > UINT16_MAX) {
+                std::cout << "--length is at most " << UINT16_MAX << " (0 = every eligible question)\n";
+                return 1;
+            }
+            if (flag == "--sessions") sim.sessions = (size_t)v;
+            else if (flag == "--concurrent") sim.concurrent = (size_t)v;
+            else if (flag == "--length") sim.length = (unsigned)v;
+            else if (flag == "--accuracy") sim.accuracy = (int)v;
+            else if (flag == "--spread") sim.accuracySpread = (int)v;
+            else if (flag == "--skip") sim.skipRate = (int)v;
+            else if (flag == "--threads") sim.threads = (unsigned)v;
+            else if (flag == "--seed") sim.seed = (uint64_t)v;
+            else {
+                std::cout << "Unknown option " << flag << "\n";
+                return 1;
+            }
+        }
+        SimResult result;
+        std::string why;
+        if (!run_simulation(bank, sim, result, &why)) {
+            std::cout << why << "\n";
+            return 1;
+        }
+        for (const std::string& line : simulation_report(result)) std::cout << line << "\n";
+        if (!profile_write(profileArgs, &why)) std::cout << why << "\n";
+        return 0;
+    }
+    if (analyze) {
+        std::string report = "item_report.csv";
+        uint64_t minAnswers = 30;
+        unsigned threads = 0;
+        bool apply = false;
+        for (int i = 2; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--apply") apply = true;
+            else if (flag == "--report" && i + 1 < argc) report = argv[++i];
+            else if (flag == "--min-answers" && i + 1 < argc) minAnswers = (uint64_t)std::atoll(argv[++i]);
+            else if (flag == "--threads" && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+            else {
+                std::cout << "Unknown option " << flag << "\n";
+                return 1;
+            }
+        }
+        QuestionAnalytics analytics(bank);
+        size_t sessions = analytics.recompute("results.log", threads);
+        const AnswerColumns& c = analytics.columns();
+        std::cout << sessions << " sessions, " << c.answers << " answers";
+        if (c.moved) std::cout << ", " << c.moved << " to questions that have moved in questions.txt";
+        if (c.unmatched) std::cout << "; " << c.unmatched << " left out (their question changed or is gone, or they predate fingerprints)";
+        std::cout << "\n";
+
+        // Hardest first, among questions with enough answers; and any whose
+        // right answers come from the weaker players.
+        std::vector<size_t> measured;
+        for (size_t q = 0; q < bank.size(); ++q)
+            if (analytics.answered(q) >= std::max<uint64_t>(minAnswers, 1)) measured.push_back(q);
+        std::sort(measured.begin(), measured.end(), [&](size_t a, size_t b) { return analytics.pValue(a) < analytics.pValue(b); });
+        std::cout << measured.size() << " questions with at least " << minAnswers << " answers\n";
+        char line[200];
+        for (size_t i = 0; i < measured.size() && i < 10; ++i) {
+            size_t q = measured[i];
+            snprintf(line, sizeof line, "  #%zu  p %.2f  discrimination %+.2f  %.1f s  %.60s", q + 1, analytics.pValue(q),
+                     analytics.discrimination(q), analytics.meanSeconds(q), std::string(bank.text(q)).c_str());
+            std::cout << line << "\n";
+        }
+        for (size_t q : measured) {
+            if (analytics.discrimination(q) >= 0) continue;
+            snprintf(line, sizeof line, "  #%zu has negative discrimination (%+.2f): check its answer key", q + 1,
+                     analytics.discrimination(q));
+            std::cout << line << "\n";
+        }
+
+        std::string why;
+        if (!analytics.writeReport(report, &why)) {
+            std::cout << why << "\n";
+            return 1;
+        }
+        std::cout << "Wrote " << report << "\n";
+        if (apply) {
+            size_t changed = analytics.applyDifficulty(bank, minAnswers);
+            if (changed && !save_difficulties("questions.txt", bank, &why)) {
+                std::cout << why << "\n";
+                return 1;
+            }
+            std::cout << changed << " difficulties changed in questions.txt\n";
+        }
+        if (!profile_write(profileArgs, &why)) std::cout << why << "\n";
+        return 0;
+    }
+    if (headless) {
+        for (const std::string& line : profile_overlay_lines()) std::cout << line << "\n";
+        std::string why;
+        bool ok = profile_write(profileArgs, &why);
+        if (!ok) std::cout << why << "\n";
+        return ok ? 0 : 1;
+    }
+
+    std::string player;
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == "--player") player = argv[i + 1];
+    if (player.empty()) {
+        const char* login = std::getenv("USERNAME");
+        if (!login) login = std::getenv("USER");
+        player = login ? login : "Player";
+    }
+    ResultsLog results("results.log");
+    std::string logWhy;
+    if (!results.open(&logWhy)) std::cout << logWhy << " (scores will not be saved)\n";
+    // Difficulty as measured so far, kept current as sessions finish.
+    QuestionAnalytics analytics(bank);
+    analytics.update("results.log");
+    analytics.applyDifficulty(bank);
 
     InitWindow(1400, 900, "Quiz Engine");
     SetTargetFPS(60);
 
     bool inMenu = true;
-    Question* current = head;
-    int score = 0;
+    SessionOptions sessionOpt;
+    QuestionStats stats;   // answers so far, for the adaptive order
+    std::optional<QuizSession> session;
+    SessionResult record;   // answers of the session in progress
+    double shownAt = 0;     // when the current question appeared
+    bool showProfile = false;
+
+    auto startSession = [&]() {
+        session.emplace(bank, sessionOpt, &stats);
+        record = SessionResult();
+        record.player = player;
+        if (sessionOpt.topic >= 0) record.topic = sessionOpt.topic == 0 ? "Untagged" : bank.topicName(sessionOpt.topic);
+        shownAt = GetTime();
+    };
 
     while (!WindowShouldClose()) {
+        if (IsKeyPressed(KEY_F3)) showProfile = !showProfile;
         BeginDrawing();
         ClearBackground(Color{182,215,255,255});
 
@@ -183,35 +271,51 @@ int main() {
             Rectangle startBtn = { float(sw/2 - 160), float(sh/2 - 40), 320, 90 };
             if (DrawRoundedButton(startBtn, "Start Quiz")) {
                 inMenu = false;
-                current = head;
-                score = 0;
+                startSession();
+            }
+
+            // Order and topic cycle on each click
+            Rectangle orderBtn = { float(sw/2 - 160), float(sh/2 + 80), 320, 70 };
+            std::string orderText = std::string("Order: ") + session_order_name(sessionOpt.order);
+            if (DrawRoundedButton(orderBtn, orderText.c_str()))
+                sessionOpt.order = SessionOrder(((int)sessionOpt.order + 1) % 4);
+
+            if (bank.topicCount() > 1) {
+                Rectangle topicBtn = { float(sw/2 - 160), float(sh/2 + 170), 320, 70 };
+                std::string topicText = "Topic: " + (sessionOpt.topic < 0 ? std::string("All") :
+                                        sessionOpt.topic == 0 ? std::string("Untagged") : bank.topicName(sessionOpt.topic));
+                if (DrawRoundedButton(topicBtn, topicText.c_str()))
+                    sessionOpt.topic = sessionOpt.topic + 1 < (int)bank.topicCount() ? sessionOpt.topic + 1 : -1;
             }
 
-            EndDrawing();
+            EndFrame(showProfile);
             continue;
         }
 
         // ---------------- END SCREEN ----------------
-        if (!current) {
+        if (session->finished()) {
             DrawCenteredText("Quiz Finished!", sh * 0.18f, sw, 72, BLACK);
-            DrawCenteredText("Score: " + std::to_string(score),
+            DrawCenteredText("Score: " + std::to_string(session->score()),
                               sh * 0.35f, sw, 62, DARKGREEN);
 
+            DrawLeaderboard("All-time best", &results.allTime(), 40, sh * 0.30f, 5);
+            DrawLeaderboard("Today", results.day(std::time(nullptr) / 86400), sw - 360, sh * 0.30f, 5);
+
             Rectangle restart = { float(sw/2 - 160), float(sh*0.60f), 320, 90 };
             if (DrawRoundedButton(restart, "Restart")) {
-                current = head;
-                score = 0;
+                startSession();
             }
 
             Rectangle quit = { float(sw/2 - 160), float(sh*0.75f), 320, 90 };
             if (DrawRoundedButton(quit, "Quit")) break;
 
-            EndDrawing();
+            EndFrame(showProfile);
             continue;
         }
 
         // ---------------- QUIZ PAGE ----------------
-        DrawWrappedText(current->text, sw*0.08f, 50, sw*0.84f, 40, BLACK);
+        size_t shown = session->question();
+        DrawWrappedText(bank.text(shown), sw*0.08f, 50, sw*0.84f, 40, BLACK);
 
         float x = sw*0.08f;
         float y = 200;
@@ -219,29 +323,52 @@ int main() {
         float h = 80;
         float gap = 30;
 
-        for (Option* o = current->options; o; o = o->next) {
+        // Options in the session's shuffled order; the click is applied
+        // after drawing, since answering moves the session on
+        size_t picked = SIZE_MAX;
+        for (size_t k = 0; k < session->optionCount(); k++) {
             Rectangle r = {x, y, w, h};
-            if (DrawRoundedButton(r, o->text)) {
-                if (o->correct) score++;
-                current = current->next;
-            }
+            if (DrawRoundedButton(r, bank.optionText(shown, session->option(k)).data()) && picked == SIZE_MAX)
+                picked = k;
             y += h + gap;
         }
 
         // SKIP BUTTON
         Rectangle skipBtn = { float(sw - 240), float(sh - 120), 200, 70 };
-        if (DrawRoundedButton(skipBtn, "Skip")) {
-            current = current->next;
-        }
+        bool skipped = DrawRoundedButton(skipBtn, "Skip");
 
         // SCORE BOTTOM-LEFT
-        DrawText(TextFormat("Score: %d", score),
+        DrawText(TextFormat("Score: %d", (int)session->score()),
                  20, sh - 50, 32, DARKGREEN);
 
-        EndDrawing();
+        if (picked != SIZE_MAX || skipped) {
+            SessionResult::Answer a;
+            a.question = (uint32_t)shown;
+            a.fingerprint = question_fingerprint(bank, shown);
+            a.tenths = (uint16_t)std::min((GetTime() - shownAt) * 10, 65535.0);
+            if (picked != SIZE_MAX) {
+                a.choice = (uint8_t)std::min<size_t>(session->option(picked), 254);
+                a.correct = session->answer(picked);
+            } else {
+                session->skip();
+            }
+            record.answers.push_back(a);
+            shownAt = GetTime();
+            if (session->finished()) {
+                record.time = std::time(nullptr);
+                record.score = (uint32_t)session->score();
+                if (!results.append(record)) std::cout << "Could not save the result to results.log\n";
+                results.maybeCompact();
+                analytics.add(record);
+                analytics.applyDifficulty(bank);
+            }
+        }
+
+        EndFrame(showProfile);
     }
 
-    freeQuiz(head);
+    std::string why;
+    if (!profile_write(profileArgs, &why)) std::cout << why << "\n";
     CloseWindow();
     return 0;
 }
@@ -0,0 +1,860 @@
+// Compile: g++ -O3 -march=native quiz_bench.cpp question_bank.cpp quiz_session.cpp quiz_sim.cpp results_log.cpp question_analytics.cpp text_layout.cpp ../SRMS/profiler.cpp ../SRMS/work_pool.cpp ../SRMS/mapped_file.cpp -o quiz_bench -std=c++17 -pthread
+// Usage:   quiz_bench [scenario]   (no argument runs every scenario)
+
+#include "question_analytics.h"
+#include "question_bank.h"
+#include "quiz_session.h"
+#include "quiz_sim.h"
+#include "results_log.h"
+#include "text_layout.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------- Helpers ----------
+// Counts every heap allocation so scenarios can report allocations and
+// bytes per question. Kept out of line so GCC doesn't pair inlined
+// malloc/free with new/delete.
+static std::atomic<size_t> g_allocs{0};
+static std::atomic<size_t> g_allocBytes{0};
+
+__attribute__((noinline)) void* operator new(size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+static double now_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string temp_path(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// n questions of 40-120 characters with 2-6 options each, one correct;
+// every seventh block has CRLF line ends and some gaps have stray spaces,
+// as hand-edited files do.
+static void write_question_file(const std::string& path, size_t n, unsigned seed) {
+    static const char* const words[] = {"which", "data", "structure", "stack", "queue", "pointer", "memory", "sorted",
+                                        "array", "linked", "list", "tree", "graph", "hash", "table", "order"};
+    std::mt19937 rng(seed);
+    std::ofstream f(path, std::ios::binary);
+    std::string block;
+    for (size_t q = 0; q < n; ++q) {
+        const char* eol = q % 7 == 0 ? "\r\n" : "\n";
+        block = "Q" + std::to_string(q + 1) + ":";
+        size_t len = 40 + rng() % 81;
+        while (block.size() < len) { block += ' '; block += words[rng() % 16]; }
+        block += "?";
+        block += eol;
+        int options = 2 + (int)(rng() % 5), correct = (int)(rng() % options);
+        for (int k = 0; k < options; ++k) {
+            block += words[rng() % 16];
+            block += ' ';
+            block += words[rng() % 16];
+            block += k == correct ? "|1" : "|0";
+            block += eol;
+        }
+        block += q % 11 == 0 ? "  \n" : "\n";
+        f << block;
+    }
+}
+
+// ---------- Old Linked Lists ----------
+// The node lists quiz.cpp used before the QuestionBank, kept to measure
+// against. tailAppend = false is the old loader exactly (walk to the tail on
+// every append); true keeps a tail pointer, to separate the quadratic walk
+// from the cost of the nodes themselves.
+namespace lists {
+struct Option {
+    std::string text;
+    bool correct;
+    Option* next;
+    Option(const std::string& t = "", bool c = false) : text(t), correct(c), next(nullptr) {}
+};
+
+struct Question {
+    int id;
+    std::string text;
+    Option* options;
+    Question* next;
+    Question(int i = 0, const std::string& t = "") : id(i), text(t), options(nullptr), next(nullptr) {}
+};
+
+static void addOption(Question* q, const std::string& text, bool correct) {
+    Option* n = new Option(text, correct);
+    if (!q->options) { q->options = n; return; }
+    Option* p = q->options;
+    while (p->next) p = p->next;
+    p->next = n;
+}
+
+static void freeQuiz(Question* head) {
+    while (head) {
+        Option* o = head->options;
+        while (o) {
+            Option* temp = o;
+            o = o->next;
+            delete temp;
+        }
+        Question* qTemp = head;
+        head = head->next;
+        delete qTemp;
+    }
+}
+
+static Question* loadQuestionsFromFile(const std::string& filename, bool tailAppend) {
+    std::ifstream fin(filename);
+    if (!fin.is_open()) return nullptr;
+    std::string line;
+    std::vector<std::string> block;
+    Question* head = nullptr;
+    Question* tail = nullptr;
+    int idCounter = 1;
+    auto flushBlock = [&]() {
+        if (block.empty()) return;
+        Question* q = new Question(idCounter++, block[0]);
+        for (size_t i = 1; i < block.size(); i++) {
+            size_t pos = block[i].find('|');
+            if (pos == std::string::npos) continue;
+            addOption(q, block[i].substr(0, pos), block[i].substr(pos + 1) == "1");
+        }
+        if (!head) head = q;
+        else if (tailAppend) tail->next = q;
+        else {
+            Question* t = head;
+            while (t->next) t = t->next;
+            t->next = q;
+        }
+        tail = q;
+        block.clear();
+    };
+    while (std::getline(fin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        bool blank = std::all_of(line.begin(), line.end(), [](char c) { return isspace((unsigned char)c); });
+        if (blank) flushBlock();
+        else block.push_back(line);
+    }
+    flushBlock();
+    return head;
+}
+}  // namespace lists
+
+static bool same_content(lists::Question* head, const QuestionBank& bank) {
+    size_t q = 0;
+    for (lists::Question* p = head; p; p = p->next, ++q) {
+        if (q >= bank.size() || p->text != bank.text(q)) return false;
+        size_t k = 0;
+        for (lists::Option* o = p->options; o; o = o->next, ++k)
+            if (k >= bank.optionCount(q) || o->text != bank.optionText(q, k) || o->correct != bank.isCorrect(q, k)) return false;
+        if (k != bank.optionCount(q)) return false;
+    }
+    return q == bank.size();
+}
+
+// ---------- Scenario: bank ----------
+// Loading, memory, traversal and freeing: the old lists vs the QuestionBank.
+static void bench_bank() {
+    printf("[bank] 1M-question bank vs the old linked lists\n");
+    const size_t n = 1000000;
+    std::string path = temp_path("quiz_bench_bank.txt");
+    write_question_file(path, n, 7);
+    double mb = std::filesystem::file_size(path) / 1e6;
+    printf("  questions.txt        %zu questions, %.1f MB\n", n, mb);
+
+    // The old loader walks the whole list per question: too slow for 1M, so
+    // it runs on prefixes and the 1M time is extrapolated from the largest.
+    double walkSec = 0;
+    size_t walkN = 0;
+    for (size_t m : {5000, 10000, 20000}) {
+        std::string small = temp_path("quiz_bench_small.txt");
+        write_question_file(small, m, 7);
+        double t = now_sec();
+        lists::Question* head = lists::loadQuestionsFromFile(small, false);
+        walkSec = now_sec() - t;
+        walkN = m;
+        printf("  lists, tail walk     N=%-8zu %9.1f ms\n", m, walkSec * 1e3);
+        if (m == 20000) {
+            QuestionBank check;
+            load_questions(small, check);
+            printf("  same questions and options as the bank: %s\n", same_content(head, check) ? "yes" : "NO");
+        }
+        lists::freeQuiz(head);
+        std::filesystem::remove(small);
+    }
+    printf("  lists, tail walk     N=%-8zu %9.1f h   (extrapolated, quadratic)\n", n, walkSec * (double)n / walkN * (double)n / walkN / 3600);
+
+    size_t allocs0 = g_allocs, bytes0 = g_allocBytes;
+    double t = now_sec();
+    lists::Question* head = lists::loadQuestionsFromFile(path, true);
+    double listSec = now_sec() - t;
+    size_t listAllocs = g_allocs - allocs0, listBytes = g_allocBytes - bytes0;
+
+    QuestionBank bank;
+    allocs0 = g_allocs;
+    t = now_sec();
+    load_questions(path, bank);
+    double bankSec = now_sec() - t;
+    size_t bankAllocs = g_allocs - allocs0;
+    printf("  lists, tail pointer  N=%-8zu %9.1f ms %8.1f MB/s\n", n, listSec * 1e3, mb / listSec);
+    printf("  QuestionBank         N=%-8zu %9.1f ms %8.1f MB/s\n", n, bankSec * 1e3, mb / bankSec);
+    // Requested bytes: malloc adds roughly 16 more per allocation on top.
+    printf("  memory, lists        %7.1f MB in %zu allocations (%.0f B/question + malloc headers)\n", listBytes / 1e6, listAllocs,
+           (double)listBytes / n);
+    printf("  memory, bank         %7.1f MB in %zu allocations (%.0f B/question, file is %.0f B/question)\n", bank.bytes() / 1e6,
+           bankAllocs, (double)bank.bytes() / n, mb * 1e6 / n);
+
+    // One pass over every option, as a score or analytics pass would make.
+    t = now_sec();
+    size_t correct = 0, chars = 0;
+    for (lists::Question* p = head; p; p = p->next)
+        for (lists::Option* o = p->options; o; o = o->next) {
+            correct += o->correct;
+            chars += o->text.size();
+        }
+    double listWalk = now_sec() - t;
+    t = now_sec();
+    size_t correct2 = 0, chars2 = 0;
+    for (size_t q = 0; q < bank.size(); ++q)
+        for (size_t k = 0; k < bank.optionCount(q); ++k) {
+            correct2 += bank.isCorrect(q, k);
+            chars2 += bank.option(q, k).textLen;
+        }
+    double bankWalk = now_sec() - t;
+    printf("  traverse, lists      %9.1f ms\n", listWalk * 1e3);
+    printf("  traverse, bank       %9.1f ms   (%s)\n", bankWalk * 1e3, correct == correct2 && chars == chars2 ? "same totals" : "DIFFER");
+
+    t = now_sec();
+    lists::freeQuiz(head);
+    double listFree = now_sec() - t;
+    t = now_sec();
+    bank.clear();
+    printf("  free, freeQuiz       %9.1f ms\n", listFree * 1e3);
+    printf("  free, bank.clear()   %9.1f ms\n", (now_sec() - t) * 1e3);
+    std::filesystem::remove(path);
+}
+
+// ---------- Scenario: load ----------
+// Startup parse of a 1M-question file: the old getline loader, the
+// read-then-parse loader the bank first had, and the memory-mapped parallel
+// loader at several thread counts. Best of three runs, page cache warm.
+static void bench_load() {
+    printf("[load] questions.txt, 1M questions\n");
+    const size_t n = 1000000;
+    std::string path = temp_path("quiz_bench_load.txt");
+    write_question_file(path, n, 11);
+    double gb = std::filesystem::file_size(path) / 1e9;
+    auto best = [](const std::function<double()>& run) {
+        double b = 1e30;
+        for (int i = 0; i < 3; ++i) b = std::min(b, run());
+        return b;
+    };
+
+    double sec = best([&] {
+        double t = now_sec();
+        lists::Question* head = lists::loadQuestionsFromFile(path, true);
+        t = now_sec() - t;
+        lists::freeQuiz(head);
+        return t;
+    });
+    printf("  getline + lists       %8.1f ms %7.2f GB/s\n", sec * 1e3, gb / sec);
+
+    QuestionBank ref;
+    sec = best([&] {
+        double t = now_sec();
+        std::ifstream fin(path, std::ios::binary);
+        std::string data((size_t)std::filesystem::file_size(path), '\0');
+        fin.read(&data[0], (std::streamsize)data.size());
+        ref.clear();
+        parse_questions(data.data(), data.size(), ref);
+        return now_sec() - t;
+    });
+    printf("  read + parse          %8.1f ms %7.2f GB/s\n", sec * 1e3, gb / sec);
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts = {1, 2, 4};
+    if (hw > 4) counts.push_back(hw);
+    QuestionBank bank;
+    for (unsigned th : counts) {
+        QuestionLoadOptions opt;
+        opt.threads = th;
+        QuestionLoadStats st, bestSt;
+        sec = best([&] {
+            double t = now_sec();
+            load_questions(path, bank, opt, &st);
+            t = now_sec() - t;
+            if (bestSt.chunks == 0 || t < bestSt.mapSec + bestSt.parseSec + bestSt.mergeSec) bestSt = st;
+            return t;
+        });
+        printf("  mmap, threads=%-3u     %8.1f ms %7.2f GB/s  (%zu chunks: parse %.1f ms, merge %.1f ms)\n", th, sec * 1e3, gb / sec,
+               bestSt.chunks, bestSt.parseSec * 1e3, bestSt.mergeSec * 1e3);
+    }
+    bool same = bank.size() == ref.size() && bank.totalOptions() == ref.totalOptions();
+    for (size_t q = 0; same && q < bank.size(); ++q) {
+        same = bank.text(q) == ref.text(q) && bank.optionCount(q) == ref.optionCount(q);
+        for (size_t k = 0; same && k < bank.optionCount(q); ++k)
+            same = bank.optionText(q, k) == ref.optionText(q, k) && bank.isCorrect(q, k) == ref.isCorrect(q, k);
+    }
+    printf("  (%u hardware threads)  %zu questions, parallel result %s, bank %.1f MB\n", hw, bank.size(),
+           same ? "identical to serial" : "DIFFERS", bank.bytes() / 1e6);
+    std::filesystem::remove(path);
+}
+
+// ---------- Scenario: layout ----------
+// Stands in for raylib's MeasureText on the default font: a walk over the
+// glyphs summing scaled advances, plus letter spacing of fontSize / 10.
+static int bench_measure(const char* text, int fontSize) {
+    static const unsigned char adv[128] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        4, 1, 3, 5, 5, 7, 6, 1, 3, 3, 5, 5, 2, 4, 1, 4, 5, 3, 5, 5, 5, 5, 5, 5, 5, 5, 1, 2, 4, 4, 4, 5,
+        7, 5, 5, 5, 5, 5, 5, 5, 5, 1, 5, 5, 5, 7, 5, 5, 5, 5, 5, 5, 5, 5, 5, 7, 5, 5, 5, 2, 4, 2, 5, 5,
+        2, 5, 5, 5, 5, 5, 4, 5, 5, 1, 3, 4, 2, 7, 5, 5, 5, 5, 4, 5, 3, 5, 5, 7, 5, 5, 5, 3, 1, 3, 6, 0};
+    float scale = fontSize / 10.0f;
+    int spacing = fontSize / 10;
+    float w = 0;
+    int n = 0;
+    for (const char* p = text; *p; ++p, ++n) w += adv[(unsigned char)*p & 127] * scale;
+    return n ? (int)(w + (n - 1) * spacing) : 0;
+}
+
+// DrawWrappedText before the cache; lines are collected instead of drawn.
+static void old_wrap(std::string_view text, float maxWidth, int fontSize, std::vector<std::string>& lines) {
+    lines.clear();
+    std::istringstream ss{std::string(text)};
+    std::string word, line;
+    while (ss >> word) {
+        std::string testLine = line.empty() ? word : (line + " " + word);
+        int width = bench_measure(testLine.c_str(), fontSize);
+        if (width > maxWidth) {
+            lines.push_back(line);
+            line = word;
+        } else {
+            line = testLine;
+        }
+    }
+    if (!line.empty()) lines.push_back(line);
+}
+
+// Per-frame text cost of the quiz page: the question wrapped at 84% of a
+// 1400 px window and six option labels measured for centering.
+static void bench_layout() {
+    printf("[layout] quiz page text per frame, old wrap vs TextLayoutCache\n");
+    static const char* const words[] = {"the", "algorithm", "visits", "each", "node", "once,", "so", "its", "running",
+                                        "time", "grows", "linearly", "with", "input", "size", "(n)."};
+    std::mt19937 rng(5);
+    std::vector<std::string> labels;
+    for (int k = 0; k < 6; ++k) labels.push_back(std::string(words[rng() % 16]) + " " + words[rng() % 16]);
+    const float maxWidth = 1400 * 0.84f;
+    const int fontSize = 40, labelSize = 32;
+
+    for (size_t chars : {100, 600, 2500}) {
+        std::string text;
+        while (text.size() < chars) { if (!text.empty()) text += ' '; text += words[rng() % 16]; }
+
+        std::vector<std::string> lines;
+        const int oldFrames = chars > 1000 ? 200 : 2000;
+        double t = now_sec();
+        size_t sink = 0;
+        for (int f = 0; f < oldFrames; ++f) {
+            old_wrap(text, maxWidth, fontSize, lines);
+            for (const std::string& l : labels) sink += bench_measure(l.c_str(), labelSize);
+        }
+        double oldUs = (now_sec() - t) / oldFrames * 1e6;
+
+        TextLayoutCache cache(bench_measure);
+        const int frames = 200000;
+        size_t allocs0 = 0;
+        t = now_sec();
+        for (int f = 0; f < frames; ++f) {
+            if (f == 1) allocs0 = g_allocs;
+            const TextLayout& layout = cache.wrapped(text, fontSize, maxWidth);
+            sink += layout.lineCount();
+            for (const std::string& l : labels) sink += cache.width(l, labelSize);
+        }
+        double newUs = (now_sec() - t) / frames * 1e6;
+        size_t steadyAllocs = g_allocs - allocs0;
+
+        const TextLayout& layout = cache.wrapped(text, fontSize, maxWidth);
+        bool same = layout.lineCount() == lines.size();
+        for (size_t i = 0; same && i < lines.size(); ++i) same = lines[i] == layout.line(i);
+        t = now_sec();
+        TextLayout fresh;
+        for (int f = 0; f < 1000; ++f) layout_text(text, fontSize, maxWidth, bench_measure, fresh);
+        double missUs = (now_sec() - t) / 1000 * 1e6;
+
+        printf("  %4zu chars, %2zu lines  old %9.2f us/frame   cached %6.3f us/frame (%zu allocs)   relayout %7.2f us   %s\n",
+               chars, lines.size(), oldUs, newUs, steadyAllocs, missUs, same ? "same lines" : "LINES DIFFER");
+        if (sink == 42) printf(" ");
+    }
+}
+
+// ---------- Scenario: session ----------
+// n short questions over eight topics, difficulties 0-5 and 2-4 options.
+static void build_tagged_bank(QuestionBank& bank, size_t n) {
+    bank.reserve(n, 4 * n, 24 * n);
+    std::mt19937 rng(3);
+    const char* topics[] = {"arrays", "lists", "stacks", "queues", "trees", "graphs", "hashing", "sorting"};
+    for (size_t q = 0; q < n; ++q) {
+        bank.addQuestion("Q" + std::to_string(q));
+        bank.setTopic(topics[rng() % 8]);
+        bank.setDifficulty((int)(rng() % 6));
+        int options = 2 + (int)(rng() % 3), correct = (int)(rng() % options);
+        for (int k = 0; k < options; ++k) bank.addOption("opt", k == correct);
+    }
+}
+
+// Session start-up and per-question cost over a 2M-question bank with eight
+// topics and mixed difficulties, plus checks on what the orders draw.
+static void bench_session() {
+    printf("[session] 2M-question bank, 1M questions per session\n");
+    const size_t n = 2000000;
+    QuestionBank bank;
+    build_tagged_bank(bank, n);
+
+    for (SessionOrder order : {SessionOrder::InOrder, SessionOrder::Shuffled, SessionOrder::Weighted, SessionOrder::Adaptive}) {
+        SessionOptions opt;
+        opt.order = order;
+        opt.seed = 9;
+        opt.length = 1000000;
+        QuestionStats stats;
+        double t = now_sec();
+        QuizSession session(bank, opt, &stats);
+        double startSec = now_sec() - t;
+        size_t slot = 0;
+        t = now_sec();
+        while (!session.finished()) session.answer(slot++ % 2);
+        double runSec = now_sec() - t;
+        printf("  %-9s start %7.1f ms   %6.1f ns/question   %zu asked, %4.1f%% right\n", session_order_name(order), startSec * 1e3,
+               runSec / session.asked() * 1e9, session.asked(), 100.0 * session.score() / session.asked());
+    }
+
+    // Shuffled: every eligible question once, none twice.
+    SessionOptions opt;
+    opt.seed = 4;
+    opt.topic = bank.findTopic("trees");
+    opt.minDifficulty = 2;
+    opt.maxDifficulty = 4;
+    QuizSession shuffled(bank, opt);
+    std::vector<bool> seen(n);
+    bool ok = true;
+    size_t count = 0;
+    for (; !shuffled.finished(); ++count) {
+        size_t q = shuffled.question();
+        ok = ok && !seen[q] && bank.topic(q) == opt.topic && bank.difficulty(q) >= 2 && bank.difficulty(q) <= 4;
+        seen[q] = true;
+        shuffled.skip();
+    }
+    printf("  shuffled, trees at difficulty 2-4: %zu of %zu eligible drawn, %s\n", count, shuffled.eligible(),
+           ok && count == shuffled.eligible() ? "each once and all matching" : "WRONG");
+
+    // Weighted: the first 20k draws (1% of the bank, so hardly any
+    // depletion) per difficulty against the weights.
+    SessionOptions wopt;
+    wopt.order = SessionOrder::Weighted;
+    wopt.seed = 5;
+    wopt.length = 20000;
+    double weights[6] = {1, 1, 2, 4, 8, 16};
+    std::copy(weights, weights + 6, wopt.difficultyWeight);
+    QuizSession weighted(bank, wopt);
+    size_t byDiff[6] = {0};
+    for (; !weighted.finished(); weighted.skip()) byDiff[bank.difficulty(weighted.question())]++;
+    size_t qByDiff[6] = {0};
+    for (size_t q = 0; q < n; ++q) qByDiff[bank.difficulty(q)]++;
+    double total = 0;
+    for (int d = 0; d < 6; ++d) total += weights[d] * qByDiff[d];
+    printf("  weighted, 20k draws by difficulty (expected):");
+    for (int d = 0; d < 6; ++d) printf(" %.2f%% (%.2f%%)", 100.0 * byDiff[d] / wopt.length, 100.0 * weights[d] * qByDiff[d] / total);
+    printf("\n");
+
+    // Weighted with no length: every eligible question once, none twice.
+    wopt.length = 0;
+    wopt.topic = opt.topic;
+    QuizSession whole(bank, wopt);
+    std::fill(seen.begin(), seen.end(), false);
+    ok = true;
+    count = 0;
+    for (; !whole.finished(); ++count) {
+        size_t q = whole.question();
+        ok = ok && !seen[q] && bank.topic(q) == wopt.topic;
+        seen[q] = true;
+        whole.skip();
+    }
+    printf("  weighted, trees, no length: %zu of %zu eligible drawn, %s\n", count, whole.eligible(),
+           ok && count == whole.eligible() ? "each once" : "WRONG");
+
+    // The draw a sum tree replaces: a scan of the cumulative weights.
+    std::vector<double> w(n);
+    for (size_t q = 0; q < n; ++q) w[q] = weights[bank.difficulty(q)];
+    WeightedDraw tree;
+    double t = now_sec();
+    tree.build(w);
+    double buildSec = now_sec() - t;
+    std::mt19937_64 r(1);
+    size_t sink = 0;
+    t = now_sec();
+    for (int i = 0; i < 200; ++i) {
+        double x = std::uniform_real_distribution<double>(0, total)(r), acc = 0;
+        size_t q = 0;
+        while (q + 1 < n && (acc += w[q]) <= x) ++q;
+        sink += q;
+    }
+    double scanNs = (now_sec() - t) / 200 * 1e9;
+    t = now_sec();
+    for (int i = 0; i < 1000000; ++i) sink += tree.take(r);
+    double treeNs = (now_sec() - t) / 1000000 * 1e9;
+    printf("  weighted draw: linear scan %.0f ns, sum tree %.1f ns with removal (built in %.1f ms)%s\n", scanNs, treeNs,
+           buildSec * 1e3, sink == 42 ? " " : "");
+}
+
+// ---------- Scenario: simulate ----------
+// 10M players in progress at once over a 1M-question bank, then many more
+// sessions through fewer slots.
+static void bench_simulate() {
+    printf("[simulate] headless sessions, 1M-question bank, %u hardware threads\n", std::max(1u, std::thread::hardware_concurrency()));
+    QuestionBank bank;
+    build_tagged_bank(bank, 1000000);
+    struct Run { size_t sessions, concurrent; };
+    for (Run run : {Run{10000000, 10000000}, Run{20000000, 1000000}}) {
+        SimOptions opt;
+        opt.sessions = run.sessions;
+        opt.concurrent = run.concurrent;
+        SimResult result;
+        size_t allocBytes0 = g_allocBytes;
+        run_simulation(bank, opt, result);
+        printf("  %zuM sessions, %zuM concurrent, %.1f MB allocated\n", run.sessions / 1000000, run.concurrent / 1000000,
+               (g_allocBytes - allocBytes0) / 1e6);
+        std::vector<std::string> lines = simulation_report(result);
+        for (size_t i = 0; i < 4; ++i) printf("    %s\n", lines[i].c_str());
+    }
+    // length 0 plays every eligible question.
+    QuestionBank small;
+    build_tagged_bank(small, 1000);
+    SimOptions whole;
+    whole.length = 0;
+    whole.sessions = 10000;
+    whole.concurrent = 1000;
+    SimResult result;
+    bool ok = run_simulation(small, whole, result);
+    printf("  length 0 on a 1000-question bank: %s (%zu questions per session, %llu sessions)\n",
+           ok && result.length == 1000 && result.sessions == whole.sessions ? "every question" : "WRONG", result.length,
+           (unsigned long long)result.sessions);
+}
+
+// ---------- Scenario: results ----------
+// 2M finished 20-question sessions appended to a results log over 30 days,
+// with background compaction at the default 64 MB; top-100 reads as the log
+// grows; reopening from the boards file against a full rescan.
+static void bench_results() {
+    printf("[results] 2M sessions into results.log\n");
+    std::string dir = temp_path("quiz_bench_results");
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/results.log";
+    const size_t n = 2000000;
+    const char* topics[] = {"", "arrays", "trees", "graphs"};
+    std::mt19937 rng(8);
+
+    size_t compactions = 0;
+    double appendSec = 0, readNs = 0;
+    uint64_t checksum = 0;
+    {
+        ResultsLog log(path);
+        log.open();
+        SessionResult r;
+        r.answers.resize(20);
+        for (size_t i = 1; i <= n; ++i) {
+            r.player = "player" + std::to_string(rng() % 100000);
+            r.topic = topics[rng() % 4];
+            r.time = 1760000000 + (int64_t)(i * 30 * 86400 / n);
+            r.score = 0;
+            for (SessionResult::Answer& a : r.answers) {
+                a.question = rng() % 1000000;
+                a.tenths = (uint16_t)(rng() % 600);
+                a.choice = (uint8_t)(rng() % 4);
+                a.correct = rng() % 100 < 60;
+                r.score += a.correct;
+            }
+            double t = now_sec();
+            log.append(r);
+            compactions += log.maybeCompact();
+            appendSec += now_sec() - t;
+            if (i == 10000 || i == 100000 || i == 1000000 || i == n) {
+                t = now_sec();
+                const int reads = 100000;
+                for (int k = 0; k < reads; ++k) {
+                    const std::vector<LeaderEntry>& top = log.allTime();
+                    checksum += top.size() + top[k % top.size()].score;
+                }
+                readNs = (now_sec() - t) / reads * 1e9;
+                printf("  after %7zu sessions  top-100 read %5.1f ns   #1 %s %u/20\n", i, readNs, log.allTime()[0].player.c_str(),
+                       log.allTime()[0].score);
+            }
+        }
+    }
+    uint64_t logBytes = 0;
+    for (const char* ext : {"", ".1", ".archive"}) {
+        std::error_code ec;
+        uint64_t b = std::filesystem::file_size(path + ext, ec);
+        if (!ec) logBytes += b;
+    }
+    printf("  append + flush       %6.2f us/session  %.0f sessions/s  (%.1f MB on disk, %.0f B/session, %zu compactions)\n",
+           appendSec / n * 1e6, n / appendSec, logBytes / 1e6, (double)logBytes / n, compactions);
+
+    ResultsLog reopened(path);
+    double t = now_sec();
+    reopened.open();
+    double openSec = now_sec() - t;
+    Leaderboards rebuilt;
+    t = now_sec();
+    size_t scanned = for_each_result(path, [&](const SessionResult& r) { rebuilt.add(r); });
+    double scanSec = now_sec() - t;
+    bool same = reopened.sessions() == n && scanned == n && rebuilt.allTime.top().size() == reopened.allTime().size();
+    for (size_t i = 0; same && i < reopened.allTime().size(); ++i) same = rebuilt.allTime.top()[i].seq == reopened.allTime()[i].seq;
+    for (const auto& [day, board] : rebuilt.days) same = same && reopened.day(day) && reopened.day(day)->size() == board.top().size();
+    for (const auto& [name, board] : rebuilt.topics) same = same && reopened.topic(name) && reopened.topic(name)->front().seq == board.top().front().seq;
+    printf("  reopen (boards + live tail) %7.1f ms   full rescan %7.1f ms   boards %s\n", openSec * 1e3, scanSec * 1e3,
+           same ? "match the rescan" : "DIFFER");
+    if (checksum == 42) printf(" ");
+    std::filesystem::remove_all(dir);
+}
+
+// ---------- Scenario: analytics ----------
+// 2M logged 20-question sessions over a 100k-question bank, answered by a
+// logistic model: P(right) = 1 / (1 + e^(b - a)) for player ability a and
+// question difficulty b, both N(0, 1). Every 1000th question has its key
+// wrong, so the stronger players miss it. The columns against a serial
+// per-question map, one pass; the incremental update after 20k more
+// sessions (in the live log, as the game leaves them) against a recompute;
+// then the same log read against an edited bank.
+static void bench_analytics() {
+    printf("[analytics] 2M sessions x 20 answers over a 100k-question bank, %u hardware threads\n",
+           std::max(1u, std::thread::hardware_concurrency()));
+    const size_t questions = 100000, sessions = 2000000, more = 20000;
+    QuestionBank bank;
+    bank.reserve(questions, 4 * questions, 12 * questions);
+    std::vector<double> hardness(questions);
+    std::mt19937 rng(11);
+    std::normal_distribution<double> normal(0, 1);
+    for (size_t q = 0; q < questions; ++q) {
+        bank.addQuestion("Q" + std::to_string(q));
+        for (int k = 0; k < 4; ++k) bank.addOption("opt", k == 0);
+        hardness[q] = normal(rng);
+    }
+    std::vector<uint32_t> fingerprints(questions);
+    for (size_t q = 0; q < questions; ++q) fingerprints[q] = question_fingerprint(bank, q);
+
+    std::string dir = temp_path("quiz_bench_analytics");
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/results.log";
+    std::uniform_real_distribution<double> unit(0, 1);
+    auto play = [&](ResultsLog& log, size_t n, bool compact) {
+        SessionResult r;
+        r.answers.resize(20);
+        for (size_t i = 0; i < n; ++i) {
+            double ability = normal(rng);
+            r.player = "player";
+            r.time = 1760000000 + (int64_t)i;
+            r.score = 0;
+            for (SessionResult::Answer& a : r.answers) {
+                a.question = (uint32_t)(rng() % questions);
+                a.fingerprint = fingerprints[a.question];
+                a.tenths = (uint16_t)(50 + rng() % 300);
+                if (rng() % 20 == 0) {
+                    a.choice = 0xFF;
+                    a.correct = false;
+                    continue;
+                }
+                bool knows = unit(rng) < 1 / (1 + std::exp(hardness[a.question] - ability));
+                if (a.question % 1000 == 0) knows = !knows;
+                a.choice = knows ? 0 : (uint8_t)(1 + rng() % 3);
+                a.correct = a.choice == 0;
+                r.score += a.correct;
+            }
+            log.append(r);
+            log.maybeCompact();
+        }
+        if (compact) log.compactNow();
+    };
+    {
+        ResultsLog log(path);
+        log.open();
+        play(log, sessions, true);
+    }
+
+    // Baseline: one thread, a map entry per question holding the same sums.
+    struct Item { uint64_t answered = 0, correct = 0, pairs = 0, pairCorrect = 0; double sx = 0, sxx = 0, sxy = 0; };
+    double t = now_sec();
+    std::map<uint32_t, Item> items;
+    for_each_result(path, [&](const SessionResult& r) {
+        uint32_t taken = 0, right = 0;
+        for (const SessionResult::Answer& a : r.answers)
+            if (a.choice != 0xFF) taken++, right += a.correct;
+        for (const SessionResult::Answer& a : r.answers) {
+            if (a.choice == 0xFF) continue;
+            Item& it = items[a.question];
+            it.answered++;
+            it.correct += a.correct;
+            if (taken < 2) continue;
+            double x = (double)(right - a.correct) / (taken - 1);
+            it.pairs++;
+            it.pairCorrect += a.correct;
+            it.sx += x;
+            it.sxx += x * x;
+            if (a.correct) it.sxy += x;
+        }
+    });
+    double mapSec = now_sec() - t;
+
+    QuestionAnalytics analytics(bank);
+    t = now_sec();
+    size_t read = analytics.recompute(path);
+    double batchSec = now_sec() - t;
+    QuestionAnalytics serial(bank);
+    t = now_sec();
+    serial.recompute(path, 1);
+    double serialSec = now_sec() - t;
+    const AnswerColumns& c = analytics.columns();
+    printf("  serial map            %7.0f ms   %5.1fM answers/s\n", mapSec * 1e3, c.answers / mapSec / 1e6);
+    printf("  columns, 1 thread     %7.0f ms   %5.1fM answers/s\n", serialSec * 1e3, c.answers / serialSec / 1e6);
+    printf("  columns, all threads  %7.0f ms   %5.1fM answers/s   (%zu sessions, %.1f MB of columns per worker)\n",
+           batchSec * 1e3, c.answers / batchSec / 1e6, read, c.bytes() / 1e6);
+
+    bool same = c.sessions == sessions && serial.columns().answered == c.answered && serial.columns().picks == c.picks;
+    double worst = 0;
+    for (size_t q = 0; q < questions; ++q) {
+        auto it = items.find((uint32_t)q);
+        uint64_t answered = it == items.end() ? 0 : it->second.answered;
+        same = same && answered == c.answered[q] && (!answered || it->second.correct == c.correct[q]);
+        worst = std::max(worst, std::fabs(analytics.discrimination(q) - serial.discrimination(q)));
+    }
+    printf("  counts %s the map and the 1-thread run; discrimination within %.1e\n", same ? "match" : "DIFFER", worst);
+
+    // Measured p-values against the model's difficulty, and the bad keys.
+    double sp = 0, sb = 0, spp = 0, sbb = 0, spb = 0, n = 0, keyed = 0, flagged = 0, fine = 0;
+    for (size_t q = 0; q < questions; ++q) {
+        if (q % 1000 == 0) {
+            keyed++;
+            flagged += analytics.discrimination(q) < 0;
+            continue;
+        }
+        fine += analytics.discrimination(q) < 0;
+        double p = analytics.pValue(q), b = hardness[q];
+        n++, sp += p, sb += b, spp += p * p, sbb += b * b, spb += p * b;
+    }
+    double corr = (n * spb - sp * sb) / std::sqrt((n * spp - sp * sp) * (n * sbb - sb * sb));
+    printf("  p-value vs difficulty r = %.3f; negative discrimination: %.0f of %.0f wrong keys, %.0f of %.0f others\n", corr,
+           flagged, keyed, fine, n);
+
+    {
+        ResultsLog log(path);
+        log.open();
+        play(log, more, false);
+    }
+    t = now_sec();
+    size_t added = analytics.update(path);
+    double updateSec = now_sec() - t;
+    t = now_sec();
+    serial.recompute(path);
+    double fullSec = now_sec() - t;
+    printf("  +%zuk sessions: update %.1f ms, recompute %.0f ms; totals %s\n", added / 1000, updateSec * 1e3, fullSec * 1e3,
+           analytics.columns().answered == serial.columns().answered ? "agree" : "DIFFER");
+
+    // questions.txt edited after the fact: reversed, every 10th question
+    // deleted and question 5's text reworded. Answers must follow their
+    // questions, and the reworded one's must be left out.
+    QuestionBank edited;
+    std::vector<size_t> from;
+    for (size_t q = questions; q-- > 0;) {
+        if (q % 10 == 0) continue;
+        edited.addQuestion(q == 5 ? "Q5, reworded" : "Q" + std::to_string(q));
+        for (int k = 0; k < 4; ++k) edited.addOption("opt", k == 0);
+        from.push_back(q);
+    }
+    QuestionAnalytics after(edited);
+    after.recompute(path);
+    bool follow = true;
+    for (size_t e = 0; e < from.size(); ++e)
+        follow = follow && after.answered(e) == (from[e] == 5 ? 0 : analytics.answered(from[e])) &&
+                 after.columns().correct[e] == (from[e] == 5 ? 0 : analytics.columns().correct[from[e]]);
+    printf("  after reordering and deleting questions: answers %s their questions (%llu moved, %llu left out)\n",
+           follow ? "follow" : "DO NOT follow", (unsigned long long)after.columns().moved,
+           (unsigned long long)after.columns().unmatched);
+
+    // A question appended to questions.txt after it was loaded: saving must
+    // refuse rather than write the bank's difficulties against it.
+    std::string qpath = dir + "/questions.txt";
+    {
+        std::ofstream out(qpath, std::ios::binary);
+        out << "Q0\nyes|1\nno|0\n";
+    }
+    QuestionBank one;
+    load_questions(qpath, one);
+    one.setDifficulty(0, 3);
+    {
+        std::ofstream out(qpath, std::ios::binary | std::ios::app);
+        out << "\nQ1\nyes|1\nno|0\n";
+    }
+    std::string before;
+    {
+        std::ifstream in(qpath, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        before = ss.str();
+    }
+    std::string why;
+    bool saved = save_difficulties(qpath, one, &why);
+    std::ifstream in(qpath, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    printf("  question appended to questions.txt: %s, file %s\n", saved ? "SAVED" : "not saved",
+           ss.str() == before ? "untouched" : "CHANGED");
+    std::filesystem::remove_all(dir);
+}
+
+// ---------- Main ----------
+struct Scenario { const char* name; std::function<void()> run; };
+
+int main(int argc, char** argv) {
+    std::vector<Scenario> all = {
+        {"bank", bench_bank},
+        {"load", bench_load},
+        {"layout", bench_layout},
+        {"session", bench_session},
+        {"simulate", bench_simulate},
+        {"results", bench_results},
+        {"analytics", bench_analytics},
+    };
+    bool ran = false;
+    for (auto& sc : all) {
+        if (argc > 1 && strcmp(argv[1], sc.name) != 0) continue;
+        sc.run();
+        ran = true;
+    }
+    if (!ran) {
+        printf("unknown scenario '%s'; available:", argv[1]);
+        for (auto& sc : all) printf(" %s", sc.name);
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "quiz_session.h"
+#include <algorithm>
+#include <numeric>
+
+// ---------- Answer Statistics ----------
+void QuestionStats::resize(size_t questions) {
+    asked.resize(questions, 0);
+    correct.resize(questions, 0);
+}
+
+void QuestionStats::record(size_t q, bool ok) {
+    if (q >= asked.size()) return;
+    asked[q]++;
+    correct[q] += ok;
+}
+
+double QuestionStats::successRate(const QuestionBank& bank, size_t q) const {
+    int d = bank.difficulty(q);
+    double prior = d ? 0.9 - 0.15 * (d - 1) : 0.6;
+    if (q >= asked.size()) return prior;
+    return (correct[q] + 2 * prior) / (asked[q] + 2.0);
+}
+
+// ---------- Weighted Draws ----------
+void WeightedDraw::build(const std::vector<double>& weights) {
+    leaves = 1;
+    while (leaves < weights.size()) leaves *= 2;
+    sum.assign(2 * leaves, 0.0);
+    std::copy(weights.begin(), weights.end(), sum.begin() + leaves);
+    for (size_t i = leaves - 1; i > 0; --i) sum[i] = sum[2 * i] + sum[2 * i + 1];
+    if (!(sum[1] > 0)) sum.clear();
+}
+
+size_t WeightedDraw::take(std::mt19937_64& rng) {
+    double x = std::uniform_real_distribution<double>(0, sum[1])(rng);
+    size_t i = 1;
+    while (i < leaves) {
+        size_t l = 2 * i;
+        // Rounding can leave x just past a side's sum: never step into an empty side.
+        if (!(sum[l + 1] > 0) || (x < sum[l] && sum[l] > 0)) {
+            i = l;
+        } else {
+            x -= sum[l];
+            i = l + 1;
+        }
+    }
+    size_t k = i - leaves;
+    sum[i] = 0;
+    for (i /= 2; i > 0; i /= 2) sum[i] = sum[2 * i] + sum[2 * i + 1];
+    return k;
+}
+
+// ---------- Sessions ----------
+const char* session_order_name(SessionOrder order) {
+    switch (order) {
+    case SessionOrder::InOrder: return "In order";
+    case SessionOrder::Shuffled: return "Shuffled";
+    case SessionOrder::Weighted: return "Weighted";
+    case SessionOrder::Adaptive: return "Adaptive";
+    }
+    return "";
+}
+
+QuizSession::QuizSession(const QuestionBank& bank, const SessionOptions& opt, QuestionStats* stats)
+    : bank(bank), opt(opt), stats(stats), rng(opt.seed ? opt.seed : ((uint64_t)std::random_device()() << 32 | std::random_device()())) {
+    if (stats && stats->asked.size() < bank.size()) stats->resize(bank.size());
+
+    std::vector<double> weights;
+    if (opt.order == SessionOrder::Adaptive) buckets.resize(ADAPTIVE_BUCKETS);
+    for (size_t q = 0; q < bank.size(); ++q) {
+        int d = bank.difficulty(q);
+        if ((opt.topic >= 0 && bank.topic(q) != opt.topic) || d < opt.minDifficulty || d > opt.maxDifficulty) continue;
+        if (opt.order == SessionOrder::Adaptive) {
+            double p = stats ? stats->successRate(bank, q) : QuestionStats().successRate(bank, q);
+            buckets[std::min(ADAPTIVE_BUCKETS - 1, (int)((1 - p) * ADAPTIVE_BUCKETS))].push_back((uint32_t)q);
+            eligibleCount++;
+            continue;
+        }
+        if (opt.order == SessionOrder::Weighted) {
+            double w = opt.difficultyWeight[d];
+            if (stats) w /= 1.0 + stats->asked[q];
+            if (!(w > 0)) continue;
+            weights.push_back(w);
+        }
+        pool.push_back((uint32_t)q);
+    }
+    if (opt.order != SessionOrder::Adaptive) eligibleCount = pool.size();
+    poolLeft = pool.size();
+    if (opt.order == SessionOrder::Weighted) weighted.build(weights);
+    // Start where a fresh player is expected to get about 70% right.
+    adaptiveLevel = 3;
+
+    sessionLength = eligibleCount;
+    if (opt.length) sessionLength = std::min(opt.length, eligibleCount);
+    if (eligibleCount == 0) sessionLength = 0;
+    next();
+}
+
+bool QuizSession::draw(size_t& q) {
+    switch (opt.order) {
+    case SessionOrder::InOrder:
+        if (poolLeft == 0) return false;
+        q = pool[pool.size() - poolLeft--];
+        return true;
+    case SessionOrder::Shuffled: {
+        if (poolLeft == 0) return false;
+        size_t j = std::uniform_int_distribution<size_t>(0, poolLeft - 1)(rng);
+        q = pool[j];
+        std::swap(pool[j], pool[--poolLeft]);
+        return true;
+    }
+    case SessionOrder::Weighted:
+        if (weighted.empty()) return false;
+        q = pool[weighted.take(rng)];
+        return true;
+    case SessionOrder::Adaptive:
+        // The target bucket, then one easier, one harder, two easier, ...
+        for (int d = 0; d < 2 * ADAPTIVE_BUCKETS; ++d) {
+            int b = adaptiveLevel + (d % 2 ? -(d + 1) / 2 : d / 2);
+            if (b < 0 || b >= ADAPTIVE_BUCKETS || buckets[b].empty()) continue;
+            std::vector<uint32_t>& bucket = buckets[b];
+            size_t j = std::uniform_int_distribution<size_t>(0, bucket.size() - 1)(rng);
+            q = bucket[j];
+            bucket[j] = bucket.back();
+            bucket.pop_back();
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+void QuizSession::next() {
+    size_t q = 0;
+    if (drawn == sessionLength || !draw(q)) {
+        done = true;
+        slots.clear();
+        return;
+    }
+    drawn++;
+    current = q;
+    slots.resize(bank.optionCount(q));
+    std::iota(slots.begin(), slots.end(), 0u);
+    if (opt.shuffleOptions) std::shuffle(slots.begin(), slots.end(), rng);
+}
+
+bool QuizSession::answer(size_t slot) {
+    if (done || slot >= slots.size()) return false;
+    bool ok = bank.isCorrect(current, slots[slot]);
+    askedCount++;
+    scoreCount += ok;
+    if (stats) stats->record(current, ok);
+    if (opt.order == SessionOrder::Adaptive)
+        adaptiveLevel = ok ? std::min(ADAPTIVE_BUCKETS - 1, adaptiveLevel + 1) : std::max(0, adaptiveLevel - 2);
+    next();
+    return ok;
+}
+
+void QuizSession::skip() {
+    if (!done) next();
+}
@@ -0,0 +1,114 @@
+// Quiz sessions: question order, option order and answer statistics (no raylib dependency)
+
+#pragma once
+#include "question_bank.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// ---------- Answer Statistics ----------
+// Answers per question across sessions, indexed like the bank.
+struct QuestionStats {
+    std::vector<uint32_t> asked, correct;
+
+    void resize(size_t questions);
+    void record(size_t q, bool ok);
+    // Chance of a correct answer: the counts smoothed toward a prior from the
+    // question's difficulty (0.9 for 1 down to 0.3 for 5, 0.6 if not given),
+    // worth two answers.
+    double successRate(const QuestionBank& bank, size_t q) const;
+};
+
+// ---------- Weighted Draws ----------
+// Draws without replacement in proportion to weight: a sum tree with one
+// leaf per weight and every inner node the sum of its two children. A draw
+// walks down from the root and taking an item out rewrites the sums on its
+// path, so both are O(log n). The sums are recomputed from the children, not
+// adjusted, so they never drift.
+class WeightedDraw {
+public:
+    // Weights must be >= 0; all zero (or none) leaves nothing to draw.
+    void build(const std::vector<double>& weights);
+    bool empty() const { return sum.empty() || !(sum[1] > 0); }
+    // An index, with probability its weight over the total still left; it
+    // won't be drawn again.
+    size_t take(std::mt19937_64& rng);
+
+private:
+    size_t leaves = 0;         // a power of two
+    std::vector<double> sum;   // node i has children 2i and 2i + 1; leaves from index leaves
+};
+
+// ---------- Sessions ----------
+enum class SessionOrder { InOrder, Shuffled, Weighted, Adaptive };
+const char* session_order_name(SessionOrder order);
+
+struct SessionOptions {
+    SessionOrder order = SessionOrder::Shuffled;
+    int topic = -1;                     // -1 = every topic
+    int minDifficulty = 0;              // 0 admits questions without a difficulty
+    int maxDifficulty = 5;
+    size_t length = 0;                  // 0 or more than there are eligible questions: all of them
+    bool shuffleOptions = true;
+    // Weighted: relative weight by difficulty (index 0 = not given). Each
+    // question's weight is also divided by 1 + its times asked, when there
+    // are stats, so less-seen questions come up more.
+    double difficultyWeight[6] = {1, 1, 1, 1, 1, 1};
+    uint64_t seed = 0;                  // 0 = from std::random_device
+};
+
+// One run through the quiz. The eligible questions (topic and difficulty
+// filter) are gathered once when the session starts; after that each next
+// question takes constant time (Weighted: O(log n)), however big the bank.
+// No order asks a question twice in a session:
+//   InOrder   file order
+//   Shuffled  uniform, without replacement (swap-and-pop on the pool)
+//   Weighted  in proportion to weight, without replacement (WeightedDraw)
+//   Adaptive  questions are bucketed by their success rate in the stats; a
+//             staircase picks the bucket (one harder after a right answer,
+//             two easier after a wrong one, which settles where about two
+//             answers in three are right) and the question is drawn from it
+//             without replacement, or from the nearest non-empty bucket.
+// The bank (and stats) must outlive the session.
+class QuizSession {
+public:
+    static const int ADAPTIVE_BUCKETS = 10;
+
+    QuizSession(const QuestionBank& bank, const SessionOptions& opt, QuestionStats* stats = nullptr);
+
+    bool finished() const { return done; }
+    size_t question() const { return current; }   // bank index
+    size_t optionCount() const { return slots.size(); }
+    // The bank's option number shown in display slot k.
+    size_t option(size_t slot) const { return slots[slot]; }
+
+    // Scores the option in slot, records it in the stats and moves on.
+    bool answer(size_t slot);
+    void skip();
+
+    size_t eligible() const { return eligibleCount; }
+    size_t length() const { return sessionLength; }
+    size_t asked() const { return askedCount; }
+    size_t score() const { return scoreCount; }
+    int level() const { return adaptiveLevel; }   // Adaptive: current bucket, 0 = easiest
+
+private:
+    bool draw(size_t& q);
+    void next();
+
+    const QuestionBank& bank;
+    SessionOptions opt;
+    QuestionStats* stats;
+    std::mt19937_64 rng;
+
+    std::vector<uint32_t> pool;                            // InOrder, Shuffled, Weighted
+    size_t poolLeft = 0;
+    WeightedDraw weighted;
+    std::vector<std::vector<uint32_t>> buckets;            // Adaptive
+    int adaptiveLevel = 0;
+
+    size_t eligibleCount = 0, sessionLength = 0, askedCount = 0, scoreCount = 0, drawn = 0;
+    size_t current = 0;
+    std::vector<uint32_t> slots;
+    bool done = false;
+};
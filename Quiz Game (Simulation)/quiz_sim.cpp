@@ -0,0 +1,249 @@
+#include "quiz_sim.h"
+#include "../SRMS/profiler.h"
+#include "../SRMS/work_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static double now_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------- Session State ----------
+enum SimScreen : uint8_t { SIM_MENU, SIM_QUESTION, SIM_FINISHED, SIM_IDLE };
+
+struct SimSession {
+    uint32_t rng;          // xorshift32; never 0
+    uint32_t key;          // this session's question order
+    uint16_t step;         // questions shown so far
+    uint16_t score;
+    uint16_t runsLeft;     // sessions this slot still has to play, this one included
+    uint8_t screen;
+    uint8_t accuracy;      // percent
+};
+static_assert(sizeof(SimSession) == 16, "simulated sessions are meant to be 16 bytes");
+
+static uint32_t next_u32(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+// Uniform in [0, n) by multiply-high, without a division.
+static uint32_t below(uint32_t r, uint32_t n) { return (uint32_t)(((uint64_t)r * n) >> 32); }
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// A bijection of [0, 2^bits) chosen by key: odd multiplies, adds and
+// xor-shifts, each invertible mod 2^bits. Cycle-walking (applying it again
+// while the value is n or more) makes it a bijection of [0, n); since
+// 2^bits < 2n, that takes under two applications on average.
+struct Permutation {
+    uint32_t n, mask, shift;
+    Permutation(uint32_t n) : n(n), mask(0), shift(1) {
+        unsigned bits = 0;
+        while (bits < 32 && (1ull << bits) < n) ++bits;
+        mask = bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+        shift = std::max(1u, bits / 2);
+    }
+    uint32_t operator()(uint32_t x, uint32_t key) const {
+        uint32_t m1 = key | 1, m2 = (key >> 8) * 2 + 0x2C1B3C6D * 2 + 1, add = key >> 11;
+        do {
+            x = (x * m1 + add) & mask;
+            x ^= x >> shift;
+            x = (x * m2) & mask;
+            x ^= x >> shift;
+        } while (x >= n);
+        return x;
+    }
+};
+
+static void start_player(SimSession& s, const SimOptions& opt) {
+    s.key = next_u32(s.rng);
+    int lo = std::clamp(opt.accuracy - opt.accuracySpread, 0, 100), hi = std::clamp(opt.accuracy + opt.accuracySpread, 0, 100);
+    s.accuracy = (uint8_t)(lo + below(next_u32(s.rng), (uint32_t)(hi - lo + 1)));
+    s.screen = SIM_MENU;
+}
+
+// ---------- Simulation ----------
+namespace {
+struct alignas(64) WorkerTally {
+    uint64_t sessions = 0, answers = 0, correct = 0, skips = 0, active = 0;
+    std::vector<uint64_t> scores;
+};
+}
+
+bool run_simulation(const QuestionBank& bank, const SimOptions& opt, SimResult& result, std::string* why) {
+    PROFILE_SCOPE("run_simulation");
+    double t0 = now_sec();
+    result = SimResult();
+
+    // Shared by every session, read-only.
+    std::vector<uint32_t> eligible;
+    for (size_t q = 0; q < bank.size(); ++q) {
+        int d = bank.difficulty(q);
+        if ((opt.topic < 0 || bank.topic(q) == opt.topic) && d >= opt.minDifficulty && d <= opt.maxDifficulty)
+            eligible.push_back((uint32_t)q);
+    }
+    if (eligible.empty() || opt.sessions == 0) {
+        if (why) *why = eligible.empty() ? "no question matches the topic and difficulty" : "no sessions to run";
+        return false;
+    }
+    // Option count and first correct option (-1 if none) of each eligible
+    // question, side by side so a step touches the bank only for a wrong
+    // guess that might still be right.
+    struct Shape { uint8_t count; int8_t answer; };
+    std::vector<Shape> shapes(eligible.size());
+    for (size_t i = 0; i < eligible.size(); ++i) {
+        size_t count = std::min<size_t>(bank.optionCount(eligible[i]), 127);
+        shapes[i] = {(uint8_t)count, -1};
+        for (size_t k = 0; k < count; ++k)
+            if (bank.isCorrect(eligible[i], k)) { shapes[i].answer = (int8_t)k; break; }
+    }
+
+    size_t length = std::min<size_t>({opt.length ? opt.length : eligible.size(), eligible.size(), UINT16_MAX});
+    // A slot plays at most 65535 sessions; more sessions than that per slot
+    // get more slots.
+    size_t concurrent = std::max(std::min(opt.concurrent, opt.sessions), (opt.sessions + UINT16_MAX - 1) / UINT16_MAX);
+    std::vector<SimSession> sessions(concurrent);
+    for (size_t i = 0; i < concurrent; ++i) {
+        SimSession& s = sessions[i];
+        s.rng = (uint32_t)splitmix64(opt.seed ^ splitmix64(i));
+        if (s.rng == 0) s.rng = 1;
+        s.runsLeft = (uint16_t)(opt.sessions / concurrent + (i < opt.sessions % concurrent));
+        start_player(s, opt);
+    }
+
+    WorkStealingPool pool(opt.threads);
+    std::vector<WorkerTally> tallies(pool.size());
+    for (WorkerTally& t : tallies) t.scores.assign(length + 1, 0);
+    Permutation perm((uint32_t)eligible.size());
+    const size_t chunk = 1 << 16;
+    const size_t chunks = (concurrent + chunk - 1) / chunk;
+    const uint32_t skipRate = (uint32_t)std::clamp(opt.skipRate, 0, 100);
+
+    auto step = [&](size_t c, unsigned worker) {
+        WorkerTally& t = tallies[worker];
+        size_t end = std::min(concurrent, (c + 1) * chunk);
+        for (size_t i = c * chunk; i < end; ++i) {
+            SimSession& s = sessions[i];
+            switch (s.screen) {
+            case SIM_MENU:   // "Start Quiz"
+                s.step = 0;
+                s.score = 0;
+                s.screen = SIM_QUESTION;
+                break;
+            case SIM_QUESTION: {
+                uint32_t e = perm(s.step, s.key);
+                Shape shape = shapes[e];
+                uint32_t r = next_u32(s.rng);
+                if (shape.count == 0 || below(r, 100) < skipRate) {
+                    t.skips++;
+                } else {
+                    // The known answer, or a guess among the others.
+                    uint32_t k;
+                    bool ok;
+                    if (shape.answer >= 0 && below(next_u32(s.rng), 100) < s.accuracy) {
+                        k = (uint32_t)shape.answer;
+                        ok = true;
+                    } else {
+                        k = below(next_u32(s.rng), shape.count);
+                        if ((int)k == shape.answer && shape.count > 1) k = (k + 1) % shape.count;
+                        ok = bank.isCorrect(eligible[e], k);
+                    }
+                    s.score += ok;
+                    t.correct += ok;
+                    t.answers++;
+                }
+                if (++s.step == length) s.screen = SIM_FINISHED;
+                break;
+            }
+            case SIM_FINISHED:
+                t.scores[s.score]++;
+                t.sessions++;
+                if (--s.runsLeft) start_player(s, opt);
+                else s.screen = SIM_IDLE;
+                break;
+            default:
+                continue;
+            }
+            t.active++;
+        }
+    };
+
+    uint64_t active = 1;
+    while (active) {
+        for (WorkerTally& t : tallies) t.active = 0;
+        pool.run(chunks, step);
+        active = 0;
+        for (WorkerTally& t : tallies) active += t.active;
+        result.rounds += active ? 1 : 0;
+    }
+
+    result.scoreHistogram.assign(length + 1, 0);
+    for (const WorkerTally& t : tallies) {
+        result.sessions += t.sessions;
+        result.answers += t.answers;
+        result.correct += t.correct;
+        result.skips += t.skips;
+        for (size_t s = 0; s <= length; ++s) result.scoreHistogram[s] += t.scores[s];
+    }
+    result.eligible = eligible.size();
+    result.length = length;
+    result.bytesPerSession = sizeof(SimSession);
+    result.stateBytes = sessions.capacity() * sizeof(SimSession);
+    result.seconds = now_sec() - t0;
+    PROFILE_COUNT("simulated sessions", result.sessions);
+    PROFILE_COUNT("simulated answers", result.answers);
+    return true;
+}
+
+// ---------- Report ----------
+double SimResult::meanScore() const {
+    if (!sessions) return 0;
+    double sum = 0;
+    for (size_t s = 0; s < scoreHistogram.size(); ++s) sum += (double)s * scoreHistogram[s];
+    return sum / sessions;
+}
+
+size_t SimResult::scorePercentile(double p) const {
+    uint64_t need = (uint64_t)(p * sessions), seen = 0;
+    for (size_t s = 0; s < scoreHistogram.size(); ++s) {
+        seen += scoreHistogram[s];
+        if (seen > need || seen == sessions) return s;
+    }
+    return 0;
+}
+
+std::vector<std::string> simulation_report(const SimResult& r) {
+    std::vector<std::string> lines;
+    char buf[160];
+    double sec = r.seconds > 0 ? r.seconds : 1e-9;
+    snprintf(buf, sizeof buf, "%llu sessions of %zu questions (%zu eligible) in %.2f s, %llu rounds",
+             (unsigned long long)r.sessions, r.length, r.eligible, r.seconds, (unsigned long long)r.rounds);
+    lines.push_back(buf);
+    snprintf(buf, sizeof buf, "%.0f sessions/s, %.0f answers/s, %llu skips", r.sessions / sec, r.answers / sec,
+             (unsigned long long)r.skips);
+    lines.push_back(buf);
+    snprintf(buf, sizeof buf, "%zu B per session, %.1f MB of session state", r.bytesPerSession, r.stateBytes / 1e6);
+    lines.push_back(buf);
+    snprintf(buf, sizeof buf, "score: mean %.2f, p10 %zu, p50 %zu, p90 %zu, p99 %zu; %.1f%% of answers right", r.meanScore(),
+             r.scorePercentile(0.10), r.scorePercentile(0.50), r.scorePercentile(0.90), r.scorePercentile(0.99),
+             r.answers ? 100.0 * r.correct / r.answers : 0.0);
+    lines.push_back(buf);
+    // One bar per score, scaled to the most common.
+    uint64_t top = r.scoreHistogram.empty() ? 0 : *std::max_element(r.scoreHistogram.begin(), r.scoreHistogram.end());
+    for (size_t s = 0; s < r.scoreHistogram.size() && top; ++s) {
+        int bar = (int)(40.0 * r.scoreHistogram[s] / top + 0.5);
+        snprintf(buf, sizeof buf, "%4zu %6.2f%% %s", s, 100.0 * r.scoreHistogram[s] / r.sessions, std::string(bar, '#').c_str());
+        lines.push_back(buf);
+    }
+    return lines;
+}
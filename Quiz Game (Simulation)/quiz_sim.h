@@ -0,0 +1,49 @@
+// Headless quiz simulation: many players through the quiz screens at once (no raylib dependency)
+
+#pragma once
+#include "question_bank.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SimOptions {
+    size_t sessions = 1000000;      // sessions played in total
+    size_t concurrent = 100000;     // sessions in progress at once
+    unsigned length = 20;           // questions per session, at most the eligible count; 0 = all of them
+    int accuracy = 70;              // players' mean chance of a right answer, percent
+    int accuracySpread = 20;        // each player gets accuracy +- up to this
+    int skipRate = 5;               // chance of skipping a question, percent
+    int topic = -1;                 // as in SessionOptions
+    int minDifficulty = 0, maxDifficulty = 5;
+    unsigned threads = 0;           // 0 = std::thread::hardware_concurrency()
+    uint64_t seed = 1;
+};
+
+struct SimResult {
+    uint64_t sessions = 0, answers = 0, correct = 0, skips = 0;
+    uint64_t rounds = 0;            // passes over the concurrent sessions
+    size_t eligible = 0, length = 0;
+    size_t bytesPerSession = 0, stateBytes = 0;
+    double seconds = 0;
+    std::vector<uint64_t> scoreHistogram;   // sessions by final score
+
+    double meanScore() const;
+    // Smallest score at or above fraction p of the sessions.
+    size_t scorePercentile(double p) const;
+};
+
+// Every concurrent session is a 16-byte record moving through the same
+// screens as the game: menu, then a question per step (answered or skipped),
+// then the finish screen, where its score is tallied and the slot starts the
+// next player's session until the total is reached. Each round advances every
+// session one screen, in parallel over ranges of sessions, with tallies kept
+// per worker and summed at the end.
+//
+// Sessions draw questions in a shuffled order without repeats, but hold no
+// pool: the order is a keyed permutation of the eligible questions, evaluated
+// at the session's step. Results depend only on the options and seed, not on
+// the thread count. False (and why) if no question is eligible.
+bool run_simulation(const QuestionBank& bank, const SimOptions& opt, SimResult& result, std::string* why = nullptr);
+
+// Throughput, memory and the score distribution, one line each.
+std::vector<std::string> simulation_report(const SimResult& result);
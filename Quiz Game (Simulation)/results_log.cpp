@@ -0,0 +1,516 @@
+#include "results_log.h"
+#include "../SRMS/crc32.h"
+#include "../SRMS/mapped_file.h"
+#include "../SRMS/profiler.h"
+#include "../SRMS/work_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// ---------- Leaderboards ----------
+static bool ranks_above(const LeaderEntry& a, const LeaderEntry& b) {
+    return a.score != b.score ? a.score > b.score : a.seq < b.seq;
+}
+
+bool Leaderboard::offer(const LeaderEntry& e) {
+    if (k == 0 || (entries.size() == k && !ranks_above(e, entries.back()))) return false;
+    entries.insert(std::upper_bound(entries.begin(), entries.end(), e, ranks_above), e);
+    if (entries.size() > k) entries.pop_back();
+    return true;
+}
+
+void Leaderboards::add(const SessionResult& r) {
+    lastSeq = std::max(lastSeq, r.seq);
+    sessions++;
+    LeaderEntry e;
+    e.seq = r.seq;
+    e.time = r.time;
+    e.score = r.score;
+    e.questions = (uint32_t)r.answers.size();
+    // Most sessions make no board, so the name is only copied for those that do.
+    bool fits = allTime.top().size() < k || ranks_above(e, allTime.top().back());
+    Leaderboard& today = days.try_emplace(r.time / 86400, k).first->second;
+    Leaderboard* byTopic = r.topic.empty() ? nullptr : &topics.try_emplace(r.topic, k).first->second;
+    fits = fits || today.top().size() < k || ranks_above(e, today.top().back()) ||
+           (byTopic && (byTopic->top().size() < k || ranks_above(e, byTopic->top().back())));
+    if (!fits) return;
+    e.player = r.player;
+    allTime.offer(e);
+    today.offer(e);
+    if (byTopic) byTopic->offer(e);
+}
+
+void Leaderboards::pruneDays(size_t keepDays) {
+    if (days.empty()) return;
+    int64_t oldest = days.rbegin()->first - (int64_t)keepDays;
+    days.erase(days.begin(), days.lower_bound(oldest + 1));
+}
+
+// ---------- Records ----------
+static const uint32_t MAX_RECORD = 1u << 20;
+static const size_t RESULT_FIXED = 22;   // seq, time, score, answers, the two lengths
+
+template <typename T> static void put(std::string& out, T v) { out.append((const char*)&v, sizeof v); }
+template <typename T> static T get(const char*& p) {
+    T v;
+    memcpy(&v, p, sizeof v);
+    p += sizeof v;
+    return v;
+}
+
+static void encode_result(std::string& out, const SessionResult& r) {
+    size_t at = out.size();
+    out.resize(at + 8);
+    size_t playerLen = std::min<size_t>(r.player.size(), 255), topicLen = std::min<size_t>(r.topic.size(), 255);
+    size_t answers = std::min<size_t>(r.answers.size(), UINT16_MAX);
+    put<uint64_t>(out, r.seq);
+    put<int64_t>(out, r.time);
+    put<uint16_t>(out, (uint16_t)std::min<uint32_t>(r.score, UINT16_MAX));
+    put<uint16_t>(out, (uint16_t)answers);
+    put<uint8_t>(out, (uint8_t)playerLen);
+    put<uint8_t>(out, (uint8_t)topicLen);
+    out.append(r.player.data(), playerLen);
+    out.append(r.topic.data(), topicLen);
+    for (size_t i = 0; i < answers; ++i) {
+        const SessionResult::Answer& a = r.answers[i];
+        put<uint32_t>(out, a.question);
+        put<uint32_t>(out, a.fingerprint);
+        put<uint16_t>(out, a.tenths);
+        put<uint8_t>(out, a.choice);
+        put<uint8_t>(out, a.correct ? 1 : 0);
+    }
+    uint32_t len = (uint32_t)(out.size() - at - 8);
+    uint32_t crc = crc32(out.data() + at + 8, len);
+    memcpy(&out[at], &len, 4);
+    memcpy(&out[at + 4], &crc, 4);
+}
+
+static bool decode_result(const char* p, uint32_t len, SessionResult& r) {
+    if (len < RESULT_FIXED) return false;
+    const char* end = p + len;
+    r.seq = get<uint64_t>(p);
+    r.time = get<int64_t>(p);
+    r.score = get<uint16_t>(p);
+    size_t answers = get<uint16_t>(p);
+    size_t playerLen = get<uint8_t>(p), topicLen = get<uint8_t>(p);
+    size_t rest = (size_t)(end - p);
+    bool fingerprinted = rest == playerLen + topicLen + 12 * answers;
+    if (!fingerprinted && rest != playerLen + topicLen + 8 * answers) return false;
+    r.player.assign(p, playerLen);
+    r.topic.assign(p + playerLen, topicLen);
+    p += playerLen + topicLen;
+    r.answers.resize(answers);
+    for (SessionResult::Answer& a : r.answers) {
+        a.question = get<uint32_t>(p);
+        a.fingerprint = fingerprinted ? get<uint32_t>(p) : 0;
+        a.tenths = get<uint16_t>(p);
+        a.choice = get<uint8_t>(p);
+        a.correct = get<uint8_t>(p) != 0;
+    }
+    return true;
+}
+
+// Calls fn(payload, len) for each intact record and returns the length of
+// the intact prefix; a torn or corrupt record ends it.
+template <typename Fn> static size_t scan_records(const char* data, size_t size, Fn fn) {
+    size_t pos = 0;
+    while (pos + 8 <= size) {
+        uint32_t len, crc;
+        memcpy(&len, data + pos, 4);
+        memcpy(&crc, data + pos + 4, 4);
+        if (len < RESULT_FIXED || len > MAX_RECORD || pos + 8 + len > size) break;
+        if (crc32(data + pos + 8, len) != crc) break;
+        fn(data + pos + 8, len);
+        pos += 8 + len;
+    }
+    return pos;
+}
+
+static uint64_t record_seq(const char* payload) {
+    uint64_t seq;
+    memcpy(&seq, payload, 8);
+    return seq;
+}
+
+// Adds the sessions of file after boards.lastSeq to boards; a torn tail is
+// cut off when truncate is set. Returns the intact size.
+static size_t replay_results(const std::string& file, Leaderboards& boards, bool truncate) {
+    MappedFile f;
+    if (!f.open(file)) return 0;
+    SessionResult r;
+    size_t good = scan_records(f.data(), f.size(), [&](const char* p, uint32_t len) {
+        if (record_seq(p) > boards.lastSeq && decode_result(p, len, r)) boards.add(r);
+    });
+    size_t size = f.size();
+    f.close();
+    if (truncate && good < size) {
+        std::error_code ec;
+        fs::resize_file(file, good, ec);
+    }
+    return good;
+}
+
+// ---------- Boards File ----------
+// "QUIZLB" header, then allTime, the days and the topics, each board as a
+// count and its entries, then a crc32 of everything before it.
+static const char BOARDS_MAGIC[8] = {'Q', 'U', 'I', 'Z', 'L', 'B', '\0', '\0'};
+static const uint32_t BOARDS_VERSION = 1;
+
+static void put_board(std::string& out, const Leaderboard& b) {
+    put<uint32_t>(out, (uint32_t)b.top().size());
+    for (const LeaderEntry& e : b.top()) {
+        put<uint64_t>(out, e.seq);
+        put<int64_t>(out, e.time);
+        put<uint32_t>(out, e.score);
+        put<uint32_t>(out, e.questions);
+        put<uint8_t>(out, (uint8_t)std::min<size_t>(e.player.size(), 255));
+        out.append(e.player.data(), std::min<size_t>(e.player.size(), 255));
+    }
+}
+
+static bool write_boards(const std::string& path, const Leaderboards& b, uint64_t archiveBytes) {
+    std::string out(BOARDS_MAGIC, 8);
+    put<uint32_t>(out, BOARDS_VERSION);
+    put<uint32_t>(out, (uint32_t)b.k);
+    put<uint64_t>(out, b.lastSeq);
+    put<uint64_t>(out, b.sessions);
+    put<uint64_t>(out, archiveBytes);
+    put<uint32_t>(out, (uint32_t)b.days.size());
+    put<uint32_t>(out, (uint32_t)b.topics.size());
+    put_board(out, b.allTime);
+    for (const auto& [day, board] : b.days) {
+        put<int64_t>(out, day);
+        put_board(out, board);
+    }
+    for (const auto& [name, board] : b.topics) {
+        put<uint8_t>(out, (uint8_t)std::min<size_t>(name.size(), 255));
+        out.append(name.data(), std::min<size_t>(name.size(), 255));
+        put_board(out, board);
+    }
+    put<uint32_t>(out, crc32(out.data(), out.size()));
+
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = fclose(f) == 0 && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, path, ec);
+    return ok && !ec;
+}
+
+static bool read_boards(const std::string& path, Leaderboards& b, uint64_t& archiveBytes) {
+    MappedFile f;
+    if (!f.open(path) || f.size() < 52) return false;
+    const char* p = f.data();
+    const char* end = p + f.size() - 4;
+    uint32_t crc;
+    memcpy(&crc, end, 4);
+    if (memcmp(p, BOARDS_MAGIC, 8) != 0 || crc32(p, f.size() - 4) != crc) return false;
+    p += 8;
+    if (get<uint32_t>(p) != BOARDS_VERSION) return false;
+    get<uint32_t>(p);   // k when written; this log's own k applies
+    b.lastSeq = get<uint64_t>(p);
+    b.sessions = get<uint64_t>(p);
+    archiveBytes = get<uint64_t>(p);
+    uint32_t dayCount = get<uint32_t>(p), topicCount = get<uint32_t>(p);
+
+    // The crc vouches for the layout, but the reads are bounded all the same.
+    bool ok = true;
+    auto need = [&](size_t n) { return ok = ok && (size_t)(end - p) >= n; };
+    auto read_board = [&](Leaderboard& board) {
+        if (!need(4)) return;
+        uint32_t n = get<uint32_t>(p);
+        for (uint32_t i = 0; i < n && need(25); ++i) {
+            LeaderEntry e;
+            e.seq = get<uint64_t>(p);
+            e.time = get<int64_t>(p);
+            e.score = get<uint32_t>(p);
+            e.questions = get<uint32_t>(p);
+            size_t len = get<uint8_t>(p);
+            if (!need(len)) return;
+            e.player.assign(p, len);
+            p += len;
+            board.offer(e);
+        }
+    };
+    read_board(b.allTime);
+    for (uint32_t i = 0; i < dayCount && need(8); ++i) {
+        int64_t day = get<int64_t>(p);
+        read_board(b.days.try_emplace(day, b.k).first->second);
+    }
+    for (uint32_t i = 0; i < topicCount && need(1); ++i) {
+        size_t len = get<uint8_t>(p);
+        if (!need(len)) break;
+        std::string name(p, len);
+        p += len;
+        read_board(b.topics.try_emplace(name, b.k).first->second);
+    }
+    return ok;
+}
+
+// Appends the sessions in files after archivedSeq to the archive, then
+// writes boards (which must hold exactly the archive's sessions once these
+// are in) to the boards file. Removes or empties the folded files only after
+// that, so a crash in between leaves sessions the next open skips.
+static bool fold_into_archive(const std::vector<std::string>& files, const std::string& archivePath, const std::string& boardsPath,
+                              const Leaderboards& boards, uint64_t archivedSeq, uint64_t& archiveBytes) {
+    PROFILE_SCOPE("fold_results");
+    FILE* arch = fopen(archivePath.c_str(), "ab");
+    if (!arch) return false;
+    bool ok = true;
+    for (const std::string& file : files) {
+        MappedFile f;
+        if (!f.open(file)) continue;
+        // Runs of new records are copied as they stand.
+        const char* runStart = nullptr;
+        const char* runEnd = nullptr;
+        auto flushRun = [&] {
+            if (runStart && fwrite(runStart, 1, runEnd - runStart, arch) != (size_t)(runEnd - runStart)) ok = false;
+            runStart = nullptr;
+        };
+        scan_records(f.data(), f.size(), [&](const char* p, uint32_t len) {
+            uint64_t seq = record_seq(p);
+            if (seq <= archivedSeq) { flushRun(); return; }
+            archivedSeq = seq;
+            if (!runStart) runStart = p - 8;
+            runEnd = p + len;
+        });
+        flushRun();
+    }
+    ok = fflush(arch) == 0 && ok;
+    ok = fclose(arch) == 0 && ok;
+    std::error_code ec;
+    uint64_t size = ok ? (uint64_t)fs::file_size(archivePath, ec) : 0;
+    if (!ok || ec || !write_boards(boardsPath, boards, size)) return false;
+    archiveBytes = size;
+    return true;
+}
+
+// ---------- ResultsLog ----------
+ResultsLog::ResultsLog(const std::string& p, size_t topK)
+    : path(p), oldPath(p + ".1"), archivePath(p + ".archive"), boardsPath(p + ".boards"), live(topK) {}
+
+ResultsLog::~ResultsLog() {
+    waitCompaction();
+    close();
+}
+
+bool ResultsLog::open(std::string* why) {
+    PROFILE_SCOPE("ResultsLog::open");
+    waitCompaction();
+    close();
+    live = Leaderboards(live.k);
+    std::error_code ec;
+    uint64_t archiveSize = fs::exists(archivePath, ec) ? (uint64_t)fs::file_size(archivePath, ec) : 0;
+    if (read_boards(boardsPath, live, archivedBytes) && archiveSize >= archivedBytes) {
+        // Anything past the recorded size was appended by a fold that never
+        // got to write its boards; that fold is redone below.
+        if (archiveSize > archivedBytes) fs::resize_file(archivePath, archivedBytes, ec);
+    } else {
+        // No usable boards: rebuild them from the archive, the slow way.
+        live = Leaderboards(live.k);
+        archivedBytes = replay_results(archivePath, live, true);
+    }
+    archivedSeq = live.lastSeq;
+
+    if (fs::exists(oldPath, ec)) {
+        replay_results(oldPath, live, false);
+        Leaderboards copy = live;
+        copy.pruneDays(keepDays);
+        if (fold_into_archive({oldPath}, archivePath, boardsPath, copy, archivedSeq, archivedBytes)) {
+            archivedSeq = copy.lastSeq;
+            fs::remove(oldPath, ec);
+        } else {
+            compactFailed = true;
+        }
+    }
+    bytes = replay_results(path, live, true);
+    out = fopen(path.c_str(), "ab");
+    if (!out) {
+        if (why) *why = "cannot open " + path + " for appending";
+        return false;
+    }
+    return true;
+}
+
+void ResultsLog::close() {
+    if (out) fclose(out);
+    out = nullptr;
+}
+
+bool ResultsLog::append(SessionResult& r) {
+    r.seq = live.lastSeq + 1;
+    std::string rec;
+    encode_result(rec, r);
+    live.add(r);
+    if (!out) return false;
+    if (fwrite(rec.data(), 1, rec.size(), out) != rec.size() || fflush(out) != 0) {
+        // Drop a partial record so later appends stay reachable on replay.
+        std::error_code ec;
+        fclose(out);
+        fs::resize_file(path, bytes, ec);
+        out = fopen(path.c_str(), "ab");
+        return false;
+    }
+    bytes += rec.size();
+    return true;
+}
+
+const std::vector<LeaderEntry>* ResultsLog::day(int64_t d) const {
+    auto it = live.days.find(d);
+    return it == live.days.end() ? nullptr : &it->second.top();
+}
+
+const std::vector<LeaderEntry>* ResultsLog::topic(const std::string& name) const {
+    auto it = live.topics.find(name);
+    return it == live.topics.end() ? nullptr : &it->second.top();
+}
+
+bool ResultsLog::rotate() {
+    if (out) fclose(out);
+    out = nullptr;
+    std::error_code ec;
+    fs::rename(path, oldPath, ec);
+    out = fopen(path.c_str(), "ab");
+    if (ec) return false;
+    bytes = 0;
+    return out != nullptr;
+}
+
+void ResultsLog::waitCompaction() {
+    if (worker.joinable()) worker.join();
+}
+
+bool ResultsLog::maybeCompact(bool force) {
+    if (busy || bytes == 0) return false;
+    if (bytes < maxBytes && !force) return false;
+    waitCompaction();
+    std::error_code ec;
+    // A previous worker failed: rotating now would clobber the unfolded .1.
+    if (fs::exists(oldPath, ec)) return compactNow();
+    if (!rotate()) {
+        compactFailed = true;
+        return false;
+    }
+    // The boards now hold exactly what the archive will once .1 is folded in.
+    live.pruneDays(keepDays);
+    busy = true;
+    worker = std::thread([this, copy = live]() {
+        bool ok = fold_into_archive({oldPath}, archivePath, boardsPath, copy, archivedSeq, archivedBytes);
+        std::error_code ec;
+        if (ok) {
+            archivedSeq = copy.lastSeq;
+            fs::remove(oldPath, ec);
+        }
+        compactFailed = !ok;
+        busy = false;
+    });
+    return true;
+}
+
+bool ResultsLog::compactNow() {
+    waitCompaction();
+    close();
+    live.pruneDays(keepDays);
+    // Everything not yet in the archive is in .1 (after a failed fold) and the
+    // live log. A failed fold may have left part of .1 on the archive.
+    std::error_code ec;
+    if (fs::exists(archivePath, ec) && (uint64_t)fs::file_size(archivePath, ec) > archivedBytes)
+        fs::resize_file(archivePath, archivedBytes, ec);
+    bool ok = fold_into_archive({oldPath, path}, archivePath, boardsPath, live, archivedSeq, archivedBytes);
+    if (ok) {
+        archivedSeq = live.lastSeq;
+        fs::remove(oldPath, ec);
+        fs::resize_file(path, 0, ec);
+        bytes = 0;
+    }
+    out = fopen(path.c_str(), "ab");
+    compactFailed = !ok;
+    return ok;
+}
+
+// ---------- Reading ----------
+size_t for_each_result(const std::string& path, const std::function<void(const SessionResult&)>& fn) {
+    // Sessions only move live -> .1 -> archive, so opening the files in that
+    // order sees each one at least once while a compaction runs; the seq
+    // check drops the second sighting.
+    MappedFile files[3];
+    files[2].open(path);
+    files[1].open(path + ".1");
+    files[0].open(path + ".archive");
+    uint64_t lastSeq = 0;
+    size_t n = 0;
+    SessionResult r;
+    for (const MappedFile& f : files) {
+        scan_records(f.data(), f.size(), [&](const char* p, uint32_t len) {
+            if (record_seq(p) <= lastSeq || !decode_result(p, len, r)) return;
+            lastSeq = r.seq;
+            fn(r);
+            n++;
+        });
+    }
+    return n;
+}
+
+size_t for_each_result_parallel(const std::string& path, WorkStealingPool& pool, uint64_t afterSeq,
+                                const std::function<void(const SessionResult&, unsigned worker)>& fn, uint64_t* lastSeq,
+                                size_t stretchBytes) {
+    PROFILE_SCOPE("for_each_result_parallel");
+    MappedFile files[3];
+    files[2].open(path);
+    files[1].open(path + ".1");
+    files[0].open(path + ".archive");
+
+    // Stretches of whole records. A file's sessions are in order, so those
+    // at or below the last one of the files before it are repeats.
+    struct Stretch { const char* data; size_t size; uint64_t after; };
+    std::vector<Stretch> stretches;
+    uint64_t seen = afterSeq;
+    // The archive up to the size the boards file records holds nothing after
+    // the boards' last session: when that is old news, skip it unwalked.
+    Leaderboards covered(1);
+    uint64_t coveredBytes = 0;
+    size_t skip = 0;
+    if (read_boards(path + ".boards", covered, coveredBytes) && covered.lastSeq <= afterSeq && coveredBytes <= files[0].size())
+        skip = (size_t)coveredBytes;
+    for (const MappedFile& f : files) {
+        const char* data = f.data();
+        size_t pos = &f == files ? skip : 0, start = pos;
+        uint64_t after = seen;
+        while (pos + 8 <= f.size()) {
+            uint32_t len;
+            memcpy(&len, data + pos, 4);
+            if (len < RESULT_FIXED || len > MAX_RECORD || pos + 8 + len > f.size()) break;
+            seen = std::max(seen, record_seq(data + pos + 8));
+            pos += 8 + len;
+            if (pos - start >= stretchBytes) {
+                stretches.push_back({data + start, pos - start, after});
+                start = pos;
+            }
+        }
+        if (pos > start) stretches.push_back({data + start, pos - start, after});
+    }
+
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> highest{afterSeq};
+    pool.run(stretches.size(), [&](size_t i, unsigned worker) {
+        const Stretch& st = stretches[i];
+        SessionResult r;
+        size_t n = 0;
+        uint64_t top = 0;
+        scan_records(st.data, st.size, [&](const char* p, uint32_t len) {
+            if (record_seq(p) <= st.after || !decode_result(p, len, r)) return;
+            fn(r, worker);
+            top = std::max(top, r.seq);
+            n++;
+        });
+        count += n;
+        uint64_t h = highest.load();
+        while (top > h && !highest.compare_exchange_weak(h, top)) {}
+    });
+    if (lastSeq) *lastSeq = highest;
+    return count;
+}
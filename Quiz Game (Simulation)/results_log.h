@@ -0,0 +1,151 @@
+// Quiz results: append-only binary log of finished sessions, with leaderboards (no raylib dependency)
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SessionResult {
+    struct Answer {
+        uint32_t question = 0;     // bank index
+        uint32_t fingerprint = 0;  // question_fingerprint() when asked; 0 = not recorded
+        uint16_t tenths = 0;       // time taken, tenths of a second (saturates)
+        uint8_t choice = 0xFF;     // bank option number; 0xFF = skipped
+        bool correct = false;
+    };
+    uint64_t seq = 0;              // set by ResultsLog::append
+    int64_t time = 0;              // unix seconds at the finish
+    std::string player;            // up to 255 bytes
+    std::string topic;             // the session's topic filter; empty = all
+    uint32_t score = 0;
+    std::vector<Answer> answers;
+};
+
+// ---------- Leaderboards ----------
+struct LeaderEntry {
+    uint64_t seq = 0;
+    int64_t time = 0;
+    uint32_t score = 0, questions = 0;
+    std::string player;
+};
+
+// The best k sessions: higher score first, then the earlier session. A
+// session that doesn't make the board costs one comparison; one that does
+// is inserted into the sorted k entries.
+class Leaderboard {
+public:
+    explicit Leaderboard(size_t k = 100) : k(k) {}
+    bool offer(const LeaderEntry& e);
+    const std::vector<LeaderEntry>& top() const { return entries; }
+
+private:
+    size_t k;
+    std::vector<LeaderEntry> entries;
+};
+
+// Every leaderboard, and the last session they include.
+struct Leaderboards {
+    explicit Leaderboards(size_t k = 100) : k(k), allTime(k) {}
+    void add(const SessionResult& r);
+    // Forgets days more than keepDays before the newest one.
+    void pruneDays(size_t keepDays);
+
+    size_t k;
+    uint64_t lastSeq = 0, sessions = 0;
+    Leaderboard allTime;
+    std::map<int64_t, Leaderboard> days;           // by UTC day (unix time / 86400)
+    std::map<std::string, Leaderboard> topics;     // sessions with a topic filter
+};
+
+// ---------- Log ----------
+// <path> takes one record per finished session, [u32 len][u32 crc32][payload]
+// as in the SRMS journal, flushed on append. The payload is little-endian:
+//   u64 seq, i64 time, u16 score, u16 answers, u8 playerLen, u8 topicLen,
+//   player, topic, then per answer u32 question, u32 fingerprint, u16 tenths,
+//   u8 choice, u8 correct
+// so a 20-question session takes about 280 bytes. Records written before
+// answers carried a fingerprint (8 bytes per answer) still decode, with
+// fingerprint 0; the payload length tells the two apart.
+//
+// The leaderboards are kept up to date as sessions are appended, so reading
+// a top 100 costs the same however long the log is. Opening does not rescan
+// the history either: compaction moves the live log to <path>.1, and a
+// worker thread appends its records to <path>.archive, then writes the
+// boards as they stood (with the archive size and last seq they cover) to
+// <path>.boards and removes <path>.1. Opening loads <path>.boards, cuts the
+// archive back to the size it records, folds in a leftover <path>.1 and
+// replays the live log. Sessions are numbered, and every replay and fold
+// skips the ones the boards already hold, so a crash at any point of a
+// compaction loses nothing and counts nothing twice.
+class ResultsLog {
+public:
+    explicit ResultsLog(const std::string& path, size_t topK = 100);
+    ~ResultsLog();
+    ResultsLog(const ResultsLog&) = delete;
+    ResultsLog& operator=(const ResultsLog&) = delete;
+
+    bool open(std::string* why = nullptr);
+    void close();
+
+    // Numbers r, writes it and adds it to the boards. False if the write
+    // failed; the boards still count it for this run.
+    bool append(SessionResult& r);
+
+    const Leaderboards& boards() const { return live; }
+    const std::vector<LeaderEntry>& allTime() const { return live.allTime.top(); }
+    // Null when nobody finished a session that day / with that topic.
+    const std::vector<LeaderEntry>* day(int64_t day) const;
+    const std::vector<LeaderEntry>* topic(const std::string& name) const;
+    uint64_t sessions() const { return live.sessions; }
+
+    // Starts a background compaction once the live log passes maxBytes, or
+    // right away with force. True if one started.
+    bool maybeCompact(bool force = false);
+    // Synchronous compaction (waits for a running one first).
+    bool compactNow();
+    bool compacting() const { return busy; }
+    bool lastCompactFailed() const { return compactFailed; }
+    size_t liveBytes() const { return bytes; }
+
+    size_t maxBytes = 64u << 20;
+    size_t keepDays = 90;   // per-day boards kept across compactions
+
+private:
+    bool rotate();
+    void waitCompaction();
+
+    std::string path, oldPath, archivePath, boardsPath;
+    FILE* out = nullptr;
+    size_t bytes = 0;
+    Leaderboards live;
+    // What the boards file covers; the worker updates them, read after joining.
+    uint64_t archivedSeq = 0, archivedBytes = 0;
+    std::thread worker;
+    std::atomic<bool> busy{false};
+    std::atomic<bool> compactFailed{false};
+};
+
+// Calls fn for every session in <path>.archive, <path>.1 and <path>, in
+// order and each once, also while a background compaction runs. Returns the
+// number of sessions.
+size_t for_each_result(const std::string& path, const std::function<void(const SessionResult&)>& fn);
+
+class WorkStealingPool;
+// The same sessions, but only those numbered after afterSeq, checked and
+// decoded on pool's threads: fn(session, worker) is called concurrently and
+// in no particular order. The files are cut into stretches of about
+// stretchBytes at record boundaries by a walk over the length fields; a
+// corrupt record ends its stretch rather than the whole file. The part of
+// the archive that <path>.boards covers is skipped without a walk when
+// afterSeq is past it, so reading what is new costs the size of the live
+// log rather than the history. lastSeq gets
+// the highest session number seen (afterSeq if none). Returns the number of
+// sessions.
+size_t for_each_result_parallel(const std::string& path, WorkStealingPool& pool, uint64_t afterSeq,
+                                const std::function<void(const SessionResult&, unsigned worker)>& fn,
+                                uint64_t* lastSeq = nullptr, size_t stretchBytes = 1 << 20);
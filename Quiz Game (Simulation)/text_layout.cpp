@@ -0,0 +1,91 @@
+#include "text_layout.h"
+#include "../SRMS/profiler.h"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+// ---------- Layout ----------
+void layout_text(std::string_view text, int fontSize, float maxWidth, TextMeasureFn measure, TextLayout& out) {
+    out.text.clear();
+    out.lineStart.clear();
+    out.lineWidth.clear();
+    out.width = 0;
+
+    // Every word is copied out with a NUL after it and measured in place.
+    struct Word { uint32_t start; int width; };
+    std::vector<Word> words;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && isspace((unsigned char)text[i])) ++i;
+        size_t j = i;
+        while (j < text.size() && !isspace((unsigned char)text[j])) ++j;
+        if (j == i) break;
+        words.push_back({(uint32_t)out.text.size(), 0});
+        out.text.append(text.data() + i, j - i);
+        out.text.push_back('\0');
+        i = j;
+    }
+    for (Word& w : words) w.width = measure(out.text.data() + w.start, fontSize);
+    // What a space adds between two words, letter spacing included.
+    int gap = measure("a a", fontSize) - 2 * measure("a", fontSize);
+
+    // Greedy breaks; the NUL before a word that continues a line becomes a space.
+    int lineW = 0;
+    for (size_t k = 0; k < words.size(); ++k) {
+        if (k > 0 && lineW + gap + words[k].width <= maxWidth) {
+            out.text[words[k].start - 1] = ' ';
+            lineW += gap + words[k].width;
+            continue;
+        }
+        out.lineStart.push_back(words[k].start);
+        lineW = words[k].width;
+    }
+    for (size_t l = 0; l < out.lineCount(); ++l) {
+        out.lineWidth.push_back(measure(out.line(l), fontSize));
+        out.width = std::max(out.width, out.lineWidth.back());
+    }
+}
+
+// ---------- Cache ----------
+TextLayoutCache::Entry& TextLayoutCache::find(std::unordered_map<uint64_t, Entry>& map, std::string_view text, int fontSize,
+                                              int maxWidth, bool& hit) {
+    uint64_t key = std::hash<std::string_view>()(text) ^
+                   (((uint64_t)(uint32_t)fontSize << 32 | (uint32_t)maxWidth) * 0x9E3779B97F4A7C15ull);
+    auto it = map.find(key);
+    if (it != map.end() && it->second.fontSize == fontSize && it->second.maxWidth == maxWidth && it->second.source == text) {
+        ++hitCount;
+        hit = true;
+        return it->second;
+    }
+    ++missCount;
+    hit = false;
+    if (it == map.end() && map.size() >= capacity) map.clear();
+    // A colliding key is simply overwritten.
+    Entry& e = map[key];
+    e.source.assign(text.data(), text.size());
+    e.fontSize = fontSize;
+    e.maxWidth = maxWidth;
+    return e;
+}
+
+const TextLayout& TextLayoutCache::wrapped(std::string_view text, int fontSize, float maxWidth) {
+    bool hit;
+    Entry& e = find(layouts, text, fontSize, (int)maxWidth, hit);
+    if (!hit) {
+        PROFILE_COUNT("text layouts", 1);
+        layout_text(text, fontSize, (float)(int)maxWidth, measure, e.layout);
+    }
+    return e.layout;
+}
+
+int TextLayoutCache::width(std::string_view text, int fontSize) {
+    bool hit;
+    Entry& e = find(widths, text, fontSize, 0, hit);
+    if (!hit) e.width = measure(e.source.c_str(), fontSize);
+    return e.width;
+}
+
+void TextLayoutCache::clear() {
+    layouts.clear();
+    widths.clear();
+}
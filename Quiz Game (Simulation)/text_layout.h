@@ -0,0 +1,62 @@
+// Word-wrapped text layout, cached by text, font size and width (no raylib dependency)
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Width in pixels of a NUL-terminated string; raylib's MeasureText in the game.
+using TextMeasureFn = int (*)(const char* text, int fontSize);
+
+// Lines of a wrapped text. Words are joined by single spaces and each line
+// ends in a NUL, so line(i) can go straight to DrawText.
+struct TextLayout {
+    std::string text;
+    std::vector<uint32_t> lineStart;
+    std::vector<int> lineWidth;
+    int width = 0;   // widest line
+
+    size_t lineCount() const { return lineStart.size(); }
+    const char* line(size_t i) const { return text.data() + lineStart[i]; }
+};
+
+// Breaks text at whitespace into lines no wider than maxWidth (a word wider
+// than that gets a line of its own). Each word is measured once and a line's
+// width is its words plus one space between them, so the cost is linear in
+// the text; the finished lines are measured once more for lineWidth.
+void layout_text(std::string_view text, int fontSize, float maxWidth, TextMeasureFn measure, TextLayout& out);
+
+// Layouts and single-line widths, keyed by the text, the font size and (for
+// layouts) the width in whole pixels. A hit costs one hash of the text and one
+// compare, so a drawn question only lays out again when it changes or the
+// window is resized. Entries are dropped all at once when there are more than
+// capacity of them, which takes a few resizes with the quiz's few strings.
+class TextLayoutCache {
+public:
+    explicit TextLayoutCache(TextMeasureFn measure, size_t capacity = 256) : measure(measure), capacity(capacity) {}
+
+    const TextLayout& wrapped(std::string_view text, int fontSize, float maxWidth);
+    // measure(text) for a NUL-terminated text.
+    int width(std::string_view text, int fontSize);
+
+    void clear();
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+private:
+    struct Entry {
+        std::string source;
+        int fontSize = 0, maxWidth = 0;
+        TextLayout layout;   // unused for width entries
+        int width = 0;
+    };
+    Entry& find(std::unordered_map<uint64_t, Entry>& map, std::string_view text, int fontSize, int maxWidth, bool& hit);
+
+    TextMeasureFn measure;
+    size_t capacity;
+    std::unordered_map<uint64_t, Entry> layouts, widths;
+    size_t hitCount = 0, missCount = 0;
+};
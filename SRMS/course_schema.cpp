@@ -0,0 +1,177 @@
+#include "course_schema.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+// ---------- Schema ----------
+string CourseSchema::subjectName(int j) const {
+    if (j >= 0 && j < count() && !subjects[j].name.empty()) return subjects[j].name;
+    return "Subject " + std::to_string(j + 1);
+}
+
+int CourseSchema::maxMark(int j) const {
+    return j >= 0 && j < count() ? subjects[j].maxMark : 100;
+}
+
+double CourseSchema::weight(int j) const {
+    return j >= 0 && j < count() ? subjects[j].weight : 1.0;
+}
+
+int CourseSchema::highestMax() const {
+    int m = 0;
+    for (const SubjectDef& s : subjects) m = std::max(m, s.maxMark);
+    return m;
+}
+
+bool CourseSchema::weighted() const {
+    for (const SubjectDef& s : subjects)
+        if (s.weight != 1.0) return true;
+    return false;
+}
+
+double CourseSchema::maxWeightedTotal() const {
+    double t = 0;
+    for (const SubjectDef& s : subjects) t += s.weight * s.maxMark;
+    return t;
+}
+
+vector<double> CourseSchema::weights(int n) const {
+    vector<double> w(std::max(n, 0), 1.0);
+    for (int j = 0; j < n && j < count(); ++j) w[j] = subjects[j].weight;
+    return w;
+}
+
+const char* CourseSchema::check(const vector<int>& marks) const {
+    if ((int)marks.size() > count()) return "more marks than the course has subjects";
+    for (size_t j = 0; j < marks.size(); ++j)
+        if (marks[j] < 0 || marks[j] > subjects[j].maxMark) return "mark out of range";
+    return nullptr;
+}
+
+CourseSchema default_course(int subjects) {
+    CourseSchema c;
+    c.subjects.resize(std::max(1, std::min(subjects, COURSE_MAX_SUBJECTS)));
+    for (size_t j = 0; j < c.subjects.size(); ++j) c.subjects[j].name = "Subject " + std::to_string(j + 1);
+    return c;
+}
+
+string course_beside(const string& csvPath) {
+    return fs::path(csvPath).replace_extension(".course").string();
+}
+
+// ---------- File Format ----------
+static string trim(const string& s) {
+    size_t a = s.find_first_not_of(" \t\r");
+    if (a == string::npos) return "";
+    size_t b = s.find_last_not_of(" \t\r");
+    return s.substr(a, b - a + 1);
+}
+
+// Any text strtod reads whole, "nan", "inf" and overflow included, so that
+// parse_subject can reject them instead of taking them into the name.
+static bool number(const string& s, double& out) {
+    if (s.empty()) return false;
+    char* end;
+    out = strtod(s.c_str(), &end);
+    return *end == '\0';
+}
+
+// "Name[, max[, weight]]" or, with sep ':', "Name[:max[:weight]]". The name
+// may itself hold sep; the numbers are taken from the right.
+static bool parse_subject(const string& text, char sep, SubjectDef& s, string* why) {
+    vector<string> parts;
+    std::stringstream ss(text);
+    for (string p; std::getline(ss, p, sep);) parts.push_back(trim(p));
+    double nums[2];
+    int k = 0;
+    while (k < 2 && (int)parts.size() > 1 && number(parts.back(), nums[k])) {
+        parts.pop_back();
+        k++;
+    }
+    // Read right to left: [max] or [weight, max].
+    double maxMark = 100, weight = 1;
+    if (k == 1) maxMark = nums[0];
+    if (k == 2) { weight = nums[0]; maxMark = nums[1]; }
+    string name;
+    for (size_t i = 0; i < parts.size(); ++i) name += (i ? string(1, sep) : "") + parts[i];
+    s.name = trim(name);
+    if (s.name.empty()) { if (why) *why = "subject without a name"; return false; }
+    if (!std::isfinite(maxMark) || !std::isfinite(weight)) { if (why) *why = "subject numbers must be finite"; return false; }
+    if (maxMark < 1 || maxMark > 65535 || maxMark != (int)maxMark) { if (why) *why = "maximum mark must be 1..65535"; return false; }
+    if (!(weight >= 0 && weight <= 1000)) { if (why) *why = "weight must be 0..1000"; return false; }
+    s.maxMark = (int)maxMark;
+    s.weight = weight;
+    return true;
+}
+
+bool load_course(const string& path, int defaultSubjects, CourseSchema& out, string* why) {
+    out = default_course(defaultSubjects);
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return true;
+    std::ifstream f(path);
+    if (!f) { if (why) *why = "cannot read " + path; return false; }
+    CourseSchema c;
+    string line;
+    for (int lineNo = 1; std::getline(f, line); ++lineNo) {
+        size_t colon = line.find(':');
+        if (trim(line).empty() || line[0] == '#') continue;
+        string key = colon == string::npos ? "" : trim(line.substr(0, colon));
+        string value = colon == string::npos ? "" : trim(line.substr(colon + 1));
+        if (key == "course name") {
+            c.name = value;
+        } else if (key == "subject") {
+            SubjectDef s;
+            if (!parse_subject(value, ',', s, why)) {
+                if (why) *why = path + ":" + std::to_string(lineNo) + ": " + *why;
+                return false;
+            }
+            c.subjects.push_back(s);
+        } else {
+            if (why) *why = path + ":" + std::to_string(lineNo) + ": unknown line";
+            return false;
+        }
+    }
+    if (c.subjects.empty() || c.count() > COURSE_MAX_SUBJECTS) {
+        if (why) *why = path + ": a course needs 1.." + std::to_string(COURSE_MAX_SUBJECTS) + " subjects";
+        return false;
+    }
+    out = std::move(c);
+    return true;
+}
+
+bool save_course(const string& path, const CourseSchema& c) {
+    string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        if (!c.name.empty()) f << "course name: " << c.name << "\n";
+        for (const SubjectDef& s : c.subjects) f << "subject: " << s.name << ", " << s.maxMark << ", " << s.weight << "\n";
+        if (!f.flush()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+bool parse_subject_list(const string& text, CourseSchema& out, string* why) {
+    CourseSchema c;
+    c.name = out.name;
+    std::stringstream ss(text);
+    for (string item; std::getline(ss, item, ',');) {
+        SubjectDef s;
+        if (!parse_subject(item, ':', s, why)) return false;
+        c.subjects.push_back(s);
+    }
+    if (c.subjects.empty() || c.count() > COURSE_MAX_SUBJECTS) {
+        if (why) *why = "a course needs 1.." + std::to_string(COURSE_MAX_SUBJECTS) + " subjects";
+        return false;
+    }
+    out = std::move(c);
+    return true;
+}
@@ -0,0 +1,47 @@
+// Per-course subject list: names, maximum marks and weights (no raylib dependency)
+
+#pragma once
+#include <string>
+#include <vector>
+
+const int COURSE_MAX_SUBJECTS = 16;
+
+struct SubjectDef {
+    std::string name;
+    int maxMark = 100;
+    double weight = 1.0;
+};
+
+// A course file sits next to its students CSV ("x.csv" -> "x.course"):
+//   course name: B.Sc Physics, year 2
+//   subject: Mathematics, 100, 1
+//   subject: Lab work, 50, 0.5
+// One "subject:" line per subject, in mark-column order; max and weight are
+// optional. Without a file the course has SRMS_DEFAULT_SUBJECTS subjects out
+// of 100, weighted equally, as before.
+struct CourseSchema {
+    std::string name;
+    std::vector<SubjectDef> subjects;
+
+    int count() const { return (int)subjects.size(); }
+    // Subjects past the list (rows with extra marks) are "Subject N" out of 100.
+    std::string subjectName(int j) const;
+    int maxMark(int j) const;
+    double weight(int j) const;
+    int highestMax() const;
+    bool weighted() const;                 // any weight other than 1
+    double maxWeightedTotal() const;
+    // Per-column weights for MarksTable::weightedTotals, padded to n with 1.
+    std::vector<double> weights(int n) const;
+    // Null if marks fit the course, else why not.
+    const char* check(const std::vector<int>& marks) const;
+};
+
+CourseSchema default_course(int subjects);
+std::string course_beside(const std::string& csvPath);
+// A missing file gives default_course(defaultSubjects). False if the file
+// exists but can't be read or a line doesn't parse (why says which).
+bool load_course(const std::string& path, int defaultSubjects, CourseSchema& out, std::string* why = nullptr);
+bool save_course(const std::string& path, const CourseSchema& c);
+// "Maths:100:1,Physics:100:1.5" (max and weight optional), as srms_cli takes it.
+bool parse_subject_list(const std::string& text, CourseSchema& out, std::string* why = nullptr);
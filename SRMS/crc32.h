@@ -0,0 +1,23 @@
+// CRC-32 (IEEE 802.3) of journal and log records (no raylib dependency)
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// The table is a function-local static, so the first calls may come from
+// several threads at once.
+inline uint32_t crc32(const char* data, size_t n) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; ++i) c = table[(c ^ (uint8_t)data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
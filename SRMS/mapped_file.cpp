@@ -0,0 +1,60 @@
+#include "mapped_file.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+
+#ifdef _WIN32
+bool MappedFile::open(const string& path) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(file, &sz)) { CloseHandle(file); return false; }
+    len = (size_t)sz.QuadPart;
+    if (len == 0) { CloseHandle(file); return true; }
+    HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!map) { len = 0; return false; }
+    ptr = (const char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (!ptr) { CloseHandle(map); len = 0; return false; }
+    handle = map;
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) UnmapViewOfFile(ptr);
+    if (handle) CloseHandle((HANDLE)handle);
+    ptr = nullptr; handle = nullptr; len = 0;
+}
+#else
+bool MappedFile::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    len = (size_t)st.st_size;
+    if (len == 0) { ::close(fd); return true; }
+    void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { len = 0; return false; }
+    madvise(p, len, MADV_SEQUENTIAL);
+    ptr = (const char*)p;
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) munmap((void*)ptr, len);
+    ptr = nullptr; len = 0;
+}
+#endif
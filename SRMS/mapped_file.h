@@ -0,0 +1,22 @@
+// Read-only memory-mapped files (no raylib dependency)
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file (mmap / MapViewOfFile). Empty files map to size 0.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+    bool open(const std::string& path);
+    void close();
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+private:
+    const char* ptr = nullptr;
+    size_t len = 0;
+    void* handle = nullptr;
+};
@@ -0,0 +1,204 @@
+#include "marks_table.h"
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+static int width_for(int64_t lo, int64_t hi) {
+    if (lo >= 0 && hi <= UINT8_MAX) return 1;
+    if (lo >= 0 && hi <= UINT16_MAX) return 2;
+    return 4;
+}
+
+void MarksTable::clear() {
+    cols.clear();
+    cnt.clear();
+    tot.clear();
+}
+
+void MarksTable::reserve(size_t n) {
+    cnt.reserve(n);
+    tot.reserve(n);
+    for (auto& c : cols) c.data.reserve(n * c.width);
+}
+
+void MarksTable::resizeRows(size_t n) {
+    cnt.resize(n, 0);
+    tot.resize(n, 0);
+    for (auto& c : cols) c.data.resize(n * c.width, 0);
+}
+
+void MarksTable::ensureSubjects(int n) {
+    while ((int)cols.size() < n) {
+        cols.emplace_back();
+        cols.back().data.reserve(cnt.capacity());
+        cols.back().data.resize(cnt.size(), 0);
+    }
+}
+
+void MarksTable::widen(int subject, int width) {
+    Column& c = cols[subject];
+    if (width <= c.width) return;
+    const size_t n = rows();
+    std::vector<uint8_t> wide;
+    wide.reserve(std::max(c.data.capacity() / c.width, n) * width);
+    wide.resize(n * width);
+    visitColumn(subject, [&](const auto* src) {
+        if (width == 2) std::copy(src, src + n, (uint16_t*)wide.data());
+        else std::copy(src, src + n, (int32_t*)wide.data());
+    });
+    c.data.swap(wide);
+    c.width = (uint8_t)width;
+}
+
+void MarksTable::store(size_t slot, int subject, int value) {
+    Column& c = cols[subject];
+    int w = width_for(value, value);
+    if (w > c.width) widen(subject, w);
+    if (c.width == 1) c.data[slot] = (uint8_t)value;
+    else if (c.width == 2) ((uint16_t*)c.data.data())[slot] = (uint16_t)value;
+    else ((int32_t*)c.data.data())[slot] = value;
+}
+
+void MarksTable::row(size_t slot, std::vector<int>& out) const {
+    out.resize(cnt[slot]);
+    for (int j = 0; j < cnt[slot]; ++j) out[j] = get(slot, j);
+}
+
+void MarksTable::setRow(size_t slot, const std::vector<int>& marks) {
+    int n = (int)std::min<size_t>(marks.size(), UINT16_MAX);
+    ensureSubjects(n);
+    int64_t t = 0;
+    for (int j = 0; j < (int)cols.size(); ++j) {
+        int v = j < n ? marks[j] : 0;
+        store(slot, j, v);
+        t += v;
+    }
+    cnt[slot] = (uint16_t)n;
+    tot[slot] = t;
+}
+
+void MarksTable::appendRow(const std::vector<int>& marks) {
+    resizeRows(rows() + 1);
+    setRow(rows() - 1, marks);
+}
+
+void MarksTable::moveRow(size_t from, size_t to) {
+    for (auto& c : cols) memcpy(&c.data[to * c.width], &c.data[from * c.width], c.width);
+    cnt[to] = cnt[from];
+    tot[to] = tot[from];
+}
+
+void MarksTable::popRow() {
+    cnt.pop_back();
+    tot.pop_back();
+    for (auto& c : cols) c.data.resize(c.data.size() - c.width);
+}
+
+void MarksTable::loadColumn(int subject, const int32_t* src) {
+    const size_t n = rows();
+    int32_t lo = 0, hi = 0;
+    for (size_t i = 0; i < n; ++i) { lo = std::min(lo, src[i]); hi = std::max(hi, src[i]); }
+    Column& c = cols[subject];
+    c.width = (uint8_t)width_for(lo, hi);
+    c.data.assign(n * c.width, 0);
+    if (c.width == 1) std::copy(src, src + n, c.data.data());
+    else if (c.width == 2) std::copy(src, src + n, (uint16_t*)c.data.data());
+    else memcpy(c.data.data(), src, n * 4);
+}
+
+size_t MarksTable::bytes() const {
+    size_t b = cnt.capacity() * sizeof(uint16_t) + tot.capacity() * sizeof(int64_t);
+    for (const auto& c : cols) b += c.data.capacity();
+    return b;
+}
+
+// ---------- Kernels ----------
+template <class T>
+static void add_column(const T* __restrict c, int64_t* __restrict o, size_t n) {
+    for (size_t i = 0; i < n; ++i) o[i] += c[i];
+}
+
+void MarksTable::rowTotals(int64_t* out) const {
+    const size_t n = rows();
+    std::fill(out, out + n, 0);
+    // Column at a time: each pass is a widening vector add over contiguous memory.
+    for (int j = 0; j < subjects(); ++j) visitColumn(j, [&](const auto* c) { add_column(c, out, n); });
+}
+
+template <class T>
+static void add_weighted(const T* __restrict c, double w, double* __restrict o, size_t n) {
+    for (size_t i = 0; i < n; ++i) o[i] += w * (double)c[i];
+}
+
+void MarksTable::weightedTotals(const double* weights, double* out) const {
+    const size_t n = rows();
+    std::fill(out, out + n, 0.0);
+    for (int j = 0; j < subjects(); ++j) {
+        if (weights[j] == 0.0) continue;
+        visitColumn(j, [&](const auto* c) { add_weighted(c, weights[j], out, n); });
+    }
+}
+
+// Rows without this subject hold 0, so sum and sum of squares can run over
+// the raw column. Each reduction gets its own loop: GCC won't vectorize a
+// loop that mixes the uint16 counts with the marks.
+template <class T>
+static void column_stats(const T* __restrict v, const uint16_t* __restrict c, size_t n, int subject, SubjectStats& st) {
+    int64_t present = 0;
+    for (size_t i = 0; i < n; ++i) present += c[i] > subject;
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += v[i];
+    int64_t sumSq = 0;
+    for (size_t i = 0; i < n; ++i) sumSq += (int64_t)v[i] * v[i];
+    T mn = std::numeric_limits<T>::max(), mx = std::numeric_limits<T>::min();
+    if ((size_t)present == n) {
+        for (size_t i = 0; i < n; ++i) { mn = std::min(mn, v[i]); mx = std::max(mx, v[i]); }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            if (c[i] <= subject) continue;
+            mn = std::min(mn, v[i]);
+            mx = std::max(mx, v[i]);
+        }
+    }
+    st.count = (size_t)present;
+    if (present == 0) return;
+    st.sum = sum;
+    st.min = mn;
+    st.max = mx;
+    st.mean = (double)sum / present;
+    double var = (double)sumSq / present - st.mean * st.mean;
+    st.stddev = std::sqrt(std::max(0.0, var));
+}
+
+SubjectStats MarksTable::subjectStats(int subject) const {
+    SubjectStats st;
+    if (subject < 0 || subject >= subjects()) return st;
+    visitColumn(subject, [&](const auto* v) { column_stats(v, cnt.data(), rows(), subject, st); });
+    return st;
+}
+
+template <class T>
+static void column_histogram(const T* v, const uint16_t* c, size_t n, int subject, int lo, int hi, uint32_t* part, int nb) {
+    const int64_t span = (int64_t)hi - lo + 1;
+    for (size_t i = 0; i < n; ++i) {
+        if (c[i] <= subject) continue;
+        int64_t x = std::min<int64_t>(std::max<int64_t>(v[i], lo), hi);
+        int b = (int)((x - lo) * nb / span);
+        part[(i & 3) * nb + b]++;
+    }
+}
+
+std::vector<uint32_t> MarksTable::histogram(int subject, int lo, int hi, int buckets) const {
+    std::vector<uint32_t> out(std::max(buckets, 1), 0);
+    if (subject < 0 || subject >= subjects() || hi < lo) return out;
+    const int nb = (int)out.size();
+    // Four interleaved sub-histograms so consecutive equal marks don't stall
+    // on the same counter.
+    std::vector<uint32_t> part(4 * nb, 0);
+    visitColumn(subject, [&](const auto* v) { column_histogram(v, cnt.data(), rows(), subject, lo, hi, part.data(), nb); });
+    for (int k = 0; k < 4; ++k)
+        for (int b = 0; b < nb; ++b) out[b] += part[k * nb + b];
+    return out;
+}
@@ -0,0 +1,97 @@
+// Column-per-subject marks storage + aggregate kernels (no raylib dependency)
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SubjectStats {
+    size_t count = 0;      // students that have this subject
+    int64_t sum = 0;
+    int min = 0;
+    int max = 0;
+    double mean = 0.0;
+    double stddev = 0.0;   // population
+};
+
+// One contiguous column per subject, indexed by store slot, plus a per-row
+// mark count. Each column is stored 1, 2 or 4 bytes per mark: the narrowest
+// of uint8 / uint16 / int32 that holds every value written to it, widening
+// in place when a larger (or negative) mark arrives. A course marked out of
+// 100 therefore costs one byte per mark. Rows with fewer subjects hold 0 in
+// the missing cells, so totals can simply add whole columns. Each row's total
+// is also cached and kept current by the row setters, so the UI never re-adds
+// marks. The kernels are plain loops over __restrict pointers, instantiated
+// per column width, that GCC/Clang vectorize at -O3; -march=native (AVX2)
+// also vectorizes the 64-bit sum of squares and the weighted sums.
+class MarksTable {
+public:
+    size_t rows() const { return cnt.size(); }
+    int subjects() const { return (int)cols.size(); }
+    void clear();
+    void reserve(size_t n);
+    void resizeRows(size_t n);   // new rows have no marks
+    void ensureSubjects(int n);  // zero-filled columns
+
+    // Row access, for the UI and the file formats.
+    int count(size_t slot) const { return cnt[slot]; }
+    int get(size_t slot, int subject) const {
+        const Column& c = cols[subject];
+        if (c.width == 1) return c.data[slot];
+        if (c.width == 2) return ((const uint16_t*)c.data.data())[slot];
+        return ((const int32_t*)c.data.data())[slot];
+    }
+    void set(size_t slot, int subject, int value) {
+        tot[slot] += (int64_t)value - get(slot, subject);
+        store(slot, subject, value);
+    }
+    void row(size_t slot, std::vector<int>& out) const;
+    void setRow(size_t slot, const std::vector<int>& marks);
+    void appendRow(const std::vector<int>& marks);
+    void moveRow(size_t from, size_t to);
+    void popRow();
+
+    // Bytes per mark in a column: 1, 2 or 4.
+    int width(int subject) const { return cols[subject].width; }
+    // Calls f with the column as const uint8_t*, const uint16_t* or const int32_t*.
+    template <class F> void visitColumn(int subject, F&& f) const {
+        const Column& c = cols[subject];
+        if (c.width == 1) f((const uint8_t*)c.data.data());
+        else if (c.width == 2) f((const uint16_t*)c.data.data());
+        else f((const int32_t*)c.data.data());
+    }
+    const uint16_t* counts() const { return cnt.data(); }
+    // Bulk fill by loaders: a whole column from rows() int32 values, stored at
+    // the narrowest width that holds them. Counts must stay <= subjects().
+    // Call recomputeTotals() afterwards.
+    void loadColumn(int subject, const int32_t* src);
+    uint16_t* countData() { return cnt.data(); }
+    void recomputeTotals() { rowTotals(tot.data()); }
+
+    int64_t rowTotal(size_t slot) const { return tot[slot]; }
+    const int64_t* totals() const { return tot.data(); }
+    // Heap bytes held by marks, counts and cached totals.
+    size_t bytes() const;
+
+    // ---------- Kernels ----------
+    // out[i] = sum of row i, for every row. out must hold rows() values.
+    void rowTotals(int64_t* out) const;
+    // out[i] = sum over subjects of weights[j] * mark; weights holds
+    // subjects() values, out rows() values.
+    void weightedTotals(const double* weights, double* out) const;
+    SubjectStats subjectStats(int subject) const;
+    // Buckets of width (hi - lo + 1) / buckets over [lo, hi]; values outside are clamped.
+    std::vector<uint32_t> histogram(int subject, int lo, int hi, int buckets) const;
+
+private:
+    struct Column {
+        uint8_t width = 1;
+        std::vector<uint8_t> data;   // rows() * width bytes
+    };
+    void store(size_t slot, int subject, int value);
+    void widen(int subject, int width);
+
+    std::vector<Column> cols;
+    std::vector<uint16_t> cnt;
+    std::vector<int64_t> tot;
+};
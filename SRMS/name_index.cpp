@@ -0,0 +1,240 @@
+#include "name_index.h"
+#include <algorithm>
+
+static inline char fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static inline uint32_t gram_at(const char* p) {
+    return (uint32_t)(unsigned char)p[0] << 16 | (uint32_t)(unsigned char)p[1] << 8 | (unsigned char)p[2];
+}
+
+// Bits 0-36 are exact for a-z, 0-9 and space.
+static inline uint64_t char_bit(char c) {
+    if (c >= 'a' && c <= 'z') return 1ull << (c - 'a');
+    if (c >= '0' && c <= '9') return 1ull << (26 + c - '0');
+    if (c == ' ') return 1ull << 36;
+    return 1ull << (37 + (unsigned char)c % 27);
+}
+
+static inline uint64_t char_mask(std::string_view s) {
+    uint64_t m = 0;
+    for (char c : s) m |= char_bit(c);
+    return m;
+}
+
+// Distinct trigrams of an already folded string.
+static void trigrams(std::string_view s, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= s.size(); ++i) out.push_back(gram_at(s.data() + i));
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+static std::string fold_copy(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) c = fold(c);
+    return out;
+}
+
+void NameIndex::clear() {
+    docs.clear();
+    slotDoc.clear();
+    slotMask.clear();
+    arena.clear();
+    lists.clear();
+    common.clear();
+    other.clear();
+    dead = 0;
+}
+
+void NameIndex::reserve(size_t n) {
+    docs.reserve(n);
+    slotDoc.reserve(n);
+    slotMask.reserve(n);
+    arena.reserve(n * 16);
+}
+
+void NameIndex::addDoc(uint32_t slot, std::string_view name) {
+    uint32_t id = (uint32_t)docs.size();
+    uint32_t off = (uint32_t)arena.size();
+    for (char c : name) arena.push_back(fold(c));
+    docs.push_back(Doc{slot, off, (uint32_t)name.size()});
+    slotDoc[slot] = id;
+    std::string_view folded(arena.data() + off, name.size());
+    slotMask[slot] = char_mask(folded);
+    // A repeated trigram finds this id already at the back of its list.
+    for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+        std::vector<uint32_t>& list = postingsFor(gram_at(folded.data() + i));
+        if (list.empty() || list.back() != id) list.push_back(id);
+    }
+}
+
+void NameIndex::add(std::string_view name) {
+    slotDoc.push_back(0);
+    slotMask.push_back(0);
+    addDoc((uint32_t)slotDoc.size() - 1, name);
+}
+
+void NameIndex::retire(uint32_t slot) {
+    docs[slotDoc[slot]].slot = DEAD;
+    dead++;
+}
+
+void NameIndex::rename(uint32_t slot, std::string_view name) {
+    std::string_view old = folded(slot);
+    if (old.size() == name.size() &&
+        std::equal(old.begin(), old.end(), name.begin(), [](char a, char b) { return a == fold(b); }))
+        return;
+    retire(slot);
+    addDoc(slot, name);
+    if (dead > 4096 && dead > slotDoc.size()) compact();
+}
+
+void NameIndex::removeSwap(uint32_t slot) {
+    retire(slot);
+    uint32_t last = (uint32_t)slotDoc.size() - 1;
+    if (slot != last) {
+        slotDoc[slot] = slotDoc[last];
+        slotMask[slot] = slotMask[last];
+        docs[slotDoc[slot]].slot = slot;
+    }
+    slotDoc.pop_back();
+    slotMask.pop_back();
+    if (dead > 4096 && dead > slotDoc.size()) compact();
+}
+
+// Re-adds the live names in slot order under fresh ids.
+void NameIndex::compact() {
+    std::vector<Doc> oldDocs;
+    std::vector<uint32_t> oldSlotDoc;
+    std::string oldArena;
+    oldDocs.swap(docs);
+    oldSlotDoc.swap(slotDoc);
+    oldArena.swap(arena);
+    clear();
+    reserve(oldSlotDoc.size());
+    for (uint32_t d : oldSlotDoc) add(std::string_view(oldArena.data() + oldDocs[d].off, oldDocs[d].len));
+}
+
+// Letters, digits and space (what folded names are mostly made of) as 0-36.
+static inline int name_char(uint32_t c) {
+    if (c - 'a' < 26) return (int)(c - 'a');
+    if (c - '0' < 10) return 26 + (int)(c - '0');
+    return c == ' ' ? 36 : -1;
+}
+
+// Index into the common-trigram table, or -1.
+static inline long common_slot(uint32_t gram) {
+    int a = name_char(gram >> 16), b = name_char((gram >> 8) & 0xff), c = name_char(gram & 0xff);
+    if ((a | b | c) < 0) return -1;
+    return ((long)a * 37 + b) * 37 + c;
+}
+
+const std::vector<uint32_t>* NameIndex::postings(uint32_t gram) const {
+    uint32_t id = 0;
+    long p = common_slot(gram);
+    if (p >= 0) {
+        if (!common.empty()) id = common[p];
+    } else {
+        auto it = other.find(gram);
+        if (it != other.end()) id = it->second;
+    }
+    return id ? &lists[id - 1] : nullptr;
+}
+
+std::vector<uint32_t>& NameIndex::postingsFor(uint32_t gram) {
+    long p = common_slot(gram);
+    uint32_t* id;
+    if (p >= 0) {
+        if (common.empty()) common.assign(37 * 37 * 37, 0);
+        id = &common[p];
+    } else {
+        id = &other[gram];
+    }
+    if (*id == 0) {
+        lists.emplace_back();
+        *id = (uint32_t)lists.size();
+    }
+    return lists[*id - 1];
+}
+
+void NameIndex::substring(std::string_view needle, std::vector<uint32_t>& out) const {
+    out.clear();
+    std::string q = fold_copy(needle);
+    size_t n = slotDoc.size();
+    if (q.size() >= 3) {
+        // Verify the rarest trigram's postings; when even that list covers a
+        // good share of the index a straight scan is cheaper than sorting.
+        std::vector<uint32_t> g;
+        trigrams(q, g);
+        const std::vector<uint32_t>* best = nullptr;
+        for (uint32_t k : g) {
+            const std::vector<uint32_t>* p = postings(k);
+            if (!p) return;
+            if (!best || p->size() < best->size()) best = p;
+        }
+        if (best->size() <= n / 8) {
+            for (uint32_t d : *best) {
+                const Doc& doc = docs[d];
+                if (doc.slot == DEAD) continue;
+                if (std::string_view(arena.data() + doc.off, doc.len).find(q) != std::string_view::npos)
+                    out.push_back(doc.slot);
+            }
+            std::sort(out.begin(), out.end());
+            return;
+        }
+    }
+    if (q.empty()) {
+        out.resize(n);
+        for (size_t i = 0; i < n; ++i) out[i] = (uint32_t)i;
+        return;
+    }
+    uint64_t need = char_mask(q);
+    // One letter, digit or space: the mask alone is the answer.
+    bool exact = q.size() == 1 && need < (1ull << 37);
+    for (size_t i = 0; i < n; ++i) {
+        if ((slotMask[i] & need) != need) continue;
+        if (exact || folded((uint32_t)i).find(q) != std::string_view::npos) out.push_back((uint32_t)i);
+    }
+}
+
+void NameIndex::filter(std::string_view needle, std::vector<uint32_t>& slots) const {
+    std::string q = fold_copy(needle);
+    uint64_t need = char_mask(q);
+    size_t k = 0;
+    for (uint32_t s : slots) {
+        if ((slotMask[s] & need) == need && folded(s).find(q) != std::string_view::npos) slots[k++] = s;
+    }
+    slots.resize(k);
+}
+
+void NameIndex::similar(std::string_view needle, size_t limit, std::vector<uint32_t>& out) const {
+    out.clear();
+    std::string q = fold_copy(needle);
+    std::vector<uint32_t> g;
+    trigrams(q, g);
+    if (g.empty() || limit == 0) return;
+    if (g.size() > 255) g.resize(255);   // shared counts are bytes
+
+    std::vector<uint8_t> shared(docs.size(), 0);
+    for (uint32_t k : g) {
+        const std::vector<uint32_t>* p = postings(k);
+        if (!p) continue;
+        for (uint32_t d : *p) shared[d]++;
+    }
+    // Jaccard similarity of the trigram sets; a name's distinct trigram count
+    // is approximated by len - 2.
+    size_t minShared = std::max<size_t>(1, g.size() / 3);
+    std::vector<std::pair<float, uint32_t>> scored;
+    for (size_t d = 0; d < docs.size(); ++d) {
+        if (shared[d] < minShared || docs[d].slot == DEAD) continue;
+        float own = docs[d].len > 3 ? docs[d].len - 2.0f : 1.0f;
+        float score = shared[d] / (g.size() + own - shared[d]);
+        scored.push_back({-score, docs[d].slot});
+    }
+    size_t k = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + k, scored.end());
+    out.reserve(k);
+    for (size_t i = 0; i < k; ++i) out.push_back(scored[i].second);
+}
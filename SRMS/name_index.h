@@ -0,0 +1,64 @@
+// Trigram index over student names for substring and fuzzy search (no raylib dependency)
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Every name is a document whose id only ever grows, so posting lists are
+// sorted and duplicate-free by construction. Renaming or erasing a student
+// retires its document instead of editing postings; queries skip retired ids
+// and the index compacts itself once they outnumber the live ones. Needles
+// too short for trigrams scan a per-slot character mask instead. Documents
+// map to store slots and follow the store's swap-remove. Matching is on
+// ASCII lower-case.
+class NameIndex {
+public:
+    size_t size() const { return slotDoc.size(); }
+    void clear();
+    void reserve(size_t n);
+    void add(std::string_view name);                    // as slot size()
+    void rename(uint32_t slot, std::string_view name);
+    void removeSwap(uint32_t slot);                     // last slot moves into slot
+    std::string_view folded(uint32_t slot) const {
+        const Doc& d = docs[slotDoc[slot]];
+        return std::string_view(arena.data() + d.off, d.len);
+    }
+
+    // Slots whose name contains needle, in slot order. An empty needle
+    // matches everything.
+    void substring(std::string_view needle, std::vector<uint32_t>& out) const;
+    // Keeps the slots whose name contains needle.
+    void filter(std::string_view needle, std::vector<uint32_t>& slots) const;
+    // Up to limit slots whose names share the most trigrams with needle, best
+    // first. Needles shorter than 3 characters match nothing.
+    void similar(std::string_view needle, size_t limit, std::vector<uint32_t>& out) const;
+
+private:
+    static constexpr uint32_t DEAD = UINT32_MAX;
+    struct Doc {
+        uint32_t slot;   // DEAD once retired
+        uint32_t off;
+        uint32_t len;
+    };
+    void addDoc(uint32_t slot, std::string_view name);
+    void retire(uint32_t slot);
+    void compact();
+    const std::vector<uint32_t>* postings(uint32_t gram) const;
+    std::vector<uint32_t>& postingsFor(uint32_t gram);
+
+    std::vector<Doc> docs;
+    std::vector<uint32_t> slotDoc;
+    // Per slot, one bit per letter, digit and space in the name (other bytes
+    // share the top bits): rules out most names before any compare.
+    std::vector<uint64_t> slotMask;
+    std::string arena;   // folded names back to back, retired ones included
+    // Posting lists by list id. Trigrams of letters, digits and spaces find
+    // their list through a flat 37^3 table; anything else goes through the map.
+    std::vector<std::vector<uint32_t>> lists;
+    std::vector<uint32_t> common;   // list id + 1, 0 = none
+    std::unordered_map<uint32_t, uint32_t> other;
+    size_t dead = 0;
+};
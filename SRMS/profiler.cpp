@@ -0,0 +1,354 @@
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+using std::string;
+using std::vector;
+
+// ---------- Registry ----------
+struct ZoneSlot {
+    const char* name = nullptr;
+    std::atomic<uint64_t> calls{0};
+    std::atomic<int64_t> totalNs{0};
+    std::atomic<int64_t> maxNs{0};
+    // Totals when the current overlay window started.
+    uint64_t windowCalls = 0;
+    int64_t windowNs = 0;
+    // The last finished window, per frame.
+    double msPerFrame = 0, callsPerFrame = 0;
+};
+
+struct CounterSlot {
+    const char* name = nullptr;
+    std::atomic<int64_t> value{0};
+};
+
+struct TraceEvent {
+    int zone;
+    int thread;
+    int64_t startNs, durNs;
+};
+
+// Frame times are kept in 50 us buckets up to 250 ms, plus one for longer.
+static const int FRAME_BUCKETS = 5001;
+static const double FRAME_BUCKET_MS = 0.05;
+static const int RECENT_FRAMES = 240;
+static const double WINDOW_SEC = 0.5;
+static const uint64_t WINDOW_FRAMES = 120;   // headless runs outpace any clock window
+
+static struct Profiler {
+    std::mutex m;   // registration, trace events, frame state
+    ZoneSlot zones[PROFILE_MAX_ZONES];
+    CounterSlot counters[PROFILE_MAX_ZONES];
+    std::atomic<int> zoneCount{0}, counterCount{0};
+
+    std::atomic<bool> tracing{false};
+    vector<TraceEvent> events;
+    size_t maxEvents = 0;
+    int frameZone = -1;
+
+    int64_t lastFrameNs = 0, windowStartNs = 0;
+    uint64_t frames = 0, windowFrames = 0;
+    vector<uint32_t> frameHist = vector<uint32_t>(FRAME_BUCKETS, 0);
+    double maxFrameMs = 0;
+    float recent[RECENT_FRAMES] = {};
+} g_prof;
+
+static const int64_t g_epochNs = profile_now_ns();
+
+int64_t profile_now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+template <class Slot>
+static int register_name(Slot* slots, std::atomic<int>& count, const char* name) {
+    std::lock_guard<std::mutex> lk(g_prof.m);
+    int n = count.load();
+    for (int i = 0; i < n; ++i)
+        if (strcmp(slots[i].name, name) == 0) return i;
+    if (n == PROFILE_MAX_ZONES) return -1;
+    slots[n].name = name;
+    count.store(n + 1);
+    return n;
+}
+
+int profile_zone(const char* name) {
+    return register_name(g_prof.zones, g_prof.zoneCount, name);
+}
+
+int profile_counter(const char* name) {
+    return register_name(g_prof.counters, g_prof.counterCount, name);
+}
+
+void profile_add(int counter, int64_t n) {
+    if (counter >= 0) g_prof.counters[counter].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+static int thread_number() {
+    static std::atomic<int> next{0};
+    thread_local int id = next++;
+    return id;
+}
+
+static void trace_event(int zone, int64_t startNs, int64_t durNs) {
+    std::lock_guard<std::mutex> lk(g_prof.m);
+    if (g_prof.events.size() < g_prof.maxEvents) g_prof.events.push_back({zone, thread_number(), startNs, durNs});
+}
+
+void profile_zone_done(int zone, int64_t startNs) {
+    if (zone < 0) return;
+    int64_t dur = profile_now_ns() - startNs;
+    ZoneSlot& z = g_prof.zones[zone];
+    z.calls.fetch_add(1, std::memory_order_relaxed);
+    z.totalNs.fetch_add(dur, std::memory_order_relaxed);
+    int64_t m = z.maxNs.load(std::memory_order_relaxed);
+    while (dur > m && !z.maxNs.compare_exchange_weak(m, dur, std::memory_order_relaxed)) {}
+    if (g_prof.tracing.load(std::memory_order_relaxed)) trace_event(zone, startNs, dur);
+}
+
+// ---------- Frames ----------
+void profile_frame() {
+    int64_t now = profile_now_ns();
+    Profiler& p = g_prof;
+    std::unique_lock<std::mutex> lk(p.m);
+    if (p.lastFrameNs == 0) {
+        p.lastFrameNs = p.windowStartNs = now;
+        return;
+    }
+    int64_t dur = now - p.lastFrameNs;
+    double ms = dur / 1e6;
+    p.frameHist[std::min(FRAME_BUCKETS - 1, (int)(ms / FRAME_BUCKET_MS))]++;
+    p.maxFrameMs = std::max(p.maxFrameMs, ms);
+    p.recent[p.frames % RECENT_FRAMES] = (float)ms;
+    p.frames++;
+    p.windowFrames++;
+    if (p.tracing && p.events.size() < p.maxEvents) p.events.push_back({p.frameZone, thread_number(), p.lastFrameNs, dur});
+    p.lastFrameNs = now;
+    if (now - p.windowStartNs < (int64_t)(WINDOW_SEC * 1e9) && p.windowFrames < WINDOW_FRAMES) return;
+    int n = p.zoneCount.load();
+    for (int i = 0; i < n; ++i) {
+        ZoneSlot& z = p.zones[i];
+        uint64_t calls = z.calls.load();
+        int64_t ns = z.totalNs.load();
+        z.msPerFrame = (ns - z.windowNs) / 1e6 / p.windowFrames;
+        z.callsPerFrame = (double)(calls - z.windowCalls) / p.windowFrames;
+        z.windowCalls = calls;
+        z.windowNs = ns;
+    }
+    p.windowFrames = 0;
+    p.windowStartNs = now;
+}
+
+static double percentile_of(vector<float>& v, double q) {
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, (size_t)(q * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+FrameTimes profile_frame_times(bool recent) {
+    std::lock_guard<std::mutex> lk(g_prof.m);
+    const Profiler& p = g_prof;
+    FrameTimes t;
+    t.frames = p.frames;
+    if (p.frames == 0) return t;
+    if (recent) {
+        vector<float> v(p.recent, p.recent + std::min<uint64_t>(p.frames, RECENT_FRAMES));
+        t.p50Ms = percentile_of(v, 0.50);
+        t.p95Ms = percentile_of(v, 0.95);
+        t.p99Ms = percentile_of(v, 0.99);
+        t.maxMs = *std::max_element(v.begin(), v.end());
+        return t;
+    }
+    // Upper edge of the bucket holding the q-th frame.
+    auto at = [&](double q) {
+        uint64_t want = std::min<uint64_t>(p.frames - 1, (uint64_t)(q * p.frames)), seen = 0;
+        for (int b = 0; b < FRAME_BUCKETS - 1; ++b) {
+            seen += p.frameHist[b];
+            if (seen > want) return std::min((b + 1) * FRAME_BUCKET_MS, p.maxFrameMs);
+        }
+        return p.maxFrameMs;
+    };
+    t.p50Ms = at(0.50);
+    t.p95Ms = at(0.95);
+    t.p99Ms = at(0.99);
+    t.maxMs = p.maxFrameMs;
+    return t;
+}
+
+// ---------- Reports ----------
+vector<ZoneStats> profile_zones() {
+    vector<ZoneStats> out;
+    std::lock_guard<std::mutex> lk(g_prof.m);
+    int n = g_prof.zoneCount.load();
+    for (int i = 0; i < n; ++i) {
+        const ZoneSlot& z = g_prof.zones[i];
+        if (i == g_prof.frameZone) continue;
+        ZoneStats s;
+        s.name = z.name;
+        s.calls = z.calls;
+        s.totalMs = z.totalNs / 1e6;
+        s.maxUs = z.maxNs / 1e3;
+        s.msPerFrame = z.msPerFrame;
+        s.callsPerFrame = z.callsPerFrame;
+        out.push_back(s);
+    }
+    return out;
+}
+
+vector<std::pair<string, int64_t>> profile_counters() {
+    vector<std::pair<string, int64_t>> out;
+    int n = g_prof.counterCount.load();
+    for (int i = 0; i < n; ++i) out.emplace_back(g_prof.counters[i].name, g_prof.counters[i].value.load());
+    return out;
+}
+
+vector<string> profile_overlay_lines() {
+    vector<string> lines;
+    char buf[160];
+    FrameTimes f = profile_frame_times(true);
+    snprintf(buf, sizeof buf, "frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f  (%.0f fps)", f.p50Ms, f.p95Ms, f.p99Ms, f.maxMs,
+             f.p50Ms > 0 ? 1000.0 / f.p50Ms : 0.0);
+    lines.push_back(buf);
+    vector<ZoneStats> zones = profile_zones();
+    std::sort(zones.begin(), zones.end(), [](const ZoneStats& a, const ZoneStats& b) {
+        return a.msPerFrame != b.msPerFrame ? a.msPerFrame > b.msPerFrame : a.totalMs > b.totalMs;
+    });
+    snprintf(buf, sizeof buf, "%-22s %8s %8s %9s %9s", "zone", "ms/frame", "calls/f", "avg us", "max us");
+    lines.push_back(buf);
+    for (const ZoneStats& z : zones) {
+        snprintf(buf, sizeof buf, "%-22.22s %8.3f %8.2f %9.1f %9.1f", z.name.c_str(), z.msPerFrame, z.callsPerFrame,
+                 z.calls ? z.totalMs * 1e3 / z.calls : 0.0, z.maxUs);
+        lines.push_back(buf);
+    }
+    for (const auto& c : profile_counters()) {
+        snprintf(buf, sizeof buf, "%-22.22s %lld", c.first.c_str(), (long long)c.second);
+        lines.push_back(buf);
+    }
+    return lines;
+}
+
+void profile_trace_start(size_t maxEvents) {
+    int frame = profile_zone("frame");
+    std::lock_guard<std::mutex> lk(g_prof.m);
+    g_prof.frameZone = frame;
+    g_prof.maxEvents = maxEvents;
+    g_prof.events.reserve(std::min<size_t>(maxEvents, 1 << 16));
+    g_prof.tracing = true;
+}
+
+bool profile_tracing() {
+    return g_prof.tracing;
+}
+
+// ---------- Files ----------
+// Zone and counter names are string literals from our own code; only quotes
+// and backslashes need escaping.
+static void put_json_string(string& out, const char* s) {
+    out += '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') out += '\\';
+        out += *s;
+    }
+    out += '"';
+}
+
+static bool write_text(const string& path, const string& text, string* why) {
+    FILE* f = fopen(path.c_str(), "wb");
+    bool ok = f && fwrite(text.data(), 1, text.size(), f) == text.size();
+    if (f) ok = (fclose(f) == 0) && ok;
+    if (!ok && why) *why = "cannot write " + path;
+    return ok;
+}
+
+bool profile_write_json(const string& path, string* why) {
+    string out;
+    char buf[256];
+    FrameTimes f = profile_frame_times(false);
+    snprintf(buf, sizeof buf, "{\n  \"frames\": {\"count\": %llu, \"p50_ms\": %.3f, \"p95_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f},\n",
+             (unsigned long long)f.frames, f.p50Ms, f.p95Ms, f.p99Ms, f.maxMs);
+    out += buf;
+    out += "  \"zones\": [";
+    vector<ZoneStats> zones = profile_zones();
+    for (size_t i = 0; i < zones.size(); ++i) {
+        const ZoneStats& z = zones[i];
+        out += i ? ",\n    {\"name\": " : "\n    {\"name\": ";
+        put_json_string(out, z.name.c_str());
+        snprintf(buf, sizeof buf, ", \"calls\": %llu, \"total_ms\": %.3f, \"avg_us\": %.3f, \"max_us\": %.3f}", (unsigned long long)z.calls,
+                 z.totalMs, z.calls ? z.totalMs * 1e3 / z.calls : 0.0, z.maxUs);
+        out += buf;
+    }
+    out += zones.empty() ? "],\n" : "\n  ],\n";
+    out += "  \"counters\": {";
+    vector<std::pair<string, int64_t>> counters = profile_counters();
+    for (size_t i = 0; i < counters.size(); ++i) {
+        out += i ? ", " : "";
+        put_json_string(out, counters[i].first.c_str());
+        out += ": " + std::to_string(counters[i].second);
+    }
+    out += "}\n}\n";
+    return write_text(path, out, why);
+}
+
+bool profile_write_trace(const string& path, string* why) {
+    string out = "{\"traceEvents\": [\n";
+    char buf[256];
+    vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lk(g_prof.m);
+        events = g_prof.events;
+    }
+    bool first = true;
+    auto sep = [&] {
+        if (!first) out += ",\n";
+        first = false;
+    };
+    int64_t endUs = 0;
+    for (const TraceEvent& e : events) {
+        sep();
+        out += "{\"name\": ";
+        put_json_string(out, g_prof.zones[e.zone].name);
+        int64_t ts = (e.startNs - g_epochNs) / 1000;
+        snprintf(buf, sizeof buf, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %lld, \"dur\": %.3f}", e.thread, (long long)ts,
+                 e.durNs / 1e3);
+        out += buf;
+        endUs = std::max(endUs, ts + e.durNs / 1000);
+    }
+    // Counters have no timeline of their own; their final values go at the end.
+    for (const auto& c : profile_counters()) {
+        sep();
+        out += "{\"name\": ";
+        put_json_string(out, c.first.c_str());
+        snprintf(buf, sizeof buf, ", \"ph\": \"C\", \"pid\": 1, \"tid\": 0, \"ts\": %lld, \"args\": {\"value\": %lld}}", (long long)endUs,
+                 (long long)c.second);
+        out += buf;
+    }
+    out += "\n], \"displayTimeUnit\": \"ms\"}\n";
+    return write_text(path, out, why);
+}
+
+ProfileArgs profile_parse_args(int& argc, char** argv) {
+    ProfileArgs a;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) a.jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) a.tracePath = argv[++i];
+        else argv[kept++] = argv[i];
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+    if (!a.tracePath.empty()) profile_trace_start();
+    return a;
+}
+
+bool profile_write(const ProfileArgs& args, string* why) {
+    bool ok = true;
+    if (!args.jsonPath.empty()) ok = profile_write_json(args.jsonPath, why) && ok;
+    if (!args.tracePath.empty()) ok = profile_write_trace(args.tracePath, why) && ok;
+    return ok;
+}
@@ -0,0 +1,99 @@
+// Scoped timers, counters and frame times for the GUIs and headless runs (no raylib dependency)
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zones and counters are registered once by name (string literals, up to
+// PROFILE_MAX_ZONES of each) and then updated with a couple of relaxed
+// atomics, from any thread. Totals are always collected: a zone costs two
+// clock reads, so zones go on whole operations (a file load, a list draw),
+// not on inner loops. Individual zone runs are only recorded while a trace
+// is on. Build with -DSRMS_NO_PROFILE to compile the macros away.
+//
+//   PROFILE_SCOPE("load_from_file");       times the rest of the block
+//   PROFILE_COUNT("csv bytes read", n);    adds n to a counter
+//   profile_frame();                       once per frame, after EndDrawing()
+const int PROFILE_MAX_ZONES = 64;
+
+int profile_zone(const char* name);
+int profile_counter(const char* name);
+void profile_add(int counter, int64_t n);
+int64_t profile_now_ns();
+void profile_zone_done(int zone, int64_t startNs);
+
+class ProfileScope {
+public:
+    explicit ProfileScope(int zone) : zone(zone), start(profile_now_ns()) {}
+    ~ProfileScope() { profile_zone_done(zone, start); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int zone;
+    int64_t start;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#ifndef SRMS_NO_PROFILE
+#define PROFILE_SCOPE(name)                                                          \
+    static const int PROFILE_JOIN(profileZone_, __LINE__) = profile_zone(name);      \
+    ProfileScope PROFILE_JOIN(profileScope_, __LINE__)(PROFILE_JOIN(profileZone_, __LINE__))
+#define PROFILE_COUNT(name, n)                                                       \
+    do {                                                                             \
+        static const int profileCounter_ = profile_counter(name);                    \
+        profile_add(profileCounter_, (int64_t)(n));                                  \
+    } while (0)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(name, n) ((void)0)
+#endif
+
+// ---------- Frames ----------
+// Marks the end of a frame. Frame time is the gap between calls; each zone's
+// cost per frame is averaged over windows of half a second (or 120 frames,
+// whichever ends first) for the overlay.
+void profile_frame();
+
+struct FrameTimes {
+    uint64_t frames = 0;
+    double p50Ms = 0, p95Ms = 0, p99Ms = 0, maxMs = 0;
+};
+// recent: the last 240 frames; otherwise every frame since the start.
+FrameTimes profile_frame_times(bool recent);
+
+// ---------- Reports ----------
+struct ZoneStats {
+    std::string name;
+    uint64_t calls = 0;
+    double totalMs = 0;
+    double maxUs = 0;
+    double msPerFrame = 0;     // over the last window
+    double callsPerFrame = 0;
+};
+std::vector<ZoneStats> profile_zones();
+std::vector<std::pair<std::string, int64_t>> profile_counters();
+
+// Text for an in-app overlay: frame percentiles, then one line per zone
+// (busiest first), then the counters. Monospace-aligned.
+std::vector<std::string> profile_overlay_lines();
+
+// Zone runs are recorded from here on, up to maxEvents, for a Chrome trace.
+void profile_trace_start(size_t maxEvents = 1 << 20);
+bool profile_tracing();
+
+// {"frames": {...}, "zones": [...], "counters": [...]}
+bool profile_write_json(const std::string& path, std::string* why = nullptr);
+// Chrome trace event format: open in chrome://tracing or ui.perfetto.dev.
+bool profile_write_trace(const std::string& path, std::string* why = nullptr);
+
+// --profile FILE and --trace FILE, shared by the GUIs and srms_cli. Removes
+// them from argv; starts the trace when asked for one.
+struct ProfileArgs {
+    std::string jsonPath, tracePath;
+};
+ProfileArgs profile_parse_args(int& argc, char** argv);
+// Writes whichever files were asked for; false (and why) if one failed.
+bool profile_write(const ProfileArgs& args, std::string* why = nullptr);
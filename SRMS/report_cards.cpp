@@ -0,0 +1,387 @@
+#include "report_cards.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <mutex>
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+static double now_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+const char* grade_for(double percent) {
+    if (percent >= 90) return "A+";
+    if (percent >= 80) return "A";
+    if (percent >= 70) return "B";
+    if (percent >= 60) return "C";
+    if (percent >= 50) return "D";
+    if (percent >= 40) return "E";
+    return "F";
+}
+
+static const char* const GRADES[] = {"A+", "A", "B", "C", "D", "E", "F"};
+static int grade_index(double percent) {
+    static const double floors[] = {90, 80, 70, 60, 50, 40};
+    for (int g = 0; g < 6; ++g)
+        if (percent >= floors[g]) return g;
+    return 6;
+}
+
+// ---------- Formatting ----------
+// printf straight onto the end of out, however long the result.
+static void put(string& out, const char* fmt, ...) {
+    va_list ap, again;
+    va_start(ap, fmt);
+    va_copy(again, ap);
+    size_t at = out.size(), room = 512;
+    out.resize(at + room);
+    int n = vsnprintf(&out[at], room, fmt, ap);
+    if (n >= 0 && (size_t)n >= room) {
+        out.resize(at + n + 1);
+        vsnprintf(&out[at], n + 1, fmt, again);
+    }
+    out.resize(at + std::max(n, 0));
+    va_end(again);
+    va_end(ap);
+}
+
+static void put_html(string& out, std::string_view s) {
+    for (char c : s) {
+        switch (c) {
+        case '&': out += "&amp;"; break;
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        case '"': out += "&quot;"; break;
+        default: out += c;
+        }
+    }
+}
+
+static const char* const HTML_HEAD =
+    "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>%s</title>\n"
+    "<style>body{font-family:sans-serif;margin:2em}table{border-collapse:collapse}"
+    "td,th{border:1px solid #999;padding:2px 8px;text-align:right}td:first-child,th:first-child{text-align:left}"
+    ".card{page-break-after:always;margin-bottom:3em}</style></head><body>\n";
+
+// ---------- Prepared Facts ----------
+// Everything a card needs beyond its own row, computed once before the
+// parallel part so workers only read.
+struct ReportFacts {
+    const vector<StudentInfo>& infos;
+    const MarksTable& marks;
+    const CourseSchema& course;
+    ReportFormat format;
+    vector<uint32_t> byRoll;      // slots in roll order
+    vector<uint32_t> byScore;     // slots best total first, ties by lower roll
+    vector<uint32_t> rank;        // per slot, 1-based
+    vector<float> percentile;     // per slot
+    vector<double> weighted;      // per slot, weighted courses only
+    vector<SubjectStats> stats;   // per subject
+    vector<string> subjectNames;  // HTML-escaped for HTML reports
+};
+
+static void prepare(ReportFacts& f) {
+    const size_t n = f.infos.size();
+    const int64_t* tot = f.marks.totals();
+    f.byRoll.resize(n);
+    for (size_t i = 0; i < n; ++i) f.byRoll[i] = (uint32_t)i;
+    f.byScore = f.byRoll;
+    std::sort(f.byRoll.begin(), f.byRoll.end(), [&](uint32_t a, uint32_t b) { return f.infos[a].roll < f.infos[b].roll; });
+    std::sort(f.byScore.begin(), f.byScore.end(), [&](uint32_t a, uint32_t b) {
+        return tot[a] != tot[b] ? tot[a] > tot[b] : f.infos[a].roll < f.infos[b].roll;
+    });
+    // Percentile as ScoreRanking::percentileOf: share below, ties counting half.
+    f.rank.resize(n);
+    f.percentile.resize(n);
+    for (size_t a = 0; a < n;) {
+        size_t b = a;
+        while (b < n && tot[f.byScore[b]] == tot[f.byScore[a]]) b++;
+        float pct = n ? (float)(100.0 * ((n - b) + 0.5 * (b - a)) / n) : 0.0f;
+        for (size_t k = a; k < b; ++k) {
+            f.rank[f.byScore[k]] = (uint32_t)(k + 1);
+            f.percentile[f.byScore[k]] = pct;
+        }
+        a = b;
+    }
+    if (f.course.weighted()) {
+        vector<double> w = f.course.weights(f.marks.subjects());
+        f.weighted.resize(n);
+        f.marks.weightedTotals(w.data(), f.weighted.data());
+    }
+    for (int j = 0; j < f.marks.subjects(); ++j) {
+        f.stats.push_back(f.marks.subjectStats(j));
+        string name = f.course.subjectName(j);
+        if (f.format == ReportFormat::HTML) {
+            string esc;
+            put_html(esc, name);
+            name = esc;
+        }
+        f.subjectNames.push_back(name);
+    }
+}
+
+static double max_total(const ReportFacts& f, int count) {
+    double m = 0;
+    for (int j = 0; j < count; ++j) m += f.course.maxMark(j);
+    return m;
+}
+
+// ---------- Cards ----------
+static void render_card(const ReportFacts& f, uint32_t slot, string& out) {
+    const StudentInfo& info = f.infos[slot];
+    const int count = f.marks.count(slot);
+    const int64_t total = f.marks.rowTotal(slot);
+    const double maxTot = max_total(f, count);
+    const double pct = maxTot > 0 ? 100.0 * total / maxTot : 0.0;
+    const size_t n = f.infos.size();
+    if (f.format == ReportFormat::TEXT) {
+        out += "================================================================\n";
+        put(out, "REPORT CARD  %s\n", f.course.name.empty() ? "" : f.course.name.c_str());
+        put(out, "Roll %d  %s\n", info.roll, info.name.c_str());
+        out += "----------------------------------------------------------------\n";
+        put(out, "%-28s %6s %6s %6s %12s\n", "Subject", "Mark", "Max", "Grade", "Class mean");
+        for (int j = 0; j < count; ++j) {
+            int mark = f.marks.get(slot, j), mx = f.course.maxMark(j);
+            put(out, "%-28.28s %6d %6d %6s %12.1f\n", f.subjectNames[j].c_str(), mark, mx, grade_for(100.0 * mark / mx),
+                f.stats[j].mean);
+        }
+        out += "----------------------------------------------------------------\n";
+        put(out, "Total %lld / %.0f (%.1f%%)  Grade %s\n", (long long)total, maxTot, pct, grade_for(pct));
+        if (!f.weighted.empty()) put(out, "Weighted %.1f / %.1f\n", f.weighted[slot], f.course.maxWeightedTotal());
+        put(out, "Rank %u of %zu  Percentile %.1f\n\n", f.rank[slot], n, f.percentile[slot]);
+        return;
+    }
+    out += "<section class=\"card\"><h2>Report card";
+    if (!f.course.name.empty()) { out += " &middot; "; put_html(out, f.course.name); }
+    put(out, "</h2>\n<p>Roll %d &middot; ", info.roll);
+    put_html(out, info.name);
+    out += "</p>\n<table><tr><th>Subject</th><th>Mark</th><th>Max</th><th>Grade</th><th>Class mean</th></tr>\n";
+    for (int j = 0; j < count; ++j) {
+        int mark = f.marks.get(slot, j), mx = f.course.maxMark(j);
+        out += "<tr><td>";
+        out += f.subjectNames[j];
+        put(out, "</td><td>%d</td><td>%d</td><td>%s</td><td>%.1f</td></tr>\n", mark, mx, grade_for(100.0 * mark / mx),
+            f.stats[j].mean);
+    }
+    put(out, "</table>\n<p>Total %lld / %.0f (%.1f%%), grade %s", (long long)total, maxTot, pct, grade_for(pct));
+    if (!f.weighted.empty()) put(out, "<br>Weighted %.1f / %.1f", f.weighted[slot], f.course.maxWeightedTotal());
+    put(out, "<br>Rank %u of %zu, percentile %.1f</p></section>\n", f.rank[slot], n, f.percentile[slot]);
+}
+
+// ---------- Class Report ----------
+static void render_class_report(const ReportFacts& f, size_t topK, string& out) {
+    const size_t n = f.infos.size();
+    const bool html = f.format == ReportFormat::HTML;
+    time_t now = time(nullptr);
+    char when[32];
+    strftime(when, sizeof when, "%Y-%m-%d %H:%M", localtime(&now));
+    string title = f.course.name.empty() ? "Class report" : "Class report: " + f.course.name;
+
+    size_t grades[7] = {0};
+    for (size_t i = 0; i < n; ++i) {
+        double mx = max_total(f, f.marks.count(i));
+        grades[grade_index(mx > 0 ? 100.0 * f.marks.rowTotal(i) / mx : 0.0)]++;
+    }
+
+    if (html) {
+        string esc;
+        put_html(esc, title);
+        put(out, HTML_HEAD, esc.c_str());
+        put(out, "<h1>%s</h1>\n<p>%zu students, generated %s</p>\n", esc.c_str(), n, when);
+        out += "<h2>Subjects</h2>\n<table><tr><th>Subject</th><th>Max</th><th>Weight</th><th>Count</th><th>Min</th>"
+               "<th>Max mark</th><th>Mean</th><th>Std dev</th></tr>\n";
+    } else {
+        put(out, "%s\n%zu students, generated %s\n\n", title.c_str(), n, when);
+        put(out, "%-28s %6s %6s %10s %6s %6s %8s %8s\n", "Subject", "Max", "Weight", "Count", "Min", "High", "Mean", "Stddev");
+    }
+    for (size_t j = 0; j < f.stats.size(); ++j) {
+        const SubjectStats& s = f.stats[j];
+        const char* fmt = html ? "<tr><td>%s</td><td>%d</td><td>%g</td><td>%zu</td><td>%d</td><td>%d</td><td>%.2f</td><td>%.2f</td></tr>\n"
+                               : "%-28.28s %6d %6g %10zu %6d %6d %8.2f %8.2f\n";
+        put(out, fmt, f.subjectNames[j].c_str(), f.course.maxMark((int)j), f.course.weight((int)j), s.count, s.min, s.max,
+            s.mean, s.stddev);
+    }
+
+    // Ten buckets over each subject's 0..max.
+    out += html ? "</table>\n<h2>Distributions</h2>\n" : "\nDistributions\n";
+    for (size_t j = 0; j < f.stats.size(); ++j) {
+        int mx = f.course.maxMark((int)j);
+        vector<uint32_t> h = f.marks.histogram((int)j, 0, mx, 10);
+        uint32_t peak = std::max<uint32_t>(1, *std::max_element(h.begin(), h.end()));
+        if (html) put(out, "<h3>%s</h3>\n<table>\n", f.subjectNames[j].c_str());
+        else put(out, "%s (out of %d)\n", f.subjectNames[j].c_str(), mx);
+        for (int b = 0; b < 10; ++b) {
+            // The marks histogram() puts in bucket b.
+            int lo = (int)(((int64_t)b * (mx + 1) + 9) / 10), hi = (int)(((int64_t)(b + 1) * (mx + 1) + 9) / 10) - 1;
+            if (lo > hi) continue;   // maxima under 9 leave some buckets empty
+            int bar = (int)(40.0 * h[b] / peak);
+            if (html) put(out, "<tr><td>%d&ndash;%d</td><td>%u</td><td style=\"text-align:left\"><div style=\"background:#48c;height:1em;width:%dpx\"></div></td></tr>\n",
+                          lo, hi, h[b], bar * 8);
+            else put(out, "  %5d-%-5d %9u  %.*s\n", lo, hi, h[b], bar, "########################################");
+        }
+        out += html ? "</table>\n" : "\n";
+    }
+
+    out += html ? "<h2>Grades</h2>\n<table>\n" : "Grades (total as a share of the maximum)\n";
+    for (int g = 0; g < 7; ++g)
+        put(out, html ? "<tr><td>%s</td><td>%zu</td></tr>\n" : "  %-3s %10zu\n", GRADES[g], grades[g]);
+
+    out += html ? "</table>\n<h2>Top students</h2>\n<table><tr><th>Rank</th><th>Roll</th><th>Name</th><th>Total</th><th>Percent</th></tr>\n"
+                : "\nTop students\n";
+    for (size_t k = 0; k < topK && k < n; ++k) {
+        uint32_t slot = f.byScore[k];
+        double mx = max_total(f, f.marks.count(slot));
+        double pct = mx > 0 ? 100.0 * f.marks.rowTotal(slot) / mx : 0.0;
+        if (html) {
+            put(out, "<tr><td>%zu</td><td>%d</td><td>", k + 1, f.infos[slot].roll);
+            put_html(out, f.infos[slot].name);
+            put(out, "</td><td>%lld</td><td>%.1f</td></tr>\n", (long long)f.marks.rowTotal(slot), pct);
+        } else {
+            put(out, "  %4zu. %-10d %-28.28s %8lld %6.1f%%\n", k + 1, f.infos[slot].roll, f.infos[slot].name.c_str(),
+                (long long)f.marks.rowTotal(slot), pct);
+        }
+    }
+    if (html) out += "</table>\n</body></html>\n";
+}
+
+// ---------- Writer ----------
+static const size_t FLUSH_BYTES = 1 << 20;
+
+bool write_reports(const vector<StudentInfo>& infos, const MarksTable& marks, const CourseSchema& course, const string& outDir,
+                   const ReportOptions& opt, ReportResult& result, ReportProgress* progress) {
+    result = ReportResult();
+    double t0 = now_sec();
+    std::error_code ec;
+    fs::create_directories(outDir, ec);
+    if (!fs::is_directory(outDir, ec)) {
+        result.error = "cannot create " + outDir;
+        return false;
+    }
+    const bool html = opt.format == ReportFormat::HTML;
+    const char* ext = html ? ".html" : ".txt";
+    // Card files from an earlier, larger run would otherwise linger. Only
+    // names this writer makes go: outDir may hold the user's own files.
+    auto is_card_file = [](const string& name) {
+        size_t dot = name.find('.');
+        if (dot == string::npos || dot < 12 || name.compare(0, 6, "cards-") != 0) return false;
+        for (size_t i = 6; i < dot; ++i)
+            if (name[i] < '0' || name[i] > '9') return false;
+        return name.compare(dot, string::npos, ".txt") == 0 || name.compare(dot, string::npos, ".html") == 0;
+    };
+    for (auto& e : fs::directory_iterator(outDir, ec))
+        if (e.is_regular_file(ec) && is_card_file(e.path().filename().string())) fs::remove(e.path(), ec);
+
+    ReportFacts f{infos, marks, course, opt.format, {}, {}, {}, {}, {}, {}, {}};
+    prepare(f);
+    const size_t n = infos.size();
+    const size_t perFile = std::max<size_t>(opt.cardsPerFile, 1);
+    const size_t files = (n + perFile - 1) / perFile;
+    if (progress) progress->total = n;
+    double t1 = now_sec();
+    result.prepareSec = t1 - t0;
+
+    std::mutex errMutex;
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<size_t> cards{0};
+    auto fail = [&](const string& why) {
+        std::lock_guard<std::mutex> lk(errMutex);
+        if (result.error.empty()) result.error = why;
+    };
+    WorkStealingPool pool(opt.threads);
+    vector<string> buffers(pool.size());
+    pool.run(files, [&](size_t file, unsigned worker) {
+        char name[32];
+        snprintf(name, sizeof name, "cards-%06zu%s", file + 1, ext);
+        string path = (fs::path(outDir) / name).string();
+        FILE* fp = fopen(path.c_str(), "wb");
+        if (!fp) { fail("cannot write " + path); return; }
+        string& buf = buffers[worker];
+        buf.clear();
+        buf.reserve(FLUSH_BYTES + 4096);
+        if (html) put(buf, HTML_HEAD, "Report cards");
+        bool ok = true;
+        uint64_t written = 0;
+        size_t lo = file * perFile, hi = std::min(n, lo + perFile), reported = lo;
+        for (size_t k = lo; k < hi; ++k) {
+            render_card(f, f.byRoll[k], buf);
+            if (buf.size() >= FLUSH_BYTES) {
+                ok = ok && fwrite(buf.data(), 1, buf.size(), fp) == buf.size();
+                written += buf.size();
+                buf.clear();
+            }
+            if (progress && (k + 1 - reported >= 256 || k + 1 == hi)) {
+                progress->cards += k + 1 - reported;
+                reported = k + 1;
+            }
+        }
+        if (html) buf += "</body></html>\n";
+        ok = ok && fwrite(buf.data(), 1, buf.size(), fp) == buf.size();
+        written += buf.size();
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok) fail("cannot write " + path);
+        bytes += written;
+        cards += hi - lo;
+        if (progress) {
+            progress->bytes += written;
+            progress->files++;
+        }
+    });
+    result.steals = pool.steals();
+
+    string report;
+    render_class_report(f, opt.topK, report);
+    string path = (fs::path(outDir) / (string("class-report") + ext)).string();
+    FILE* fp = fopen(path.c_str(), "wb");
+    bool ok = fp && fwrite(report.data(), 1, report.size(), fp) == report.size();
+    if (fp) ok = (fclose(fp) == 0) && ok;
+    if (!ok) fail("cannot write " + path);
+
+    result.cards = cards;
+    result.files = files + 1;
+    result.bytes = bytes + report.size();
+    result.renderSec = now_sec() - t1;
+    result.ok = result.error.empty();
+    if (progress) progress->files++;
+    return result.ok;
+}
+
+// ---------- Background Job ----------
+ReportJob::~ReportJob() {
+    if (worker.joinable()) worker.join();
+}
+
+bool ReportJob::start(const StudentStore& db, const CourseSchema& course, const string& outDir, const ReportOptions& opt) {
+    if (worker.joinable()) return false;
+    done = false;
+    prog.total = db.size();
+    prog.cards = 0;
+    prog.bytes = 0;
+    prog.files = 0;
+    startSec = now_sec();
+    // The copy is what keeps the UI free to edit while cards render.
+    worker = std::thread([this, infos = db.infos(), marks = db.marks(), course, outDir, opt]() {
+        write_reports(infos, marks, course, outDir, opt, res, &prog);
+        done = true;
+    });
+    return true;
+}
+
+double ReportJob::elapsed() const {
+    return now_sec() - startSec;
+}
+
+bool ReportJob::finish(ReportResult& result) {
+    if (!worker.joinable() || !done) return false;
+    worker.join();
+    result = std::move(res);
+    return true;
+}
@@ -0,0 +1,77 @@
+// Term-end report cards and class reports, rendered in parallel (no raylib dependency)
+
+#pragma once
+#include "course_schema.h"
+#include "student_store.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ReportFormat { TEXT, HTML };
+
+struct ReportOptions {
+    ReportFormat format = ReportFormat::TEXT;
+    unsigned threads = 0;          // 0 = std::thread::hardware_concurrency()
+    size_t cardsPerFile = 10000;   // cards go in roll order, this many to a file
+    size_t topK = 20;              // students listed in the class report
+};
+
+// Counters a UI or CLI can poll while write_reports runs.
+struct ReportProgress {
+    std::atomic<size_t> total{0};   // cards to write, set before the first one
+    std::atomic<size_t> cards{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<size_t> files{0};
+};
+
+struct ReportResult {
+    bool ok = false;
+    std::string error;            // first failure, when !ok
+    size_t cards = 0;
+    size_t files = 0;             // card files plus the class report
+    uint64_t bytes = 0;
+    double prepareSec = 0;        // ranks, percentiles and class statistics
+    double renderSec = 0;         // cards, rendered and written
+    size_t steals = 0;            // tasks the pool moved between threads
+};
+
+// Letter grade for a percentage: A+ from 90, A 80, B 70, C 60, D 50, E 40, else F.
+const char* grade_for(double percent);
+
+// Writes into outDir (created if missing):
+//   cards-000001.txt ...   report cards in roll order, cardsPerFile per file
+//   class-report.txt       per-subject statistics and mark distributions,
+//                          grade counts and the topK students
+// (.html with ReportFormat::HTML: one printable page per card). Card files
+// left by an earlier run are removed; nothing else in outDir is touched.
+// Each card lists every subject with its mark, maximum, grade and the class
+// mean, then total, weighted total for weighted courses, rank and
+// percentile. Ranks match StudentStore::rankOf. Card files are rendered on a WorkStealingPool,
+// each through its own 1 MB buffer. Takes the columns rather than a store,
+// like the snapshot writers, so a copy can be rendered off the UI thread.
+bool write_reports(const std::vector<StudentInfo>& infos, const MarksTable& marks, const CourseSchema& course,
+                   const std::string& outDir, const ReportOptions& opt, ReportResult& result,
+                   ReportProgress* progress = nullptr);
+
+// Runs write_reports on a copy of the store on a worker thread; the UI polls
+// progress() and finish() each frame.
+class ReportJob {
+public:
+    ~ReportJob();
+    bool running() const { return worker.joinable(); }
+    // False if a job is already running.
+    bool start(const StudentStore& db, const CourseSchema& course, const std::string& outDir, const ReportOptions& opt);
+    const ReportProgress& progress() const { return prog; }
+    double elapsed() const;
+    // Once the job is done: fills result and returns true.
+    bool finish(ReportResult& result);
+
+private:
+    std::thread worker;
+    std::atomic<bool> done{false};
+    ReportProgress prog;
+    ReportResult res;
+    double startSec = 0;
+};
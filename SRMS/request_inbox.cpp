@@ -0,0 +1,373 @@
+#include "request_inbox.h"
+#include "profiler.h"
+#include "student_io.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+// ---------- Line Format ----------
+template <class T>
+static bool take_int(std::string_view& s, T& out) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    if (r.ec != std::errc()) return false;
+    s.remove_prefix(r.ptr - s.data());
+    return true;
+}
+
+static bool eat(std::string_view& s, std::string_view prefix) {
+    if (s.substr(0, prefix.size()) != prefix) return false;
+    s.remove_prefix(prefix.size());
+    return true;
+}
+
+// "Roll <n>[ [<time>]][ resolved]: <message>"
+static bool parse_request(std::string_view s, RequestRecord& r, std::string_view& msg) {
+    if (!eat(s, "Roll ") || !take_int(s, r.roll)) return false;
+    r.time = 0;
+    r.status = RequestStatus::OPEN;
+    if (eat(s, " [") && (!take_int(s, r.time) || !eat(s, "]"))) return false;
+    if (eat(s, " resolved")) r.status = RequestStatus::RESOLVED;
+    if (!eat(s, ":")) return false;
+    eat(s, " ");
+    msg = s;
+    return true;
+}
+
+static void format_request(string& out, int roll, int64_t time, bool resolved, std::string_view msg) {
+    char head[64];
+    int n = time ? snprintf(head, sizeof head, "Roll %d [%lld]%s: ", roll, (long long)time, resolved ? " resolved" : "")
+                 : snprintf(head, sizeof head, "Roll %d%s: ", roll, resolved ? " resolved" : "");
+    out.append(head, n);
+    for (char c : msg) out += (c == '\n' || c == '\r') ? ' ' : c;
+    out += '\n';
+}
+
+// ---------- Lock ----------
+// requests.txt.lock, not requests.txt: compaction renames a new file over
+// that one, and a lock on the old file would no longer exclude anybody. If
+// the lock file can't be opened the writer goes ahead unlocked.
+class InboxLock {
+public:
+    InboxLock(const string& path, bool exclusive) {
+        string lockPath = path + ".lock";
+#ifdef _WIN32
+        h = CreateFileA(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        OVERLAPPED ov = {};
+        if (h != INVALID_HANDLE_VALUE && !LockFileEx(h, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &ov)) {
+            CloseHandle(h);
+            h = INVALID_HANDLE_VALUE;
+        }
+#else
+        fd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) return;
+        int r;
+        while ((r = flock(fd, exclusive ? LOCK_EX : LOCK_SH)) != 0 && errno == EINTR) {}
+        if (r != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+    ~InboxLock() {
+#ifdef _WIN32
+        if (h == INVALID_HANDLE_VALUE) return;
+        OVERLAPPED ov = {};
+        UnlockFileEx(h, 0, 1, 0, &ov);
+        CloseHandle(h);
+#else
+        if (fd >= 0) ::close(fd);   // releases the flock
+#endif
+    }
+    InboxLock(const InboxLock&) = delete;
+    InboxLock& operator=(const InboxLock&) = delete;
+
+private:
+#ifdef _WIN32
+    HANDLE h = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+static bool append_line(const string& path, const string& line) {
+    FILE* f = fopen(path.c_str(), "ab");
+    if (!f) return false;
+    bool ok = fwrite(line.data(), 1, line.size(), f) == line.size();
+    return (fclose(f) == 0) && ok;
+}
+
+bool append_request(const string& path, int roll, std::string_view msg) {
+    string line;
+    format_request(line, roll, (int64_t)std::time(nullptr), false, msg);
+    InboxLock lock(path, false);
+    return append_line(path, line);
+}
+
+// A plain stat: poll() runs every frame and this allocates nothing. The inode
+// tells a file compacted elsewhere from one that grew (Windows reports none,
+// so there only shrinking shows).
+static uint64_t file_size_or_zero(const string& path, uint64_t* ino = nullptr) {
+#ifdef _WIN32
+    struct _stat64 st;
+    bool ok = _stat64(path.c_str(), &st) == 0;
+    if (ino) *ino = 0;
+#else
+    struct stat st;
+    bool ok = ::stat(path.c_str(), &st) == 0;
+    if (ino) *ino = ok ? (uint64_t)st.st_ino : 0;
+#endif
+    return ok ? (uint64_t)st.st_size : 0;
+}
+
+// ---------- Rows ----------
+void RequestRows::clear() {
+    recs.clear();
+    gone.clear();
+    tree.assign(1, 0);
+    live = 0;
+}
+
+void RequestRows::push(uint32_t rec) {
+    recs.push_back(rec);
+    gone.push_back(0);
+    live++;
+    size_t cap = tree.size() - 1;
+    if (recs.size() > cap) {
+        // Rebuilt at twice the size in O(N): each node adds itself to its parent.
+        cap = std::max<size_t>(64, cap * 2);
+        tree.assign(cap + 1, 0);
+        for (size_t i = 1; i <= recs.size(); ++i) tree[i] += !gone[i - 1];
+        for (size_t i = 1; i <= cap; ++i) {
+            size_t up = i + (i & (0 - i));
+            if (up <= cap) tree[up] += tree[i];
+        }
+        return;
+    }
+    for (size_t i = recs.size(); i <= cap; i += i & (0 - i)) tree[i]++;
+}
+
+void RequestRows::remove(uint32_t rec) {
+    auto it = std::lower_bound(recs.begin(), recs.end(), rec);
+    size_t pos = (size_t)(it - recs.begin());
+    if (it == recs.end() || *it != rec || gone[pos]) return;
+    gone[pos] = 1;
+    live--;
+    for (size_t i = pos + 1; i < tree.size(); i += i & (0 - i)) tree[i]--;
+}
+
+size_t RequestRows::nth(size_t k) const {
+    // Walk down from the highest power of two: the largest prefix holding
+    // at most k live records ends just before the one wanted.
+    size_t cap = tree.size() - 1, pos = 0, step = 1;
+    while (step * 2 <= cap) step *= 2;
+    for (; step; step /= 2) {
+        if (pos + step <= cap && tree[pos + step] <= k) {
+            pos += step;
+            k -= tree[pos];
+        }
+    }
+    return pos;
+}
+
+// ---------- Inbox ----------
+void RequestInbox::reset() {
+    recs.clear();
+    arena.clear();
+    offset = 0;
+    open = deleted = statusLines = 0;
+    fileIno = 0;
+    rowList.clear();
+    rowScanned = 0;
+    rev++;
+    gen++;
+}
+
+bool RequestInbox::load() {
+    PROFILE_SCOPE("RequestInbox::load");
+    reset();
+    std::error_code ec;
+    if (!fs::exists(file, ec)) return true;
+    file_size_or_zero(file, &fileIno);
+    MappedFile f;
+    if (!f.open(file)) return false;
+    PROFILE_COUNT("inbox bytes read", f.size());
+    offset = parse(f.data(), f.size(), 0);
+    return true;
+}
+
+bool RequestInbox::poll() {
+    PROFILE_SCOPE("RequestInbox::poll");
+    uint64_t ino;
+    uint64_t size = file_size_or_zero(file, &ino);   // gone: same as emptied
+    if (size == offset && ino == fileIno) return false;
+    if (size < offset || (fileIno && ino != fileIno)) {   // rewritten or truncated elsewhere
+        load();
+        return true;
+    }
+    fileIno = ino;
+    std::ifstream f(file, std::ios::binary);
+    if (!f) return false;
+    f.seekg((std::streamoff)offset);
+    string buf(size - offset, '\0');
+    f.read(&buf[0], (std::streamsize)buf.size());
+    buf.resize((size_t)f.gcount());
+    PROFILE_COUNT("inbox bytes read", buf.size());
+    size_t used = parse(buf.data(), buf.size(), offset);
+    offset += used;
+    return used > 0;
+}
+
+// Parses whole lines only; returns the bytes consumed.
+size_t RequestInbox::parse(const char* p, size_t n, uint64_t base) {
+    const char* begin = p;
+    const char* end = p + n;
+    RequestRecord r;
+    std::string_view msg;
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        if (!nl) break;   // a line still being written; picked up by the next poll
+        std::string_view line(p, nl - p);
+        uint64_t id = base + (uint64_t)(p - begin);
+        p = nl + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        if (line[0] == '!') {
+            uint64_t target;
+            std::string_view s = line;
+            if (eat(s, "!resolve ") && take_int(s, target)) applyStatus(target, RequestStatus::RESOLVED);
+            else if (eat(s, "!delete ") && take_int(s, target)) applyStatus(target, RequestStatus::DELETED);
+            statusLines++;
+            continue;
+        }
+        if (!parse_request(line, r, msg)) {
+            r = RequestRecord();
+            msg = line;
+        }
+        r.id = id;
+        r.textOff = (uint32_t)arena.size();
+        r.textLen = (uint32_t)msg.size();
+        arena.append(msg.data(), msg.size());
+        if (r.status == RequestStatus::OPEN) open++;
+        recs.push_back(r);
+    }
+    if (p != begin) rev++;
+    return (size_t)(p - begin);
+}
+
+void RequestInbox::applyStatus(uint64_t id, RequestStatus st) {
+    auto it = std::lower_bound(recs.begin(), recs.end(), id,
+                               [](const RequestRecord& r, uint64_t v) { return r.id < v; });
+    if (it == recs.end() || it->id != id || it->status == RequestStatus::DELETED || it->status == st) return;
+    if (it->status == RequestStatus::OPEN) open--;
+    if (st == RequestStatus::DELETED) deleted++;
+    it->status = st;
+    // Leaves the list unless it is a resolved request and those are shown.
+    uint32_t rec = (uint32_t)(it - recs.begin());
+    if (rec < rowScanned && (st == RequestStatus::DELETED || !rowResolved)) rowList.remove(rec);
+}
+
+// The status line is written under the lock after a poll(), so rec's id is
+// still the file's: a compaction elsewhere can neither be missed nor start
+// before the line is in.
+bool RequestInbox::appendStatus(size_t rec, const char* verb, RequestStatus unless) {
+    InboxLock lock(file, false);
+    uint64_t before = gen;
+    poll();
+    if (gen != before || rec >= recs.size() || recs[rec].status == unless || recs[rec].status == RequestStatus::DELETED)
+        return false;
+    bool ok = append_line(file, verb + std::to_string(recs[rec].id) + "\n");
+    poll();
+    return ok;
+}
+
+bool RequestInbox::append(int roll, std::string_view msg) {
+    bool ok = append_request(file, roll, msg);
+    poll();
+    return ok;
+}
+
+bool RequestInbox::resolve(size_t rec) {
+    return appendStatus(rec, "!resolve ", RequestStatus::RESOLVED);
+}
+
+bool RequestInbox::remove(size_t rec) {
+    return appendStatus(rec, "!delete ", RequestStatus::DELETED);
+}
+
+bool RequestInbox::clear() {
+    InboxLock lock(file, true);
+    bool ok = (bool)std::ofstream(file, std::ios::trunc);
+    reset();
+    file_size_or_zero(file, &fileIno);
+    return ok;
+}
+
+bool RequestInbox::maybeCompact() {
+    size_t dead = deleted + statusLines;
+    if (dead <= 4096 || dead <= liveCount()) return false;
+    return compact();
+}
+
+bool RequestInbox::compact() {
+    // Exclusive from the last read to the rename: any line another process
+    // appends goes either into what is read here or into the new file.
+    InboxLock lock(file, true);
+    poll();
+    string tmp = file + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    string buf;
+    bool ok = true;
+    for (size_t i = 0; ok && i < recs.size(); ++i) {
+        const RequestRecord& r = recs[i];
+        if (r.status == RequestStatus::DELETED) continue;
+        format_request(buf, r.roll, r.time, r.status == RequestStatus::RESOLVED, text(i));
+        if (buf.size() >= (1 << 20)) {
+            ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+            buf.clear();
+        }
+    }
+    ok = ok && fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    ok = (fclose(f) == 0) && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return load();
+}
+
+const RequestRows& RequestInbox::rows(bool withResolved) {
+    if (withResolved != rowResolved) {
+        rowList.clear();
+        rowScanned = 0;
+        rowResolved = withResolved;
+    }
+    for (size_t i = rowScanned; i < recs.size(); ++i) {
+        RequestStatus st = recs[i].status;
+        if (st == RequestStatus::OPEN || (withResolved && st == RequestStatus::RESOLVED)) rowList.push((uint32_t)i);
+    }
+    rowScanned = recs.size();
+    return rowList;
+}
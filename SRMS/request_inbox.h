@@ -0,0 +1,119 @@
+// requests.txt inbox: structured records, offset tailing, resolve/delete (no raylib dependency)
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// requests.txt is append-only, one line per entry:
+//   Roll <n> [<unix time>]: <message>             a request
+//   Roll <n> [<unix time>] resolved: <message>    a resolved request (written by compaction)
+//   Roll <n>: <message>                           a request from older builds (time 0)
+//   !resolve <id>  /  !delete <id>                status changes
+// A request's id is the byte offset of its line, so ids grow with the file
+// and status lines can name any request without rewriting it. Lines that
+// match none of these are kept as requests with roll -1.
+//
+// Writers lock requests.txt.lock: shared to append, exclusive to compact or
+// clear, so no process's line can land in a file that is being replaced.
+
+enum class RequestStatus : uint8_t { OPEN, RESOLVED, DELETED };
+
+struct RequestRecord {
+    uint64_t id = 0;        // byte offset of the request line
+    int roll = -1;
+    int64_t time = 0;       // unix seconds, 0 if unknown
+    RequestStatus status = RequestStatus::OPEN;
+    uint32_t textOff = 0;   // message, in the inbox's text arena
+    uint32_t textLen = 0;
+};
+
+// Record numbers in display order, newest first. Stored oldest first, so a
+// new request is a push_back. A record that leaves the list stays as a
+// tombstone; a Fenwick tree over the live flags finds the row-th live one
+// and takes one out in O(log N) each.
+class RequestRows {
+public:
+    size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+    uint32_t operator[](size_t row) const { return recs[nth(live - 1 - row)]; }
+
+private:
+    friend class RequestInbox;
+    void clear();
+    void push(uint32_t rec);
+    void remove(uint32_t rec);   // no-op if rec isn't listed
+    size_t nth(size_t k) const;  // position of the k-th live record, from 0
+
+    std::vector<uint32_t> recs;   // ascending, tombstones included
+    std::vector<uint8_t> gone;    // per position
+    std::vector<uint32_t> tree = std::vector<uint32_t>(1);   // Fenwick over !gone, 1-based; capacity size() - 1
+    size_t live = 0;
+};
+
+// Appends one request line; newlines in msg become spaces.
+bool append_request(const std::string& path, int roll, std::string_view msg);
+
+// The whole file parsed once into flat records; afterwards poll() reads only
+// the bytes appended since (one stat when nothing changed) and reloads in
+// full only if the file shrank or was replaced. Resolve and delete append a
+// status line and apply it the same way, so another process sharing the file
+// sees them too.
+class RequestInbox {
+public:
+    explicit RequestInbox(std::string path) : file(std::move(path)) {}
+
+    // False if the file exists but can't be read. A missing file is empty.
+    bool load();
+    // True if anything changed since the last load()/poll().
+    bool poll();
+
+    bool append(int roll, std::string_view msg);
+    // False if rec is already resolved (deleted), or if the file was
+    // compacted elsewhere since rec was read: record numbers then name other
+    // requests, so look again after generation() changes.
+    bool resolve(size_t rec);
+    bool remove(size_t rec);
+    // Truncates the file.
+    bool clear();
+    // Rewrites the file without deleted requests and status lines once those
+    // outnumber the live requests (and number over 4096). Record numbers and
+    // ids change afterwards.
+    bool maybeCompact();
+    bool compact();
+    // Bumped whenever record numbers change: every load(), including the
+    // reloads after a compaction or clear here or in another process.
+    uint64_t generation() const { return gen; }
+
+    size_t size() const { return recs.size(); }   // deleted ones included
+    const RequestRecord& record(size_t rec) const { return recs[rec]; }
+    std::string_view text(size_t rec) const {
+        return std::string_view(arena.data() + recs[rec].textOff, recs[rec].textLen);
+    }
+    size_t openCount() const { return open; }
+    size_t liveCount() const { return recs.size() - deleted; }
+    // Bumped by every change; views compare it to know when to refresh.
+    uint64_t revision() const { return rev; }
+
+    // Requests to list, resolved ones only if asked. Kept up to date as
+    // records arrive or change; only switching withResolved rebuilds it.
+    const RequestRows& rows(bool withResolved);
+
+private:
+    size_t parse(const char* p, size_t n, uint64_t base);
+    void applyStatus(uint64_t id, RequestStatus st);
+    bool appendStatus(size_t rec, const char* verb, RequestStatus unless);
+    void reset();
+
+    std::string file;
+    std::vector<RequestRecord> recs;   // by id
+    std::string arena;
+    uint64_t offset = 0;               // bytes parsed so far (whole lines only)
+    uint64_t fileIno = 0;              // of the file parsed; 0 where unknown
+    size_t open = 0, deleted = 0, statusLines = 0;
+    uint64_t rev = 0, gen = 0;
+    RequestRows rowList;
+    size_t rowScanned = 0;   // records already considered for rowList
+    bool rowResolved = false;
+};
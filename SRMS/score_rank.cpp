@@ -0,0 +1,37 @@
+#include "score_rank.h"
+#include <algorithm>
+#include <climits>
+
+void ScoreRanking::build(std::vector<std::pair<int, int64_t>> entries) {
+    std::vector<Key> keys;
+    keys.reserve(entries.size());
+    for (auto& e : entries) keys.push_back(Key{-e.second, e.first});
+    // Sorted inserts always land on the rightmost path, which stays in cache.
+    std::sort(keys.begin(), keys.end());
+    tree.clear();
+    for (auto& k : keys) tree.insert(k);
+}
+
+size_t ScoreRanking::rankOf(int roll, int64_t total) const {
+    Key k{-total, roll};
+    auto it = tree.find(k);
+    if (it == tree.end()) return 0;
+    return tree.order_of_key(k) + 1;
+}
+
+std::vector<int> ScoreRanking::top(size_t k) const {
+    std::vector<int> out;
+    out.reserve(std::min(k, tree.size()));
+    for (auto it = tree.begin(); it != tree.end() && out.size() < k; ++it) out.push_back(it->second);
+    return out;
+}
+
+double ScoreRanking::percentileOf(int64_t score) const {
+    if (tree.empty()) return 0.0;
+    size_t n = tree.size();
+    size_t above = tree.order_of_key(Key{-score, INT_MIN});          // total > score
+    size_t atLeast = tree.order_of_key(Key{-score + 1, INT_MIN});    // total >= score
+    size_t below = n - atLeast;
+    size_t equal = atLeast - above;
+    return 100.0 * (below + 0.5 * equal) / n;
+}
@@ -0,0 +1,76 @@
+// Order-statistic ranking of students by total score (no raylib dependency)
+
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#if __has_include(<ext/pb_ds/assoc_container.hpp>)
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#define SRMS_HAVE_PBDS 1
+#else
+#include <algorithm>
+#endif
+
+// Keys are (-total, roll), so iteration order is best score first with ties
+// broken by lower roll. The GNU pb_ds tree keeps subtree sizes, which makes
+// rank and percentile queries O(log N) and top-K O(log N + K).
+// pb_ds ships with libstdc++ (GCC, or Clang on Linux) only. Elsewhere (MSVC,
+// libc++) a sorted vector stands in: same queries and results, but add() and
+// remove() move O(N) keys, a few ms per edit at 1M students.
+class ScoreRanking {
+public:
+    size_t size() const { return tree.size(); }
+    void clear() { tree.clear(); }
+    // O(1). pb_ds trees have no move constructor, so std::swap would copy.
+    void swap(ScoreRanking& o) { tree.swap(o.tree); }
+    // Rebuilds from (roll, total) pairs; faster than add() one by one.
+    void build(std::vector<std::pair<int, int64_t>> entries);
+    void add(int roll, int64_t total) { tree.insert(Key{-total, roll}); }
+    void remove(int roll, int64_t total) { tree.erase(Key{-total, roll}); }
+
+    // 1-based position of roll among all students; 0 if it isn't ranked.
+    size_t rankOf(int roll, int64_t total) const;
+    // Rolls of the k best totals, best first.
+    std::vector<int> top(size_t k) const;
+    // Percentile rank of a score: share of students below it, counting ties
+    // as half, in [0, 100].
+    double percentileOf(int64_t score) const;
+
+private:
+    using Key = std::pair<int64_t, int>;
+#ifdef SRMS_HAVE_PBDS
+    using Tree = __gnu_pbds::tree<Key, __gnu_pbds::null_type, std::less<Key>,
+                                  __gnu_pbds::rb_tree_tag, __gnu_pbds::tree_order_statistics_node_update>;
+#else
+    // The part of the pb_ds tree interface used here, over a sorted vector.
+    class Tree {
+    public:
+        using const_iterator = std::vector<Key>::const_iterator;
+        size_t size() const { return keys.size(); }
+        bool empty() const { return keys.empty(); }
+        void clear() { keys.clear(); }
+        void swap(Tree& o) { keys.swap(o.keys); }
+        const_iterator begin() const { return keys.begin(); }
+        const_iterator end() const { return keys.end(); }
+        void insert(const Key& k) {
+            auto it = std::lower_bound(keys.begin(), keys.end(), k);
+            if (it == keys.end() || *it != k) keys.insert(it, k);
+        }
+        void erase(const Key& k) {
+            auto it = std::lower_bound(keys.begin(), keys.end(), k);
+            if (it != keys.end() && *it == k) keys.erase(it);
+        }
+        const_iterator find(const Key& k) const {
+            auto it = std::lower_bound(keys.begin(), keys.end(), k);
+            return it != keys.end() && *it == k ? it : keys.end();
+        }
+        size_t order_of_key(const Key& k) const {
+            return (size_t)(std::lower_bound(keys.begin(), keys.end(), k) - keys.begin());
+        }
+    private:
+        std::vector<Key> keys;
+    };
+#endif
+    Tree tree;
+};
@@ -0,0 +1,580 @@
+// Compile: g++ -O2 srms_cli.cpp srms_engine.cpp student_store.cpp name_index.cpp marks_table.cpp score_rank.cpp student_io.cpp student_bulk.cpp student_search.cpp student_list.cpp request_inbox.cpp student_snapshot.cpp student_auth.cpp srms_server.cpp course_schema.cpp student_history.cpp work_pool.cpp report_cards.cpp profiler.cpp mapped_file.cpp -o srms_cli -std=c++17 -pthread (add -lws2_32 on Windows)
+// Usage:   srms_cli load <students.csv>
+//          srms_cli query <students.csv> <query> [--limit N]
+//          srms_cli stats <students.csv> [--top N]
+//          srms_cli csv2bin <students.csv> <students.bin>
+//          srms_cli bin2csv <students.bin> <students.csv>
+//          srms_cli import <students.csv> <incoming.csv> [--threads N] [--keep-existing]
+//          srms_cli export <students.csv> <out.csv> [query]
+//          srms_cli hash-passwords <students.csv> [--cost N] [--threads N]
+//          srms_cli course <students.csv> [--set NAME[:MAX[:WEIGHT]],...] [--name COURSE]
+//          srms_cli history <students.csv> [--roll N] [--as-of "YYYY-MM-DD HH:MM:SS" | UNIX]
+//          srms_cli report <students.csv> <out-dir> [--html] [--threads N] [--per-file N] [--top N]
+//          srms_cli profile <students.csv> [--frames N]
+//          any command also takes --profile metrics.json and --trace trace.json
+//          srms_cli serve <students.csv> [--port N]
+//          srms_cli client [--port N]
+//          srms_cli loadgen [--port N] [--clients 1,8,64] [--seconds S] [--edits-per-sec N] [--max-roll N] [--admin USER:PASS]
+
+#include "srms_engine.h"
+#include "srms_server.h"
+#include "student_list.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using std::string;
+using std::vector;
+
+static double now_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// The course beside csv, then the database with rows padded to its subjects.
+static bool open_course_database(StudentStore& db, const string& csv, CourseSchema& course, StudentJournal* journal = nullptr) {
+    string why;
+    if (!open_course(csv, course, &why)) { fprintf(stderr, "%s\n", why.c_str()); return false; }
+    if (!open_database(db, csv, course.count(), journal)) { fprintf(stderr, "cannot read %s\n", csv.c_str()); return false; }
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: srms_cli load <students.csv>\n"
+            "       srms_cli query <students.csv> <query> [--limit N]\n"
+            "       srms_cli stats <students.csv> [--top N]\n"
+            "       srms_cli csv2bin <students.csv> <students.bin>\n"
+            "       srms_cli bin2csv <students.bin> <students.csv>\n"
+            "       srms_cli import <students.csv> <incoming.csv> [--threads N] [--keep-existing]\n"
+            "       srms_cli export <students.csv> <out.csv> [query]\n"
+            "       srms_cli hash-passwords <students.csv> [--cost N] [--threads N]\n"
+            "       srms_cli course <students.csv> [--set NAME[:MAX[:WEIGHT]],...] [--name COURSE]\n"
+            "       srms_cli history <students.csv> [--roll N] [--as-of \"YYYY-MM-DD HH:MM:SS\" | UNIX]\n"
+            "       srms_cli report <students.csv> <out-dir> [--html] [--threads N] [--per-file N] [--top N]\n"
+            "       srms_cli profile <students.csv> [--frames N]\n"
+            "       srms_cli serve <students.csv> [--port N]\n"
+            "       srms_cli client [--port N]\n"
+            "       srms_cli loadgen [--port N] [--clients 1,8,64] [--seconds S] [--edits-per-sec N] [--max-roll N] [--admin USER:PASS]\n"
+            "       any command also takes --profile metrics.json and --trace trace.json\n");
+}
+
+// Loads the database the way the GUI does (snapshot, journal replay) and
+// reports how long each part took.
+static int cmd_load(const string& csv) {
+    StudentStore db;
+    CourseSchema course;
+    double t = now_sec();
+    if (!open_course_database(db, csv, course)) return 1;
+    double loaded = now_sec();
+    // The lazy indexes the GUI builds on first use: names, ranking, roll order.
+    db.warmNameIndex(db.size());
+    db.topRolls(1);
+    db.forEachInRange(0, -1, [](size_t) {});
+    string bin = bin_beside(csv);
+    printf("%zu students, %d subjects, binary snapshot: %s\n", db.size(), db.marks().subjects(), bin.empty() ? "none" : bin.c_str());
+    printf("load %.1f ms, indexes %.1f ms\n", (loaded - t) * 1e3, (now_sec() - loaded) * 1e3);
+    return 0;
+}
+
+static int cmd_query(const string& csv, const string& text, size_t limit) {
+    StudentStore db;
+    CourseSchema course;
+    if (!open_course_database(db, csv, course)) return 1;
+    SearchQuery q;
+    string err;
+    if (!parse_query(text, q, &err)) { fprintf(stderr, "bad query: %s\n", err.c_str()); return 2; }
+    vector<uint32_t> hits;
+    bool fuzzy = false;
+    double t = now_sec();
+    run_query(db, q, hits, &fuzzy);
+    double ms = (now_sec() - t) * 1e3;
+    printf("roll,name,total,average\n");
+    for (size_t k = 0; k < hits.size() && k < limit; ++k) {
+        uint32_t i = hits[k];
+        printf("%d,%s,%.0f,%.2f\n", db.info(i).roll, db.info(i).name.c_str(), db.totalScore(i), db.averageScore(i));
+    }
+    fprintf(stderr, "%zu %s in %.2f ms (first query builds the indexes it needs)\n", hits.size(),
+            fuzzy ? "close matches" : "matches", ms);
+    return 0;
+}
+
+static int cmd_stats(const string& csv, size_t top) {
+    StudentStore db;
+    CourseSchema course;
+    if (!open_course_database(db, csv, course)) return 1;
+    double t = now_sec();
+    ClassStats st = class_stats(db, top, &course);
+    double ms = (now_sec() - t) * 1e3;
+    printf("%zu students, class average %.2f\n", st.students, st.meanAverage);
+    printf("%-20s %10s %6s %6s %9s %9s\n", course.name.c_str(), "count", "min", "max", "mean", "stddev");
+    for (size_t j = 0; j < st.subjects.size(); ++j) {
+        const SubjectStats& s = st.subjects[j];
+        string label = course.subjectName((int)j) + " /" + std::to_string(course.maxMark((int)j));
+        printf("%-20.20s %10zu %6d %6d %9.2f %9.2f\n", label.c_str(), s.count, s.min, s.max, s.mean, s.stddev);
+    }
+    const SubjectStats& s = st.total;
+    printf("%-20s %10zu %6d %6d %9.2f %9.2f\n", "total", s.count, s.min, s.max, s.mean, s.stddev);
+    if (course.weighted())
+        printf("%-20s %10zu %6.1f %6.1f %9.2f   (out of %.1f)\n", "weighted", st.students, st.weightedMin, st.weightedMax,
+               st.weightedMean, course.maxWeightedTotal());
+    for (size_t k = 0; k < st.topRolls.size(); ++k) {
+        const StudentInfo* info = db.find(st.topRolls[k]);
+        printf("#%-3zu %d %s %.0f\n", k + 1, info->roll, info->name.c_str(), db.totalScore(db.indexOf(info->roll)));
+    }
+    fprintf(stderr, "stats in %.1f ms\n", ms);
+    return 0;
+}
+
+// The CSV side includes its journal, so a converted file reflects every saved
+// edit. Either way rows are padded to the subjects of the course beside the CSV.
+static int cmd_csv2bin(const string& csv, const string& bin) {
+    StudentStore db;
+    CourseSchema course;
+    string why;
+    if (!open_course(csv, course, &why)) { fprintf(stderr, "%s\n", why.c_str()); return 1; }
+    double t = now_sec();
+    if (!load_from_file(db, csv, course.count())) { fprintf(stderr, "cannot read %s\n", csv.c_str()); return 1; }
+    double loaded = now_sec();
+    if (!save_binary(db, bin)) { fprintf(stderr, "cannot write %s\n", bin.c_str()); return 1; }
+    printf("%zu students: load %.1f ms, write %.1f ms\n", db.size(), (loaded - t) * 1e3, (now_sec() - loaded) * 1e3);
+    return 0;
+}
+
+static int cmd_bin2csv(const string& bin, const string& csv) {
+    StudentStore db;
+    CourseSchema course;
+    string why;
+    if (!open_course(csv, course, &why)) { fprintf(stderr, "%s\n", why.c_str()); return 1; }
+    double t = now_sec();
+    if (!load_binary(db, bin, course.count())) { fprintf(stderr, "cannot read %s\n", bin.c_str()); return 1; }
+    double loaded = now_sec();
+    if (!save_to_file(db, csv)) { fprintf(stderr, "cannot write %s\n", csv.c_str()); return 1; }
+    printf("%zu students: load %.1f ms, write %.1f ms\n", db.size(), (loaded - t) * 1e3, (now_sec() - loaded) * 1e3);
+    return 0;
+}
+
+// Merges <incoming> into the database and writes a fresh snapshot (which also
+// empties the journal, so old edits can't replay over imported rows).
+// Rejected lines go to <incoming>.rejects.csv.
+static int cmd_import(const string& csv, const string& incoming, const ImportOptions& options) {
+    StudentStore db;
+    StudentJournal journal(csv);
+    double t = now_sec();
+    // A missing database is fine: the import creates it. Rows are checked
+    // against the course's subjects and maxima.
+    CourseSchema course;
+    if (!open_course_database(db, csv, course, &journal)) return 1;
+    ImportOptions opt = options;
+    opt.minSubjects = course.count();
+    for (const SubjectDef& sd : course.subjects) opt.subjectMax.push_back(sd.maxMark);
+    printf("loaded %zu students in %.1f ms\n", db.size(), (now_sec() - t) * 1e3);
+
+    // Imported rows go on the edit history's timeline like the GUI's.
+    EditHistory history;
+    history.open(csv + ".history");
+    ImportReport rep;
+    if (!import_csv(db, incoming, opt, rep, &history)) { fprintf(stderr, "cannot read %s\n", incoming.c_str()); return 1; }
+    printf("%zu lines: %zu added, %zu updated, %zu rejected\n", rep.lines, rep.added, rep.updated, rep.rejects.size());
+    printf("parse %.1f ms (%.0f rows/s), merge %.1f ms\n", rep.parseSec * 1e3, rep.lines / rep.parseSec, rep.mergeSec * 1e3);
+    if (!rep.rejects.empty()) {
+        string report = incoming + ".rejects.csv";
+        if (!write_reject_report(rep, report)) fprintf(stderr, "cannot write %s\n", report.c_str());
+        else printf("rejects written to %s\n", report.c_str());
+    }
+    t = now_sec();
+    if (!journal.compactNow(db)) { fprintf(stderr, "cannot write %s\n", csv.c_str()); return 1; }
+    printf("snapshot written in %.1f ms\n", (now_sec() - t) * 1e3);
+    return 0;
+}
+
+static int cmd_export(const string& csv, const string& out, const string& query) {
+    StudentStore db;
+    CourseSchema course;
+    if (!open_course_database(db, csv, course)) return 1;
+    vector<uint32_t> hits;
+    if (!query.empty()) {
+        SearchQuery q;
+        string err;
+        if (!parse_query(query, q, &err)) { fprintf(stderr, "bad query: %s\n", err.c_str()); return 2; }
+        run_query(db, q, hits);
+    }
+    double t = now_sec();
+    if (!export_csv(db, out, query.empty() ? nullptr : &hits)) { fprintf(stderr, "cannot write %s\n", out.c_str()); return 1; }
+    printf("%zu students exported in %.1f ms\n", query.empty() ? db.size() : hits.size(), (now_sec() - t) * 1e3);
+    return 0;
+}
+
+// Hashes every plaintext password (rows from older files and imports) in
+// parallel, then writes a fresh snapshot.
+static int cmd_hash_passwords(const string& csv, int cost, unsigned threads) {
+    StudentStore db;
+    StudentJournal journal(csv);
+    CourseSchema course;
+    if (!open_course_database(db, csv, course, &journal)) return 1;
+    vector<uint32_t> todo;
+    for (size_t i = 0; i < db.size(); ++i)
+        if (password_needs_rehash(db.info(i).password, cost)) todo.push_back((uint32_t)i);
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    double t = now_sec();
+    vector<string> hashed(todo.size());
+    std::atomic<size_t> next{0};
+    vector<std::thread> pool;
+    for (unsigned k = 0; k < threads; ++k)
+        pool.emplace_back([&] {
+            for (size_t j; (j = next++) < todo.size();) hashed[j] = hash_password(db.info(todo[j]).password, cost);
+        });
+    for (std::thread& th : pool) th.join();
+    double secs = now_sec() - t;
+    for (size_t j = 0; j < todo.size(); ++j) {
+        Student s = db.get(todo[j]);
+        s.password = std::move(hashed[j]);
+        db.update(s);
+    }
+    if (!todo.empty() && !journal.compactNow(db)) { fprintf(stderr, "cannot write %s\n", csv.c_str()); return 1; }
+    printf("%zu of %zu passwords hashed at cost %d in %.1f s (%.0f/s on %u threads)\n", todo.size(), db.size(), cost, secs,
+           todo.size() / std::max(secs, 1e-9), threads);
+    return 0;
+}
+
+// Shows the course beside the database, or replaces its subject list and name.
+static int cmd_course(const string& csv, const string& subjects, const string& name, bool setName) {
+    CourseSchema course;
+    string why, path = course_beside(csv);
+    if (!open_course(csv, course, &why)) { fprintf(stderr, "%s\n", why.c_str()); return 1; }
+    if (!subjects.empty() && !parse_subject_list(subjects, course, &why)) { fprintf(stderr, "bad subject list: %s\n", why.c_str()); return 2; }
+    if (setName) course.name = name;
+    if ((!subjects.empty() || setName) && !save_course(path, course)) { fprintf(stderr, "cannot write %s\n", path.c_str()); return 1; }
+    printf("%s%s%d subjects, weighted total out of %.1f\n", course.name.c_str(), course.name.empty() ? "" : ": ",
+           course.count(), course.maxWeightedTotal());
+    for (int j = 0; j < course.count(); ++j)
+        printf("  %-24s max %5d  weight %g\n", course.subjectName(j).c_str(), course.maxMark(j), course.weight(j));
+    return 0;
+}
+
+// "YYYY-MM-DD[ HH:MM[:SS]]" in local time, or unix seconds.
+static bool parse_time(const char* text, int64_t& out) {
+    std::tm tm{};
+    int n = sscanf(text, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+    if (n >= 3) {
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_isdst = -1;
+        out = (int64_t)mktime(&tm);
+        return out != -1;
+    }
+    char* end;
+    out = strtoll(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+static string format_time(int64_t t) {
+    time_t tt = (time_t)t;
+    char buf[32];
+    strftime(buf, sizeof buf, "%Y-%m-%d %H:%M:%S", localtime(&tt));
+    return buf;
+}
+
+static string row_or(bool exists, const Student& s, const char* none) {
+    return exists ? format_student_row(s) : none;
+}
+
+// Without --as-of: the timeline (of one roll with --roll), each change with
+// the row before and after it. With --as-of: every roll changed since then
+// (or just --roll), as it was at that time and as it is now.
+static int cmd_history(const string& csv, int roll, bool oneRoll, const char* asOf) {
+    StudentStore db;
+    CourseSchema course;
+    if (!open_course_database(db, csv, course)) return 1;
+    EditHistory history;
+    string path = csv + ".history";
+    history.load(path);
+    if (history.skippedLines()) fprintf(stderr, "%zu unreadable lines in %s skipped\n", history.skippedLines(), path.c_str());
+    Student before, after;
+    if (asOf) {
+        int64_t t;
+        if (!parse_time(asOf, t)) { fprintf(stderr, "bad time: %s\n", asOf); return 2; }
+        uint64_t v = history.versionAt(t);
+        printf("as of %s: version %llu of %llu\n", format_time(t).c_str(), (unsigned long long)v, (unsigned long long)history.version());
+        vector<int> rolls = oneRoll ? vector<int>{roll} : history.changedSince(v);
+        for (int r : rolls) {
+            bool was = history.find(db, r, v, before), is = history.find(db, r, history.version(), after);
+            printf("%d: %s\n    now %s\n", r, row_or(was, before, "(not there)").c_str(), row_or(is, after, "(deleted)").c_str());
+        }
+        return 0;
+    }
+    if (history.firstVersion()) printf("(%llu older changes folded away)\n", (unsigned long long)history.firstVersion());
+    for (uint64_t v = history.firstVersion() + 1; v <= history.version(); ++v) {
+        const EditHistory::Change& c = history.change(v);
+        if (oneRoll && c.roll != roll) continue;
+        bool was = history.find(db, c.roll, v - 1, before);
+        printf("#%llu %s %s %d\n    was %s\n    now %s\n", (unsigned long long)v, format_time(c.time).c_str(), EditHistory::kindName(c.kind), c.roll,
+               row_or(was, before, "(not there)").c_str(), row_or(c.exists, c.row, "(deleted)").c_str());
+    }
+    printf("%llu changes to %zu students\n", (unsigned long long)(history.version() - history.firstVersion()), history.rollsTouched());
+    return 0;
+}
+
+// Report cards for every student plus the class report, with a progress
+// line on stderr while they render.
+static int cmd_report(const string& csv, const string& outDir, const ReportOptions& opt) {
+    StudentStore db;
+    CourseSchema course;
+    double t = now_sec();
+    if (!open_course_database(db, csv, course)) return 1;
+    printf("loaded %zu students in %.1f ms\n", db.size(), (now_sec() - t) * 1e3);
+    ReportJob job;
+    job.start(db, course, outDir, opt);
+    ReportResult r;
+    while (!job.finish(r)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        const ReportProgress& p = job.progress();
+        double sec = job.elapsed();
+        fprintf(stderr, "\r%zu / %zu cards, %.0f cards/s, %.1f MB/s   ", (size_t)p.cards, (size_t)p.total, p.cards / sec,
+                p.bytes / sec / 1e6);
+    }
+    fprintf(stderr, "\n");
+    if (!r.ok) { fprintf(stderr, "%s\n", r.error.c_str()); return 1; }
+    double sec = r.prepareSec + r.renderSec;
+    printf("%zu cards in %zu files, %.1f MB, under %s\n", r.cards, r.files, r.bytes / 1e6, outDir.c_str());
+    printf("prepare %.1f ms, render %.1f ms (%.0f cards/s, %.1f MB/s, %zu steals)\n", r.prepareSec * 1e3, r.renderSec * 1e3,
+           r.cards / sec, r.bytes / sec / 1e6, r.steals);
+    return 0;
+}
+
+// The GUI's profiled paths without a window: open the database and the
+// inbox, then run N frames of scrolling the student list and polling the
+// inbox, and save to a scratch copy. Prints what the F3 overlay would show.
+static int cmd_profile(const string& csv, size_t frames) {
+    StudentStore db;
+    CourseSchema course;
+    if (!open_course_database(db, csv, course)) return 1;
+    RequestInbox inbox((std::filesystem::path(csv).parent_path() / SRMS_REQUEST_FILE).string());
+    inbox.load();
+    StudentListView view;
+    view.setViewport(600, 32);
+    for (size_t k = 0; k < frames; ++k) {
+        {
+            PROFILE_SCOPE("student list rows");
+            view.scrollBy(k % 120 < 60 ? 96.0f : -96.0f);
+            view.tick(1.0f / 60, db.size());
+            StudentListView::Window w = view.window(db.size());
+            for (size_t row = w.first; row < w.last; ++row) view.rowText(db, row, row);
+            PROFILE_COUNT("student rows drawn", w.last - w.first);
+        }
+        inbox.poll();
+        profile_frame();
+    }
+    string scratch = (std::filesystem::temp_directory_path() / "srms_profile.csv").string();
+    save_to_file(db, scratch);
+    std::error_code ec;
+    std::filesystem::remove(scratch, ec);
+    for (const string& line : profile_overlay_lines()) printf("%s\n", line.c_str());
+    return 0;
+}
+
+static std::atomic<bool> g_stop{false};
+
+static void on_signal(int) {
+    g_stop = true;
+}
+
+// Serves the database on 127.0.0.1 until Ctrl+C. Edits are journaled like
+// the GUI's, and the snapshot is rewritten on exit if the journal grew.
+static int cmd_serve(const string& csv, int port) {
+    StudentStore db;
+    StudentJournal journal(csv);
+    CourseSchema course;
+    if (!open_course_database(db, csv, course, &journal)) return 1;
+    journal.startWriter();
+    SrmsServer server(db, journal, course);
+    EditHistory history;
+    history.open(csv + ".history");
+    server.history = &history;
+    // admin.cfg next to the database, hashed in place on first use.
+    string cfg = (std::filesystem::path(csv).parent_path() / SRMS_ADMIN_FILE).string();
+    if (!load_admin_config(cfg, server.admin)) { fprintf(stderr, "cannot read %s\n", cfg.c_str()); return 1; }
+    if (server.admin.upgraded) save_admin_config(cfg, server.admin);
+    if (!server.start(port)) { fprintf(stderr, "cannot listen on port %d\n", port); return 1; }
+    printf("serving %zu students on 127.0.0.1:%d (Ctrl+C to stop)\n", db.size(), server.port());
+    fflush(stdout);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (journal.takeWriteError()) fprintf(stderr, "journal write failed\n");
+    }
+    server.stop();
+    bool ok = journal.snapshotNeeded() ? journal.compactNow(db) : journal.flush();
+    printf("stopped at version %llu, %zu students\n", (unsigned long long)server.snapshot()->version(), db.size());
+    if (!ok) { fprintf(stderr, "cannot write %s\n", csv.c_str()); return 1; }
+    return 0;
+}
+
+// Sends each stdin line and prints the reply.
+static int cmd_client(int port) {
+    SrmsClient c;
+    if (!c.connect("127.0.0.1", port)) { fprintf(stderr, "cannot connect to port %d\n", port); return 1; }
+    string line, reply;
+    while (std::getline(std::cin, line) && line != "QUIT") {
+        if (line.empty()) continue;
+        if (!c.request(line, reply)) { fprintf(stderr, "connection closed\n"); return 1; }
+        printf("%s\n", reply.c_str());
+        fflush(stdout);
+    }
+    return 0;
+}
+
+static int cmd_loadgen(int port, const vector<int>& clients, double seconds, int editsPerSec, int maxRoll, const string& admin) {
+    size_t colon = admin.find(':');
+    string user = admin.substr(0, colon), pass = colon == string::npos ? "" : admin.substr(colon + 1);
+    printf("%8s %12s %10s %10s %10s %8s %8s\n", "clients", "requests/s", "p50 us", "p99 us", "max us", "edits", "errors");
+    for (int n : clients) {
+        LoadReport r = run_load("127.0.0.1", port, n, seconds, maxRoll, user, pass, editsPerSec);
+        printf("%8d %12.0f %10.1f %10.1f %10.1f %8zu %8zu\n", n, r.requests / r.seconds, r.p50Us, r.p99Us, r.maxUs,
+               r.edits, r.failures);
+        fflush(stdout);
+        if (r.failures) return 1;
+    }
+    return 0;
+}
+
+// Reads "--name N" at argv[i]; false on anything else.
+static bool count_option(int argc, char** argv, int& i, const char* name, size_t& out) {
+    if (strcmp(argv[i], name) != 0 || i + 1 >= argc) return false;
+    out = (size_t)strtoull(argv[++i], nullptr, 10);
+    return true;
+}
+
+static int run_command(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "load") == 0) return cmd_load(argv[2]);
+    if (argc >= 4 && strcmp(argv[1], "query") == 0) {
+        size_t limit = 50;
+        for (int i = 4; i < argc; ++i)
+            if (!count_option(argc, argv, i, "--limit", limit)) { usage(); return 2; }
+        return cmd_query(argv[2], argv[3], limit);
+    }
+    if (argc >= 3 && strcmp(argv[1], "stats") == 0) {
+        size_t top = 10;
+        for (int i = 3; i < argc; ++i)
+            if (!count_option(argc, argv, i, "--top", top)) { usage(); return 2; }
+        return cmd_stats(argv[2], top);
+    }
+    if (argc == 4 && strcmp(argv[1], "csv2bin") == 0) return cmd_csv2bin(argv[2], argv[3]);
+    if (argc == 4 && strcmp(argv[1], "bin2csv") == 0) return cmd_bin2csv(argv[2], argv[3]);
+    if (argc >= 4 && strcmp(argv[1], "import") == 0) {
+        ImportOptions opt;
+        for (int i = 4; i < argc; ++i) {
+            size_t threads;
+            if (count_option(argc, argv, i, "--threads", threads)) opt.threads = (unsigned)threads;
+            else if (strcmp(argv[i], "--keep-existing") == 0) opt.overwrite = false;
+            else { usage(); return 2; }
+        }
+        return cmd_import(argv[2], argv[3], opt);
+    }
+    if (argc >= 3 && strcmp(argv[1], "hash-passwords") == 0) {
+        size_t cost = AUTH_DEFAULT_COST, threads = 0;
+        for (int i = 3; i < argc; ++i)
+            if (!count_option(argc, argv, i, "--cost", cost) && !count_option(argc, argv, i, "--threads", threads)) { usage(); return 2; }
+        return cmd_hash_passwords(argv[2], (int)cost, (unsigned)threads);
+    }
+    if (argc >= 3 && strcmp(argv[1], "course") == 0) {
+        string subjects, name;
+        bool setName = false;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) subjects = argv[++i];
+            else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) { name = argv[++i]; setName = true; }
+            else { usage(); return 2; }
+        }
+        return cmd_course(argv[2], subjects, name, setName);
+    }
+    if (argc >= 3 && strcmp(argv[1], "history") == 0) {
+        size_t roll = 0;
+        bool oneRoll = false;
+        const char* asOf = nullptr;
+        for (int i = 3; i < argc; ++i) {
+            if (count_option(argc, argv, i, "--roll", roll)) oneRoll = true;
+            else if (strcmp(argv[i], "--as-of") == 0 && i + 1 < argc) asOf = argv[++i];
+            else { usage(); return 2; }
+        }
+        return cmd_history(argv[2], (int)roll, oneRoll, asOf);
+    }
+    if (argc >= 4 && strcmp(argv[1], "report") == 0) {
+        ReportOptions opt;
+        for (int i = 4; i < argc; ++i) {
+            size_t threads;
+            if (strcmp(argv[i], "--html") == 0) opt.format = ReportFormat::HTML;
+            else if (count_option(argc, argv, i, "--threads", threads)) opt.threads = (unsigned)threads;
+            else if (!count_option(argc, argv, i, "--per-file", opt.cardsPerFile) && !count_option(argc, argv, i, "--top", opt.topK)) {
+                usage();
+                return 2;
+            }
+        }
+        return cmd_report(argv[2], argv[3], opt);
+    }
+    if (argc >= 3 && strcmp(argv[1], "profile") == 0) {
+        size_t frames = 600;
+        for (int i = 3; i < argc; ++i)
+            if (!count_option(argc, argv, i, "--frames", frames)) { usage(); return 2; }
+        return cmd_profile(argv[2], frames);
+    }
+    if (argc >= 3 && strcmp(argv[1], "serve") == 0) {
+        size_t port = SRMS_DEFAULT_PORT;
+        for (int i = 3; i < argc; ++i)
+            if (!count_option(argc, argv, i, "--port", port)) { usage(); return 2; }
+        return cmd_serve(argv[2], (int)port);
+    }
+    if (argc >= 2 && strcmp(argv[1], "client") == 0) {
+        size_t port = SRMS_DEFAULT_PORT;
+        for (int i = 2; i < argc; ++i)
+            if (!count_option(argc, argv, i, "--port", port)) { usage(); return 2; }
+        return cmd_client((int)port);
+    }
+    if (argc >= 2 && strcmp(argv[1], "loadgen") == 0) {
+        size_t port = SRMS_DEFAULT_PORT, seconds = 2, edits = 100, maxRoll = 100000;
+        vector<int> clients = {1, 8, 64};
+        string admin = "admin:12345";
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+                clients.clear();
+                for (const char* p = argv[++i]; *p; p += (*p == ',')) {
+                    char* end;
+                    clients.push_back((int)strtol(p, &end, 10));
+                    if (end == p || clients.back() < 1) { usage(); return 2; }
+                    p = end;
+                }
+            } else if (strcmp(argv[i], "--admin") == 0 && i + 1 < argc) {
+                admin = argv[++i];
+            } else if (!count_option(argc, argv, i, "--port", port) && !count_option(argc, argv, i, "--seconds", seconds) &&
+                       !count_option(argc, argv, i, "--edits-per-sec", edits) &&
+                       !count_option(argc, argv, i, "--max-roll", maxRoll)) {
+                usage();
+                return 2;
+            }
+        }
+        return cmd_loadgen((int)port, clients, (double)seconds, (int)edits, (int)maxRoll, admin);
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "export") == 0) return cmd_export(argv[2], argv[3], argc == 5 ? argv[4] : "");
+    usage();
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    ProfileArgs profileArgs = profile_parse_args(argc, argv);
+    int rc = run_command(argc, argv);
+    string why;
+    if (!profile_write(profileArgs, &why)) {
+        fprintf(stderr, "%s\n", why.c_str());
+        if (rc == 0) rc = 1;
+    }
+    return rc;
+}
@@ -0,0 +1,89 @@
+#include "srms_engine.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+const char* const SRMS_DATA_FILE = "students.csv";
+const char* const SRMS_BIN_FILE = "students.bin";
+const char* const SRMS_REQUEST_FILE = "requests.txt";
+const char* const SRMS_ADMIN_FILE = "admin.cfg";
+const char* const SRMS_REPORT_DIR = "reports";
+
+// ---------- Database ----------
+string bin_beside(const string& csvPath) {
+    string bin = csvPath;
+    if (bin.size() > 4 && bin.compare(bin.size() - 4, 4, ".csv") == 0) bin.resize(bin.size() - 4);
+    bin += ".bin";
+    std::error_code ec;
+    return fs::exists(bin, ec) ? bin : "";
+}
+
+bool open_database(StudentStore& db, const string& csvPath, int minSubjects, StudentJournal* journal) {
+    PROFILE_SCOPE("open_database");
+    string bin = bin_beside(csvPath);
+    std::error_code ec;
+    bool ok = true;
+    if (!bin.empty() || fs::exists(csvPath, ec)) ok = load_database(db, csvPath, bin, minSubjects);
+    else db.clear();
+    if (journal && !journal->open(db, bin)) ok = false;
+    return ok;
+}
+
+bool open_course(const string& csvPath, CourseSchema& out, string* why) {
+    if (load_course(course_beside(csvPath), SRMS_DEFAULT_SUBJECTS, out, why)) return true;
+    out = default_course(SRMS_DEFAULT_SUBJECTS);
+    return false;
+}
+
+// ---------- Class Statistics ----------
+ClassStats class_stats(const StudentStore& db, size_t topK, const CourseSchema* course) {
+    ClassStats st;
+    const MarksTable& marks = db.marks();
+    size_t n = db.size();
+    st.students = n;
+    for (int j = 0; j < marks.subjects(); ++j) st.subjects.push_back(marks.subjectStats(j));
+    st.topRolls = db.topRolls(topK);
+    if (n == 0) return st;
+
+    // Totals are cached per row, so this is one pass over two flat arrays.
+    const int64_t* __restrict tot = marks.totals();
+    const uint16_t* __restrict cnt = marks.counts();
+    int64_t sum = 0, lo = tot[0], hi = tot[0];
+    double sq = 0, avgSum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t t = tot[i];
+        sum += t;
+        lo = std::min(lo, t);
+        hi = std::max(hi, t);
+        sq += (double)t * (double)t;
+        avgSum += cnt[i] ? (double)t / cnt[i] : 0.0;
+    }
+    SubjectStats& t = st.total;
+    t.count = n;
+    t.sum = sum;
+    t.min = (int)lo;
+    t.max = (int)hi;
+    t.mean = (double)sum / n;
+    t.stddev = std::sqrt(std::max(0.0, sq / n - t.mean * t.mean));
+    st.meanAverage = avgSum / n;
+
+    if (course) {
+        vector<double> w = course->weights(marks.subjects());
+        vector<double> wt(n);
+        marks.weightedTotals(w.data(), wt.data());
+        double wsum = 0, wlo = wt[0], whi = wt[0];
+        for (size_t i = 0; i < n; ++i) {
+            wsum += wt[i];
+            wlo = std::min(wlo, wt[i]);
+            whi = std::max(whi, wt[i]);
+        }
+        st.weightedMean = wsum / n;
+        st.weightedMin = wlo;
+        st.weightedMax = whi;
+    }
+    return st;
+}
@@ -0,0 +1,67 @@
+// SRMS engine: the headless library shared by the GUI, srms_cli and srms_bench (no raylib dependency)
+//
+// Library sources (everything except the three entry points):
+//   srms_engine.cpp student_store.cpp name_index.cpp marks_table.cpp score_rank.cpp
+//   student_io.cpp student_bulk.cpp student_search.cpp student_list.cpp request_inbox.cpp
+//   student_snapshot.cpp student_auth.cpp srms_server.cpp course_schema.cpp student_history.cpp
+//   work_pool.cpp report_cards.cpp profiler.cpp mapped_file.cpp
+// srms_server.cpp uses sockets: on Windows, programs that call into it link -lws2_32.
+// Build it once and link it into each program:
+//   g++ -O3 -std=c++17 -c <library sources> && ar rcs libsrms.a *.o
+//   g++ student.cpp libsrms.a -o student.exe -O3 -std=c++17 -pthread -lraylib -lopengl32 -lgdi32 -lwinmm
+//   g++ srms_cli.cpp libsrms.a -o srms_cli -O3 -std=c++17 -pthread (-lws2_32)
+//   g++ srms_bench.cpp libsrms.a -o srms_bench -O3 -march=native -std=c++17 -pthread (-lws2_32)
+
+#pragma once
+#include "course_schema.h"
+#include "profiler.h"
+#include "report_cards.h"
+#include "request_inbox.h"
+#include "student_auth.h"
+#include "student_bulk.h"
+#include "student_history.h"
+#include "student_io.h"
+#include "student_search.h"
+#include "student_store.h"
+#include "work_pool.h"
+#include <string>
+#include <vector>
+
+// ---------- Defaults ----------
+extern const char* const SRMS_DATA_FILE;      // "students.csv"
+extern const char* const SRMS_BIN_FILE;       // "students.bin"
+extern const char* const SRMS_REQUEST_FILE;   // "requests.txt"
+extern const char* const SRMS_ADMIN_FILE;     // "admin.cfg"
+extern const char* const SRMS_REPORT_DIR;     // "reports"
+const int SRMS_DEFAULT_SUBJECTS = 3;
+
+// ---------- Database ----------
+// The binary snapshot that sits next to a CSV ("x.csv" -> "x.bin"), or "" if
+// there is none. The binary format is opt-in: it is only kept fresh once
+// someone has created it.
+std::string bin_beside(const std::string& csvPath);
+
+// What the GUI does at startup: loads the CSV (or the binary snapshot beside
+// it) and replays the journal, then opens journal for appends when one is
+// given. A missing CSV gives an empty database, which is not an error.
+bool open_database(StudentStore& db, const std::string& csvPath, int minSubjects, StudentJournal* journal = nullptr);
+// The course file beside a CSV, or SRMS_DEFAULT_SUBJECTS plain subjects when
+// there is none. False (with the default course in out) if it doesn't parse.
+bool open_course(const std::string& csvPath, CourseSchema& out, std::string* why = nullptr);
+
+// ---------- Class Statistics ----------
+struct ClassStats {
+    size_t students = 0;
+    std::vector<SubjectStats> subjects;   // one per column
+    SubjectStats total;                   // over per-student totals
+    double meanAverage = 0.0;             // mean of per-student averages
+    // Per-student sums of weight * mark, when class_stats was given a course.
+    double weightedMean = 0.0;
+    double weightedMin = 0.0;
+    double weightedMax = 0.0;
+    std::vector<int> topRolls;            // best total first
+};
+
+// Every subject plus totals in one call; top holds the first topK ranks.
+// With a course, also the weighted totals (MarksTable::weightedTotals).
+ClassStats class_stats(const StudentStore& db, size_t topK = 10, const CourseSchema* course = nullptr);
@@ -0,0 +1,496 @@
+#include "srms_server.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET sock_t;
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int sock_t;
+#endif
+
+using std::string;
+using std::vector;
+
+// ---------- Sockets ----------
+// Sockets are kept as intptr_t so the header needs no platform includes.
+static const intptr_t NO_SOCKET = -1;
+
+static bool net_init() {
+#ifdef _WIN32
+    static const bool ok = [] {
+        WSADATA wsa;
+        return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+    }();
+    return ok;
+#else
+    return true;
+#endif
+}
+
+static void sock_close(intptr_t s) {
+#ifdef _WIN32
+    closesocket((sock_t)s);
+#else
+    ::close((sock_t)s);
+#endif
+}
+
+static void sock_shutdown(intptr_t s) {
+#ifdef _WIN32
+    shutdown((sock_t)s, SD_BOTH);
+#else
+    shutdown((sock_t)s, SHUT_RDWR);
+#endif
+}
+
+static void sock_nodelay(intptr_t s) {
+    int one = 1;
+    setsockopt((sock_t)s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof one);
+}
+
+static bool send_all(intptr_t s, const char* p, size_t n) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;   // a closed peer is an error, not SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    while (n > 0) {
+        auto sent = send((sock_t)s, p, (int)std::min(n, (size_t)1 << 20), flags);
+        if (sent <= 0) return false;
+        p += sent;
+        n -= (size_t)sent;
+    }
+    return true;
+}
+
+static long recv_some(intptr_t s, char* p, size_t n) {
+    return (long)recv((sock_t)s, p, (int)n, 0);
+}
+
+static intptr_t connect_tcp(const string& host, int port) {
+    if (!net_init()) return NO_SOCKET;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return NO_SOCKET;
+    intptr_t s = NO_SOCKET;
+    for (addrinfo* a = res; a && s == NO_SOCKET; a = a->ai_next) {
+        sock_t fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd == (sock_t)-1) continue;
+        if (::connect(fd, a->ai_addr, (int)a->ai_addrlen) == 0) s = (intptr_t)fd;
+        else sock_close((intptr_t)fd);
+    }
+    freeaddrinfo(res);
+    if (s != NO_SOCKET) sock_nodelay(s);
+    return s;
+}
+
+// ---------- Protocol ----------
+static std::string_view next_word(std::string_view& s) {
+    size_t sp = s.find(' ');
+    std::string_view w = s.substr(0, sp);
+    s = sp == std::string_view::npos ? std::string_view() : s.substr(sp + 1);
+    return w;
+}
+
+static bool view_int(std::string_view s, int& out) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+static void append_int(string& out, int64_t v) {
+    char tmp[24];
+    auto r = std::to_chars(tmp, tmp + sizeof tmp, v);
+    out.append(tmp, r.ptr - tmp);
+}
+
+// Same quoting as students.csv.
+static void append_field(string& out, std::string_view v) {
+    if (v.find_first_of(",\"\n\r") == std::string_view::npos) {
+        out.append(v.data(), v.size());
+        return;
+    }
+    out += '"';
+    for (char c : v) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+// ---------- Server ----------
+SrmsServer::SrmsServer(StudentStore& db_, StudentJournal& journal_, const CourseSchema& course_)
+    : course(course_), db(db_), journal(journal_), current(StudentSnapshot::build(db_)) {
+    load_admin_config("", admin);
+}
+
+SrmsServer::~SrmsServer() {
+    stop();
+}
+
+bool SrmsServer::start(int port) {
+    if (listener != NO_SOCKET || !net_init()) return false;
+    sock_t fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == (sock_t)-1) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof one);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    socklen_t len = sizeof addr;
+    if (bind(fd, (sockaddr*)&addr, sizeof addr) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        getsockname(fd, (sockaddr*)&addr, &len) != 0) {
+        sock_close((intptr_t)fd);
+        return false;
+    }
+    listener = (intptr_t)fd;
+    boundPort = ntohs(addr.sin_port);
+    stopping = false;
+    acceptor = std::thread(&SrmsServer::acceptLoop, this);
+    return true;
+}
+
+void SrmsServer::stop() {
+    if (listener == NO_SOCKET) return;
+    stopping = true;
+    // accept() is woken by a connection on every platform, unlike close().
+    intptr_t wake = connect_tcp("127.0.0.1", boundPort);
+    if (acceptor.joinable()) acceptor.join();
+    if (wake != NO_SOCKET) sock_close(wake);
+    sock_close(listener);
+    listener = NO_SOCKET;
+    {
+        std::lock_guard<std::mutex> lock(connMutex);
+        for (Connection& c : conns) sock_shutdown(c.sock);
+    }
+    reap(true);
+}
+
+void SrmsServer::acceptLoop() {
+    for (;;) {
+        sock_t fd = accept((sock_t)listener, nullptr, nullptr);
+        if (stopping) {
+            if (fd != (sock_t)-1) sock_close((intptr_t)fd);
+            return;
+        }
+        if (fd == (sock_t)-1) continue;
+        sock_nodelay((intptr_t)fd);
+        reap(false);
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::lock_guard<std::mutex> lock(connMutex);
+        liveConnections++;
+        conns.push_back({std::thread(&SrmsServer::serve, this, (intptr_t)fd, done), (intptr_t)fd, done});
+    }
+}
+
+// Joins finished connection threads (all of them if asked) and closes their
+// sockets. Sockets are only closed here, after the join, so stop() never
+// shuts down a number the system has already handed out again.
+void SrmsServer::reap(bool all) {
+    vector<Connection> finished;
+    {
+        std::lock_guard<std::mutex> lock(connMutex);
+        for (size_t i = 0; i < conns.size();) {
+            if (all || *conns[i].done) {
+                finished.push_back(std::move(conns[i]));
+                conns[i] = std::move(conns.back());
+                conns.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+    for (Connection& c : finished) {
+        c.thread.join();
+        sock_close(c.sock);
+    }
+}
+
+void SrmsServer::serve(intptr_t sock, std::shared_ptr<std::atomic<bool>> done) {
+    string in, out;
+    char buf[16384];
+    Caller caller;
+    bool quit = false;
+    while (!quit) {
+        long n = recv_some(sock, buf, sizeof buf);
+        if (n <= 0) break;
+        in.append(buf, (size_t)n);
+        // Every complete line gets its reply; pipelined requests share one send.
+        size_t pos = 0, nl;
+        out.clear();
+        while (!quit && (nl = in.find('\n', pos)) != string::npos) {
+            std::string_view line(in.data() + pos, nl - pos);
+            pos = nl + 1;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line == "QUIT") quit = true;
+            else if (!line.empty()) handle(line, caller, out);
+        }
+        in.erase(0, pos);
+        if (!out.empty() && !send_all(sock, out.data(), out.size())) break;
+        if (in.size() > (1 << 20)) break;   // no sane request line is this long
+    }
+    sock_shutdown(sock);
+    liveConnections--;
+    *done = true;
+}
+
+void SrmsServer::handle(std::string_view line, Caller& caller, string& out) {
+    std::string_view cmd = next_word(line);
+    int roll = 0;
+    if (cmd == "LOGIN" || cmd == "GET") {
+        std::string_view rollText = next_word(line);
+        StudentSnapshot::Row r;
+        auto snap = snapshot();
+        bool parsed = view_int(rollText, roll);
+        // Checked before the lookup, so a stranger can't probe which rolls exist.
+        if (cmd == "GET" && !caller.admin && !(parsed && caller.loggedIn && caller.roll == roll)) {
+            out += "ERR login first\n";
+            return;
+        }
+        bool found = parsed && snap->find(roll, r);
+        if (cmd == "LOGIN") {
+            caller.loggedIn = found && sessions.verify(roll, r.password, line);
+            caller.roll = caller.loggedIn ? roll : 0;
+            if (!caller.loggedIn) {
+                out += "ERR bad login\n";
+                return;
+            }
+            out += "OK ";
+            out.append(r.name.data(), r.name.size());
+            out += '\n';
+            return;
+        }
+        if (!found) {
+            out += "ERR not found\n";
+            return;
+        }
+        out += "OK ";
+        append_int(out, r.roll);
+        out += ',';
+        append_field(out, r.name);
+        out += ',';
+        for (int j = 0; j < r.count; ++j) {
+            if (j) out += ';';
+            append_int(out, r.marks[j]);
+        }
+        out += ',';
+        append_int(out, r.total);
+        out += '\n';
+    } else if (cmd == "STATS") {
+        auto snap = snapshot();
+        out += "OK ";
+        append_int(out, (int64_t)snap->size());
+        out += ' ';
+        append_int(out, (int64_t)snap->version());
+        out += '\n';
+    } else if (cmd == "ADMIN") {
+        std::string_view user = next_word(line);
+        caller.admin = verify_admin(admin, user, line);
+        out += caller.admin ? "OK\n" : "ERR bad password\n";
+    } else if (cmd == "PUT" || cmd == "DEL") {
+        if (!caller.admin) {
+            out += "ERR admin only\n";
+            return;
+        }
+        uint64_t version = 0;
+        if (cmd == "PUT") {
+            Student s;
+            if (!parse_student_row(line, s, course.count())) {
+                out += "ERR bad row\n";
+                return;
+            }
+            if (const char* why = course.check(s.marks)) {
+                out += "ERR ";
+                out += why;
+                out += '\n';
+                return;
+            }
+            if (!is_password_hash(s.password)) s.password = hash_password(s.password, admin.cost);
+            version = upsert(s);
+        } else if (!view_int(line, roll) || !erase(roll, &version)) {
+            out += "ERR not found\n";
+            return;
+        }
+        out += "OK ";
+        append_int(out, (int64_t)version);
+        out += '\n';
+    } else {
+        out += "ERR unknown command\n";
+    }
+}
+
+// ---------- Write Path ----------
+// One writer at a time. Readers keep whatever snapshot they loaded; the new
+// one is published only once it is complete.
+uint64_t SrmsServer::upsert(const Student& s) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (history) history->apply(db, s);
+    else db.upsert(s);
+    journal.logUpsert(s);
+    vector<StudentSnapshot::Edit> edit(1);
+    edit[0].roll = s.roll;
+    edit[0].row = s;
+    auto next = snapshot()->apply(edit);
+    std::atomic_store(&current, next);
+    journal.maybeCompact(db);
+    return next->version();
+}
+
+bool SrmsServer::erase(int roll, uint64_t* version) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (history ? !history->applyErase(db, roll) : !db.erase(roll)) return false;
+    journal.logErase(roll);
+    sessions.forget(roll);
+    vector<StudentSnapshot::Edit> edit(1);
+    edit[0].erase = true;
+    edit[0].roll = roll;
+    auto next = snapshot()->apply(edit);
+    std::atomic_store(&current, next);
+    journal.maybeCompact(db);
+    if (version) *version = next->version();
+    return true;
+}
+
+// ---------- Client ----------
+bool SrmsClient::connect(const string& host, int port) {
+    close();
+    sock = connect_tcp(host, port);
+    return sock != NO_SOCKET;
+}
+
+void SrmsClient::close() {
+    if (sock == NO_SOCKET) return;
+    sock_close(sock);
+    sock = NO_SOCKET;
+    buf.clear();
+}
+
+bool SrmsClient::request(std::string_view line, string& reply) {
+    if (sock == NO_SOCKET) return false;
+    string msg;
+    msg.reserve(line.size() + 1);
+    msg.append(line.data(), line.size());
+    msg += '\n';
+    if (!send_all(sock, msg.data(), msg.size())) return false;
+    size_t nl;
+    while ((nl = buf.find('\n')) == string::npos) {
+        char tmp[4096];
+        long n = recv_some(sock, tmp, sizeof tmp);
+        if (n <= 0) return false;
+        buf.append(tmp, (size_t)n);
+    }
+    reply.assign(buf, 0, nl);
+    buf.erase(0, nl + 1);
+    return true;
+}
+
+// ---------- Load Generator ----------
+LoadReport run_load(const string& host, int port, int clients, double seconds, int maxRoll,
+                    const string& adminUser, const string& adminPassword, int editsPerSec) {
+    using Clock = std::chrono::steady_clock;
+    LoadReport rep;
+    rep.clients = clients;
+    maxRoll = std::max(maxRoll, 1);
+
+    struct Worker {
+        vector<float> latUs;
+        size_t answered = 0, rejected = 0, failures = 0;
+    };
+    vector<Worker> workers(clients);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    Clock::time_point deadline;
+
+    auto reader = [&](int id) {
+        Worker& w = workers[id];
+        SrmsClient c;
+        bool ok = c.connect(host, port);
+        ready++;
+        while (!go) std::this_thread::yield();
+        if (!ok) {
+            w.failures++;
+            return;
+        }
+        std::mt19937 rng(1000 + id);
+        string line, reply;
+        w.latUs.reserve(1 << 16);
+        string r;
+        for (size_t i = 0; Clock::now() < deadline; ++i) {
+            // GET asks for the roll just logged in as.
+            if (!(i & 1)) r = std::to_string((int)(rng() % (uint32_t)maxRoll) + 1);
+            line = (i & 1) ? "GET " + r : "LOGIN " + r + " pw" + r;
+            auto t0 = Clock::now();
+            if (!c.request(line, reply)) {
+                w.failures++;
+                return;
+            }
+            w.latUs.push_back(std::chrono::duration<float, std::micro>(Clock::now() - t0).count());
+            w.answered++;
+            if (reply.compare(0, 3, "ERR") == 0) w.rejected++;
+        }
+    };
+
+    size_t edits = 0;
+    auto writer = [&] {
+        SrmsClient c;
+        string reply;
+        bool ok = c.connect(host, port) && c.request("ADMIN " + adminUser + " " + adminPassword, reply) && reply == "OK";
+        ready++;
+        while (!go) std::this_thread::yield();
+        if (!ok) return;
+        std::mt19937 rng(7);
+        auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / editsPerSec));
+        for (auto next = Clock::now(); next < deadline; next += step) {
+            std::this_thread::sleep_until(next);
+            int roll = (int)(rng() % (uint32_t)maxRoll) + 1;
+            string r = std::to_string(roll);
+            string row = "PUT " + r + ",Student " + r + "," + hash_password("pw" + r, AUTH_MIN_COST) + "," +
+                         std::to_string(rng() % 101) + ";" +
+                         std::to_string(rng() % 101) + ";" + std::to_string(rng() % 101);
+            if (!c.request(row, reply)) return;
+            edits++;
+        }
+    };
+
+    vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i) threads.emplace_back(reader, i);
+    if (editsPerSec > 0) threads.emplace_back(writer);
+    while (ready < (int)threads.size()) std::this_thread::yield();
+    auto start = Clock::now();
+    deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    go = true;
+    for (std::thread& t : threads) t.join();
+    rep.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    rep.edits = edits;
+
+    vector<float> lat;
+    for (Worker& w : workers) {
+        rep.requests += w.answered;
+        rep.rejected += w.rejected;
+        rep.failures += w.failures;
+        lat.insert(lat.end(), w.latUs.begin(), w.latUs.end());
+    }
+    if (!lat.empty()) {
+        auto at = [&](double q) {
+            size_t k = std::min(lat.size() - 1, (size_t)(q * lat.size()));
+            std::nth_element(lat.begin(), lat.begin() + k, lat.end());
+            return (double)lat[k];
+        };
+        rep.p50Us = at(0.50);
+        rep.p99Us = at(0.99);
+        rep.maxUs = *std::max_element(lat.begin(), lat.end());
+    }
+    return rep;
+}
@@ -0,0 +1,122 @@
+// Multi-client SRMS server on TCP loopback, its client and a load generator (no raylib dependency)
+
+#pragma once
+#include "course_schema.h"
+#include "student_auth.h"
+#include "student_history.h"
+#include "student_io.h"
+#include "student_snapshot.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int SRMS_DEFAULT_PORT = 5150;
+
+// One request line in, one response line out:
+//   LOGIN <roll> <password>           OK <name>                    | ERR bad login
+//   GET <roll>                        OK <roll>,<name>,<marks>,<total>   | ERR not found
+//                                     | ERR login first: only the roll this connection
+//                                     LOGINed as, or any roll after ADMIN
+//   STATS                             OK <students> <version>
+//   ADMIN <username> <password>       OK, and PUT/DEL are allowed on this connection
+//   PUT <roll>,<name>,<password>,<marks>   OK <version>   (password: plaintext or a stored hash;
+//                                     marks are checked against the course)
+//   DEL <roll>                        OK <version>                 | ERR not found
+//   QUIT
+// Readers (LOGIN, GET, STATS) take the current StudentSnapshot with one
+// atomic load and never wait for a writer. Writers are serialized: each edit
+// goes to the store (through the history, if set) and the journal, then a
+// new snapshot that shares all untouched shards is published. Every
+// connection has its own thread.
+// Logins go through a SessionCache, so only a client's first LOGIN pays for
+// the password hash; PUT stores plaintext passwords hashed at admin.cost.
+class SrmsServer {
+public:
+    SrmsServer(StudentStore& db, StudentJournal& journal, const CourseSchema& course);
+    ~SrmsServer();
+
+    AdminConfig admin;       // admin / 12345 until the caller loads admin.cfg
+    SessionCache sessions;
+    CourseSchema course;     // set before start()
+    // Set before start() to put PUT/DEL on the edit history's timeline.
+    EditHistory* history = nullptr;
+
+    // Listens on 127.0.0.1:port (0 picks a free one) and serves from
+    // background threads until stop().
+    bool start(int port);
+    void stop();
+    int port() const { return boundPort; }
+    size_t connections() const { return liveConnections; }
+
+    std::shared_ptr<const StudentSnapshot> snapshot() const { return std::atomic_load(&current); }
+    // The write path, also used by PUT and DEL.
+    uint64_t upsert(const Student& s);
+    bool erase(int roll, uint64_t* version = nullptr);
+
+private:
+    struct Connection {
+        std::thread thread;
+        intptr_t sock;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    void acceptLoop();
+    // What a connection has proven: ADMIN, and the roll it last LOGINed as
+    // (a failed LOGIN forgets it).
+    struct Caller {
+        bool admin = false;
+        bool loggedIn = false;
+        int roll = 0;
+    };
+    void serve(intptr_t sock, std::shared_ptr<std::atomic<bool>> done);
+    void handle(std::string_view line, Caller& caller, std::string& out);
+    void reap(bool all);
+
+    StudentStore& db;
+    StudentJournal& journal;
+    std::shared_ptr<const StudentSnapshot> current;
+    std::mutex writeMutex;
+
+    intptr_t listener = -1;
+    int boundPort = 0;
+    std::atomic<bool> stopping{false};
+    std::thread acceptor;
+    std::mutex connMutex;
+    std::vector<Connection> conns;
+    std::atomic<size_t> liveConnections{0};
+};
+
+// Blocking line client for the protocol above.
+class SrmsClient {
+public:
+    ~SrmsClient() { close(); }
+    bool connect(const std::string& host, int port);
+    void close();
+    // Sends line and waits for the reply (without its newline).
+    bool request(std::string_view line, std::string& reply);
+
+private:
+    intptr_t sock = -1;
+    std::string buf;
+};
+
+struct LoadReport {
+    int clients = 0;
+    double seconds = 0;
+    size_t requests = 0;     // answered reads, rejected ones included
+    size_t rejected = 0;     // answered with ERR (unknown roll, wrong password)
+    size_t failures = 0;     // connection or protocol errors
+    size_t edits = 0;        // answered PUTs from the admin connection
+    double p50Us = 0, p99Us = 0, maxUs = 0;
+};
+
+// `clients` connections alternate LOGIN (password "pw<roll>") on a random
+// roll in [1, maxRoll] and GET of that roll for `seconds`, while one admin connection
+// PUTs up to editsPerSec edits per second (0 = none), sending passwords
+// already hashed at the minimum cost so the edits stay cheap. Latencies are per
+// read request, measured at the client.
+LoadReport run_load(const std::string& host, int port, int clients, double seconds, int maxRoll,
+                    const std::string& adminUser, const std::string& adminPassword, int editsPerSec);
@@ -1,6 +1,8 @@
-// Compile: g++ student.cpp -o student.exe -std=c++17 -lraylib -lopengl32 -lgdi32 -lwinmm
+// Compile: g++ student.cpp srms_engine.cpp student_store.cpp name_index.cpp marks_table.cpp score_rank.cpp student_io.cpp student_bulk.cpp student_search.cpp student_list.cpp request_inbox.cpp student_snapshot.cpp student_auth.cpp course_schema.cpp student_history.cpp work_pool.cpp report_cards.cpp profiler.cpp mapped_file.cpp -o student.exe -O3 -std=c++17 -pthread -lraylib -lopengl32 -lgdi32 -lwinmm
 
 #include "raylib.h"
+#include "srms_engine.h"
+#include "student_list.h"
 #include <vector>
 #include <string>
 #include <fstream>
@@ -8,121 +10,27 @@
 #include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <ctime>
+#include <cctype>
+#include <charconv>
 
 using std::string;
 using std::vector;
 
 // ---------- Config ----------
-const string DATA_FILE = "students.csv";
-const string REQUEST_FILE = "requests.txt";
-const int DEFAULT_SUBJECTS = 3;
+const string DATA_FILE = SRMS_DATA_FILE;
+const string REQUEST_FILE = SRMS_REQUEST_FILE;
+const string ADMIN_FILE = SRMS_ADMIN_FILE;
+const string REPORT_DIR = SRMS_REPORT_DIR;
 const int TARGET_W = 1920;
 const int TARGET_H = 1080;
 
-// ---------- Data ----------
-struct Student {
-    int roll = 0;
-    string name;
-    string password;
-    vector<int> marks;
-    double totalScore() const {
-        double s = 0;
-        for (int m : marks) s += m;
-        return s;
-    }
-    double averageScore() const {
-        if (marks.empty()) return 0.0;
-        return totalScore() / marks.size();
-    }
-};
-
-// ---------- CSV Helpers ----------
-string join_marks(const vector<int>& m) {
-    std::stringstream ss;
-    for (size_t i = 0; i < m.size(); ++i) {
-        if (i) ss << ';';
-        ss << m[i];
-    }
-    return ss.str();
-}
-vector<int> parse_marks(const string &s) {
-    vector<int> out;
-    std::stringstream ss(s);
-    string cur;
-    while (getline(ss, cur, ';')) {
-        if (!cur.empty()) try { out.push_back(std::stoi(cur)); } catch(...) {}
-    }
-    return out;
-}
-bool save_to_file(const vector<Student>& db) {
-    std::ofstream f(DATA_FILE);
-    if (!f) return false;
-    f << "roll,name,password,marks\n";
-    for (auto &s : db) {
-        string name = s.name;
-        if (name.find(',') != string::npos || name.find('"') != string::npos) {
-            string tmp;
-            for (char c : name) tmp += (c == '"') ? "\"\"" : string(1,c);
-            name = "\"" + tmp + "\"";
-        }
-        string pwd = s.password;
-        if (pwd.find(',') != string::npos || pwd.find('"') != string::npos) {
-            string tmp;
-            for (char c : pwd) tmp += (c == '"') ? "\"\"" : string(1,c);
-            pwd = "\"" + tmp + "\"";
-        }
-        f << s.roll << "," << name << "," << pwd << "," << join_marks(s.marks) << "\n";
-    }
-    return true;
-}
-bool load_from_file(vector<Student>& db) {
-    std::ifstream f(DATA_FILE);
-    if (!f) return false;
-    db.clear();
-    string line;
-    getline(f, line); // skip header
-    while (getline(f, line)) {
-        if (line.empty()) continue;
-        vector<string> parts;
-        string cur;
-        bool inQuotes = false;
-        for (size_t i=0;i<line.size();i++) {
-            char c = line[i];
-            if (c == '"') {
-                if (inQuotes && i+1 < line.size() && line[i+1]=='"') { cur.push_back('"'); i++; }
-                else inQuotes = !inQuotes;
-            } else if (c==',' && !inQuotes) { parts.push_back(cur); cur.clear(); }
-            else cur.push_back(c);
-        }
-        parts.push_back(cur);
-        if (parts.size()<4) continue;
-        Student s;
-        try { s.roll = std::stoi(parts[0]); } catch(...) { continue; }
-        s.name = parts[1];
-        s.password = parts[2];
-        s.marks = parse_marks(parts[3]);
-        if ((int)s.marks.size() < DEFAULT_SUBJECTS) s.marks.resize(DEFAULT_SUBJECTS, 0);
-        db.push_back(s);
-    }
-    return true;
-}
-
-// ---------- Requests ----------
-void SaveRequest(int roll, const string &msg) {
-    std::ofstream f(REQUEST_FILE, std::ios::app);
-    if (!f) return;
-    f << "Roll " << roll << ": " << msg << "\n";
-}
-vector<string> LoadRequests() {
-    vector<string> out;
-    std::ifstream f(REQUEST_FILE);
-    if (!f) return out;
-    string line;
-    while (getline(f,line)) if (!line.empty()) out.push_back(line);
-    return out;
-}
-void ClearRequests() {
-    std::ofstream f(REQUEST_FILE,std::ios::trunc);
+// ---------- Input ----------
+// Whole field as a decimal int: no trailing text, nothing out of range.
+bool ParseIntField(const string &text, int &out) {
+    const char *end = text.data() + text.size();
+    auto r = std::from_chars(text.data(), end, out);
+    return !text.empty() && r.ec == std::errc() && r.ptr == end;
 }
 
 // ---------- Text Field (placeholder + caret) ----------
@@ -177,34 +85,97 @@ bool Button(const Rectangle &r, const char* label, int fontSize = 20) {
 }
 
 // ---------- Student List ----------
-int DrawStudentList(const vector<Student>& db, const Rectangle &area, int &outOffset, int fontSize) {
+// Draws only the rows in view; row strings come from the view's cache, so
+// an idle frame formats nothing. Rows are store slots, or hits[row] while a
+// search is active. Returns the clicked row or -1.
+int DrawStudentList(const StudentStore& db, const Rectangle &area, StudentListView &view,
+                    const vector<uint32_t>* hits, int fontSize) {
+    PROFILE_SCOPE("DrawStudentList");
     DrawRectangleRec(area, RAYWHITE);
     DrawRectangleLinesEx(area, 2, BLACK);
-    int itemH = fontSize + 12;
-    int visible = (int)area.height / itemH;
-    int N = db.size();
-    int maxOffset = std::max(0, N - visible);
+    float itemH = (float)(fontSize + 12);
+    view.setViewport(area.height, itemH);
+    size_t N = hits ? hits->size() : db.size();
+    Vector2 m = GetMousePosition();
     float wheel = GetMouseWheelMove();
-    if (wheel != 0) { outOffset -= (int)wheel; if (outOffset < 0) outOffset = 0; if (outOffset > maxOffset) outOffset = maxOffset; }
-    int start = outOffset;
-    int y = (int)area.y;
-    for (int i = 0; i < visible; ++i) {
-        int idx = start + i;
-        Rectangle item = { area.x, (float)y, area.width, (float)itemH-2 };
-        if (idx < N) {
-            Color bg = (i % 2 == 0) ? Fade(LIGHTGRAY, 0.35f) : Fade(LIGHTGRAY, 0.25f);
-            DrawRectangleRec(item, bg);
-            string line = std::to_string(db[idx].roll) + " | " + db[idx].name + " | Score:" + std::to_string((int)db[idx].totalScore());
-            DrawText(line.c_str(), (int)item.x + 8, (int)item.y + 6, fontSize, BLACK);
-            Vector2 m = GetMousePosition();
-            if (m.x >= item.x && m.x <= item.x + item.width && m.y >= item.y && m.y <= item.y + item.height) {
-                DrawRectangleLinesEx(item, 2, RED);
-                if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) return idx;
-            }
+    if (wheel != 0 && CheckCollisionPointRec(m, area)) view.scrollBy(-wheel * itemH * 3);
+    view.tick(GetFrameTime(), N);
+    StudentListView::Window w = view.window(N);
+    PROFILE_COUNT("student rows drawn", w.last - w.first);
+    int clicked = -1;
+    BeginScissorMode((int)area.x, (int)area.y, (int)area.width, (int)area.height);
+    float y = area.y + w.offsetY;
+    for (size_t row = w.first; row < w.last; ++row, y += itemH) {
+        size_t slot = hits ? (*hits)[row] : row;
+        Rectangle item = { area.x, y, area.width, itemH - 2 };
+        Color bg = (row % 2 == 0) ? Fade(LIGHTGRAY, 0.35f) : Fade(LIGHTGRAY, 0.25f);
+        if ((int)row == view.selected) bg = Fade(SKYBLUE, 0.45f);
+        DrawRectangleRec(item, bg);
+        DrawText(view.rowText(db, row, slot).c_str(), (int)item.x + 8, (int)item.y + 6, fontSize, BLACK);
+        if (CheckCollisionPointRec(m, area) && CheckCollisionPointRec(m, item)) {
+            DrawRectangleLinesEx(item, 2, RED);
+            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) clicked = (int)row;
         }
-        y += itemH;
     }
-    return -1;
+    EndScissorMode();
+    return clicked;
+}
+
+// ---------- Request List ----------
+// Same scrolling as the student list over inbox records (newest first). A
+// row's text is formatted as it is drawn, which is a few dozen per frame
+// however many requests are queued. Returns the clicked row or -1.
+int DrawRequestList(const RequestInbox &inbox, const Rectangle &area, StudentListView &view,
+                    const RequestRows &rows, int fontSize) {
+    PROFILE_SCOPE("DrawRequestList");
+    DrawRectangleRec(area, RAYWHITE);
+    DrawRectangleLinesEx(area, 2, BLACK);
+    float itemH = (float)(fontSize + 12);
+    view.setViewport(area.height, itemH);
+    size_t N = rows.size();
+    Vector2 m = GetMousePosition();
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0 && CheckCollisionPointRec(m, area)) view.scrollBy(-wheel * itemH * 3);
+    view.tick(GetFrameTime(), N);
+    StudentListView::Window w = view.window(N);
+    int clicked = -1;
+    BeginScissorMode((int)area.x, (int)area.y, (int)area.width, (int)area.height);
+    float y = area.y + w.offsetY;
+    for (size_t row = w.first; row < w.last; ++row, y += itemH) {
+        const RequestRecord &r = inbox.record(rows[row]);
+        std::string_view msg = inbox.text(rows[row]);
+        bool resolved = r.status == RequestStatus::RESOLVED;
+        Rectangle item = { area.x, y, area.width, itemH - 2 };
+        Color bg = (row % 2 == 0) ? Fade(LIGHTGRAY, 0.35f) : Fade(LIGHTGRAY, 0.25f);
+        if ((int)row == view.selected) bg = Fade(SKYBLUE, 0.45f);
+        DrawRectangleRec(item, bg);
+        char when[32] = "";
+        time_t t = (time_t)r.time;
+        if (r.time) strftime(when, sizeof when, "%Y-%m-%d %H:%M", localtime(&t));
+        const char* text = r.roll >= 0
+            ? TextFormat("Roll %-6d %-17s %s%.*s", r.roll, when, resolved ? "[resolved] " : "", (int)msg.size(), msg.data())
+            : TextFormat("%.*s", (int)msg.size(), msg.data());
+        DrawText(text, (int)item.x + 8, (int)item.y + 6, fontSize, resolved ? GRAY : BLACK);
+        if (CheckCollisionPointRec(m, area) && CheckCollisionPointRec(m, item)) {
+            DrawRectangleLinesEx(item, 2, RED);
+            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) clicked = (int)row;
+        }
+    }
+    EndScissorMode();
+    return clicked;
+}
+
+// ---------- Profiling Overlay ----------
+// F3 toggles it: frame-time percentiles over the last 240 frames, then each
+// zone's cost per frame and the counters.
+void DrawProfileOverlay(int fontSize) {
+    vector<string> lines = profile_overlay_lines();
+    int w = 0;
+    for (const string &l : lines) w = std::max(w, MeasureText(l.c_str(), fontSize));
+    int lh = fontSize + 4;
+    int x = GetScreenWidth() - w - 16, y = 8;
+    DrawRectangle(x - 8, y - 4, w + 16, lh * (int)lines.size() + 8, Fade(BLACK, 0.75f));
+    for (size_t i = 0; i < lines.size(); ++i) DrawText(lines[i].c_str(), x, y + (int)i * lh, fontSize, i == 0 ? YELLOW : WHITE);
 }
 
 // ---------- Utilities ----------
@@ -213,14 +184,37 @@ void activateOnly(TextField* which, const vector<TextField*> &allFields) {
 }
 
 // ---------- Main ----------
-int main() {
+// student.exe [--profile metrics.json] [--trace trace.json]: written on exit.
+int main(int argc, char** argv) {
+    ProfileArgs profileArgs = profile_parse_args(argc, argv);
     const int screenW = TARGET_W;
     const int screenH = TARGET_H;
     InitWindow(screenW, screenH, "Student Result Management System");
     SetTargetFPS(60);
 
-    vector<Student> db;
-    load_from_file(db);
+    // students.course names the subjects; without one there are SRMS_DEFAULT_SUBJECTS out of 100.
+    CourseSchema course;
+    open_course(DATA_FILE, course);
+    StudentStore db;
+    StudentJournal journal(DATA_FILE);
+    open_database(db, DATA_FILE, course.count(), &journal);
+    // The admin panel's top 10 and the rank lines need it; build it before the first frame.
+    db.warmRanking();
+    // Edits are written by the journal's own thread, so a slow disk never stalls a frame.
+    journal.startWriter();
+    // Imports, exports and compaction read this copy of the store on their own threads.
+    journal.trackSnapshot(db);
+    // Admin edits go through the history, which gives undo/redo and the per-student audit trail.
+    EditHistory history;
+    history.open(DATA_FILE + ".history");
+    RequestInbox inbox(REQUEST_FILE);
+    inbox.load();
+    uint64_t inboxGeneration = inbox.generation();
+    // A plaintext admin.cfg is rewritten with the password hashed.
+    AdminConfig adminCfg;
+    load_admin_config(ADMIN_FILE, adminCfg);
+    if (adminCfg.upgraded) save_admin_config(ADMIN_FILE, adminCfg);
+    SessionCache sessions;
 
     enum Screen { SCR_MAIN, SCR_ADMIN_LOGIN, SCR_ADMIN_PANEL, SCR_STUDENT_LOGIN, SCR_STUDENT_PANEL, SCR_ADD_STUDENT, SCR_VIEW_STUDENTS, SCR_VIEW_REQUESTS } screen = SCR_MAIN;
     Screen prevScreen = SCR_MAIN;
@@ -240,27 +234,49 @@ int main() {
     TextField tfRoll{"", {0,0,0,0}, false, 256, 0, "Enter Id Number", false};
     TextField tfName{"", {0,0,0,0}, false, 256, 0, "Student name", false};
     TextField tfPassword{"", {0,0,0,0}, false, 256, 0, "Set password", true};
-    TextField tfSubCount{std::to_string(DEFAULT_SUBJECTS), {0,0,0,0}, false, 4, 0, "Subjects", false};
+    TextField tfSubCount{std::to_string(course.count()), {0,0,0,0}, false, 4, 0, "Subjects", false};
     TextField tfRequestMsg{"", {0,0,0,0}, false, 512, 0, "Type your request here...", false};
-    TextField tfSearchRoll{"", {0,0,0,0}, false, 64, 0, "Search roll", false};
+    TextField tfCsvPath{"", {0,0,0,0}, false, 260, 0, "CSV file to import/export (or drop one here)", false};
+    TextField tfSearchRoll{"", {0,0,0,0}, false, 64, 0, "Roll, name or subject 2 < 40", false};
     vector<TextField> tfMarks;
+    // Marks already typed survive a change of subject count, which is at most the course's.
     auto ensureMarksForCount = [&](int subCount) {
-        if (subCount < 1) subCount = 1;
-        if ((int)tfMarks.size() != subCount) {
-            tfMarks.clear();
-            for (int i = 0; i < subCount; ++i) {
-                TextField m; m.text = "0"; m.rect = {0,0,0,0}; m.maxLen = 4; m.blinkTimer = 0; m.placeholder = "0"; m.passwordMode = false;
-                tfMarks.push_back(m);
-            }
-        }
+        subCount = std::max(1, std::min(subCount, course.count()));
+        TextField m; m.text = "0"; m.rect = {0,0,0,0}; m.maxLen = 5; m.blinkTimer = 0; m.placeholder = "0"; m.passwordMode = false;
+        tfMarks.resize(subCount, m);
     };
-    ensureMarksForCount(DEFAULT_SUBJECTS);
-
-    int studentListOffset = 0;
-    int selectedStudentIndex = -1;
-    int loggedStudentIndex = -1;
+    ensureMarksForCount(course.count());
+
+    StudentListView studentList;
+    // Undo/redo, deletes and imports renumber slots, so the list keeps the
+    // selected roll and finds its row again when the store changes.
+    int selectedRoll = -1;
+    uint64_t listRevision = db.revision();
+    StudentListView requestList;
+    bool showResolved = false;
+    StudentSearch studentSearch;
+    ImportJob importJob;
+    ExportJob exportJob;
+    ReportJob reportJob;
+    bool snapshotDue = false;
+    string exportPath;
+    uint64_t pendingSave = 0;   // journal sequence the last Save/Delete waits for
+    string pendingSaveMsg;
+    int loggedStudentRoll = -1;
     string infoMsg;
     bool adminAuthenticated = false;
+    int auditRoll = -1, auditStep = -1;   // change of auditRoll shown in the details panel, -1 for none
+    bool showProfile = false;
+
+    // Undo/redo change the store through the history and are journaled like any edit.
+    auto undoRedo = [&](bool redo) {
+        const EditHistory::Change* c = redo ? history.redo(db) : history.undo(db);
+        if (!c) { infoMsg = redo ? "Nothing to redo" : "Nothing to undo"; return; }
+        if (c->exists) journal.logUpsert(c->row);
+        else journal.logErase(c->roll);
+        pendingSave = journal.queued(); pendingSaveMsg = (redo ? "Redone: roll " : "Undone: roll ") + std::to_string(c->roll);
+        infoMsg = "Saving...";
+    };
 
     // Main loop
     while (!WindowShouldClose()) {
@@ -306,9 +322,11 @@ int main() {
             float markW = w * 0.18f;
             for (int i = 0; i < (int)tfMarks.size(); ++i) {
                 float mx = bx + (i % 4) * (markW + 22);
-                float my = marksStartY + (i / 4) * (smallH + 12);
+                float my = marksStartY + (i / 4) * (smallH + labelFont + 16);
                 tfMarks[i].rect = { mx, my + labelFont + 4, markW, smallH };
             }
+        } else if (screen == SCR_ADMIN_PANEL) {
+            tfCsvPath.rect = { margin, topY + 90 + 4 * (64 + 18), leftW - margin, 44 };
         } else if (screen == SCR_VIEW_STUDENTS) {
             tfSearchRoll.rect = { listArea.x + 12, listArea.y - 52, listArea.width * 0.55f, 40 };
         } else if (screen == SCR_STUDENT_PANEL) {
@@ -325,7 +343,8 @@ int main() {
         }
         else if (screen == SCR_VIEW_STUDENTS) activeFields = { &tfSearchRoll };
         else if (screen == SCR_STUDENT_PANEL) activeFields = { &tfRequestMsg };
-        else activeFields = {}; // main / admin panel / requests have none or handled fields
+        else if (screen == SCR_ADMIN_PANEL) activeFields = { &tfCsvPath };
+        else activeFields = {}; // main / requests have none or handled fields
 
         // Handle mouse clicks: activate only fields for THIS screen
         if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
@@ -348,6 +367,16 @@ int main() {
         // Now process keyboard input only for activeFields
         for (auto tf : activeFields) ProcessTextField(*tf);
 
+        // Ctrl+Z / Ctrl+Y (or Ctrl+Shift+Z) on the admin screens, unless a field has the keyboard.
+        bool typing = false;
+        for (auto tf : activeFields) typing = typing || tf->active;
+        if ((screen == SCR_ADMIN_PANEL || screen == SCR_VIEW_STUDENTS) && !typing && (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL))) {
+            bool shift = IsKeyDown(KEY_LEFT_SHIFT);
+            if (IsKeyPressed(KEY_Z)) undoRedo(shift);
+            if (IsKeyPressed(KEY_Y)) undoRedo(true);
+        }
+        if (IsKeyPressed(KEY_F3)) showProfile = !showProfile;
+
         // ---------- Draw ----------
         BeginDrawing();
         ClearBackground(RAYWHITE);
@@ -374,7 +403,7 @@ int main() {
             float btnX = adminArea.x + 24;
             float btnY = adminArea.y + adminArea.height - 72;
             if (Button({btnX, btnY, 180, 48}, "Login", btnFont)) {
-                if (tfAdminPass.text == "12345") { adminAuthenticated = true; screen = SCR_ADMIN_PANEL; infoMsg.clear(); }
+                if (verify_admin(adminCfg, tfAdminUser.text, tfAdminPass.text)) { adminAuthenticated = true; screen = SCR_ADMIN_PANEL; infoMsg.clear(); }
                 else infoMsg = "Invalid admin credentials";
             }
             if (Button({btnX + 200, btnY, 180, 48}, "Back", btnFont)) { screen = SCR_MAIN; infoMsg.clear(); }
@@ -391,13 +420,17 @@ int main() {
             if (Button({bx, btnY, 180, 48}, "Login", btnFont)) {
                 try {
                     int r = std::stoi(tfStudentRoll.text);
-                    bool found = false;
-                    for (int i = 0; i < (int)db.size(); ++i) {
-                        if (db[i].roll == r && db[i].password == tfStudentPass.text) {
-                            loggedStudentIndex = i; screen = SCR_STUDENT_PANEL; infoMsg.clear(); found = true; break;
+                    const StudentInfo* st = db.find(r);
+                    if (st && sessions.verify(r, st->password, tfStudentPass.text)) {
+                        // Plaintext from older files (or a cheaper hash) is replaced now that we know the password.
+                        if (password_needs_rehash(st->password, adminCfg.cost)) {
+                            Student s = db.get(db.indexOf(r));
+                            s.password = hash_password(tfStudentPass.text, adminCfg.cost);
+                            history.apply(db, s);
+                            journal.logUpsert(s);
                         }
-                    }
-                    if (!found) infoMsg = "Invalid roll or password";
+                        loggedStudentRoll = r; screen = SCR_STUDENT_PANEL; infoMsg.clear();
+                    } else infoMsg = "Invalid roll or password";
                 } catch (...) { infoMsg = "Invalid roll"; }
             }
             if (Button({bx + 200, btnY, 180, 48}, "Back", btnFont)) { screen = SCR_MAIN; infoMsg.clear(); }
@@ -411,15 +444,58 @@ int main() {
             float h = 64;
             DrawText("Admin Panel", (int)x, (int)(topY + 40), 28, DARKBLUE);
             if (Button({x, y, w, h}, "Add/Edit Student", btnFont)) {
-                tfRoll.text = ""; tfName.text = ""; tfPassword.text = ""; tfSubCount.text = std::to_string(DEFAULT_SUBJECTS);
-                ensureMarksForCount(DEFAULT_SUBJECTS); prevScreen = screen; screen = SCR_ADD_STUDENT;
+                tfRoll.text = ""; tfName.text = ""; tfPassword.text = ""; tfPassword.placeholder = "Set password"; tfSubCount.text = std::to_string(course.count());
+                tfMarks.clear(); ensureMarksForCount(course.count()); prevScreen = screen; screen = SCR_ADD_STUDENT;
             }
             y += h + 18;
-            if (Button({x, y, w, h}, "View Students", btnFont)) { screen = SCR_VIEW_STUDENTS; studentListOffset = 0; selectedStudentIndex = -1; }
+            if (Button({x, y, w, h}, "View Students", btnFont)) { screen = SCR_VIEW_STUDENTS; studentList = StudentListView(); }
             y += h + 18;
             if (Button({x, y, w, h}, "View Requests", btnFont)) { screen = SCR_VIEW_REQUESTS; }
             y += h + 18;
+
+            // Bulk import/export: type a path or drop a file onto the window.
+            if (IsFileDropped()) {
+                FilePathList dropped = LoadDroppedFiles();
+                if (dropped.count > 0) tfCsvPath.text = dropped.paths[0];
+                UnloadDroppedFiles(dropped);
+            }
+            DrawTextField(tfCsvPath, smallFont);
+            y += 44 + 12;
+            float half = (w - 12) / 2;
+            if (Button({x, y, half, h}, importJob.running() ? "Importing..." : "Import CSV", btnFont) && !importJob.running()) {
+                ImportOptions opt;
+                opt.minSubjects = course.count();
+                for (const SubjectDef &sd : course.subjects) opt.subjectMax.push_back(sd.maxMark);
+                if (tfCsvPath.text.empty()) infoMsg = "Enter a CSV path first";
+                else if (importJob.start(tfCsvPath.text, opt, journal.snapshot(), &history)) infoMsg = "Importing " + tfCsvPath.text + "...";
+            }
+            if (Button({x + half + 12, y, half, h}, exportJob.running() ? "Exporting..." : "Export CSV", btnFont) && !exportJob.running()) {
+                if (tfCsvPath.text.empty() || tfCsvPath.text == DATA_FILE) infoMsg = "Enter an export path other than " + string(DATA_FILE);
+                else if (exportJob.start(journal.snapshot(), tfCsvPath.text)) { exportPath = tfCsvPath.text; infoMsg = "Exporting to " + exportPath + "..."; }
+            }
+            y += h + 18;
+            // Cards render from a copy on their own threads; editing carries on meanwhile.
+            if (reportJob.running()) {
+                const ReportProgress &p = reportJob.progress();
+                string label = "Reports: " + std::to_string((size_t)p.cards) + " / " + std::to_string((size_t)p.total) + " (" +
+                               std::to_string((int)(p.cards / std::max(reportJob.elapsed(), 1e-3) / 1000)) + "k cards/s)";
+                Button({x, y, w, h}, label.c_str(), btnFont);
+            } else if (Button({x, y, w, h}, "Report Cards", btnFont)) {
+                if (reportJob.start(db, course, REPORT_DIR, ReportOptions())) infoMsg = "Writing report cards to " + REPORT_DIR + "...";
+            }
+            y += h + 18;
             if (Button({x, y, w, h}, "Logout", btnFont)) { screen = SCR_MAIN; adminAuthenticated = false; }
+
+            // Top 10 straight from the ranking tree: no per-frame sort.
+            Rectangle topR = { leftW + margin * 0.5f, topY + 90, rightW - margin, 44.0f + 10 * 32 };
+            DrawRectangleLinesEx(topR, 2, Fade(DARKGRAY, 0.4f));
+            DrawText(("Top 10 of " + std::to_string(db.size())).c_str(), (int)topR.x + 12, (int)topR.y + 10, 22, DARKBLUE);
+            vector<int> top = db.topRolls(10);
+            for (size_t i = 0; i < top.size(); ++i) {
+                int slot = db.indexOf(top[i]);
+                string line = std::to_string(i+1) + ". " + std::to_string(top[i]) + " | " + db.info(slot).name + " | Score:" + std::to_string((int)db.totalScore(slot));
+                DrawText(line.c_str(), (int)topR.x + 16, (int)topR.y + 44 + (int)i * 32, labelFont, BLACK);
+            }
             if (!infoMsg.empty()) DrawText(infoMsg.c_str(), (int)(leftW + 20), (int)(screenH - 36), smallFont, DARKGRAY);
         }
 
@@ -429,23 +505,37 @@ int main() {
             DrawTextField(tfRoll, inputFont);
             DrawTextField(tfName, inputFont);
             DrawTextField(tfPassword, inputFont);
-            for (int i = 0; i < 3; ++i) {
-                DrawText(("Marks " + std::to_string(i+1)).c_str(), (int)tfMarks[i].rect.x, (int)(tfMarks[i].rect.y - labelFont - 6), labelFont, BLACK);
+            for (int i = 0; i < (int)tfMarks.size(); ++i) {
+                string max = " /" + std::to_string(course.maxMark(i));
+                string label = course.subjectName(i);
+                while (label.size() > 1 && MeasureText((label + max).c_str(), labelFont) > tfMarks[i].rect.width) label.pop_back();
+                DrawText((label + max).c_str(), (int)tfMarks[i].rect.x, (int)(tfMarks[i].rect.y - labelFont - 6), labelFont, BLACK);
                 DrawTextField(tfMarks[i], inputFont);
             }
 
             float btnY = formArea.y + formArea.height - 88;
             if (Button({formArea.x + 28, btnY, 180, 48}, "Save Student", btnFont)) {
-                try {
-                    Student s; s.roll = std::stoi(tfRoll.text); s.name = tfName.text; s.password = tfPassword.text;
-                    s.marks.clear();
-                    for (auto &m : tfMarks) s.marks.push_back(std::stoi(m.text));
-                    if ((int)s.marks.size() < DEFAULT_SUBJECTS) s.marks.resize(DEFAULT_SUBJECTS, 0);
-                    bool dup = false; int dupIdx = -1;
-                    for (int i = 0; i < (int)db.size(); ++i) if (db[i].roll == s.roll) { dup = true; dupIdx = i; break; }
-                    if (dup) db[dupIdx] = s; else db.push_back(s);
-                    if (!save_to_file(db)) infoMsg = "Failed to save to disk"; else { infoMsg = "Saved"; screen = SCR_ADMIN_PANEL; }
-                } catch (...) { infoMsg = "Invalid input"; }
+                Student s; s.name = tfName.text;
+                bool numbers = ParseIntField(tfRoll.text, s.roll);
+                for (auto &m : tfMarks) {
+                    int v = 0;
+                    numbers = ParseIntField(m.text, v) && numbers;
+                    s.marks.push_back(v);
+                }
+                // The course check says what is wrong with the marks.
+                if (const char* why = numbers ? course.check(s.marks) : "invalid input") {
+                    infoMsg = why;
+                    infoMsg[0] = (char)toupper((unsigned char)infoMsg[0]);
+                } else {
+                    // An empty field keeps an existing student's password; only hashes are stored.
+                    const StudentInfo* old = db.find(s.roll);
+                    s.password = (tfPassword.text.empty() && old) ? old->password : hash_password(tfPassword.text, adminCfg.cost);
+                    if ((int)s.marks.size() < course.count()) s.marks.resize(course.count(), 0);
+                    history.upsert(db, s);
+                    journal.logUpsert(s);
+                    pendingSave = journal.queued(); pendingSaveMsg = "Saved";
+                    infoMsg = "Saving..."; screen = SCR_ADMIN_PANEL;
+                }
             }
             if (Button({formArea.x + 220, btnY, 180, 48}, "Back", btnFont)) { screen = prevScreen; }
 
@@ -453,22 +543,58 @@ int main() {
         }
 
         else if (screen == SCR_VIEW_STUDENTS) {
-            DrawText("Students", (int)listArea.x, (int)(listArea.y - 36), 28, DARKBLUE);
-            int sel = DrawStudentList(db, listArea, studentListOffset, smallFont);
-            if (sel != -1) selectedStudentIndex = sel;
-
-            if (selectedStudentIndex >= 0 && selectedStudentIndex < (int)db.size()) {
-                Student &s = db[selectedStudentIndex];
+            DrawTextField(tfSearchRoll, smallFont);
+            float headX = tfSearchRoll.rect.x + tfSearchRoll.rect.width + 24;
+            DrawText("Students", (int)headX, (int)(listArea.y - 44), 28, DARKBLUE);
+            db.warmNameIndex(20000);   // ~1M names per second of frames, so the first search doesn't stall
+            if (studentSearch.update(db, tfSearchRoll.text)) studentList.reset();
+            const vector<uint32_t>* hits = studentSearch.active() ? &studentSearch.hits() : nullptr;
+            size_t rows = hits ? hits->size() : db.size();
+            if (db.revision() != listRevision) {
+                listRevision = db.revision();
+                int slot = studentList.selected >= 0 ? db.indexOf(selectedRoll) : -1;
+                if (hits && slot >= 0) {
+                    auto it = std::find(hits->begin(), hits->end(), (uint32_t)slot);
+                    slot = it == hits->end() ? -1 : (int)(it - hits->begin());
+                }
+                studentList.selected = slot;
+            }
+            if (studentSearch.active() || !studentSearch.error().empty()) {
+                const char* status = !studentSearch.error().empty() ? studentSearch.error().c_str()
+                    : TextFormat("%d %s (%.1f ms)", (int)rows, studentSearch.fuzzy() ? "close matches" : "matches", studentSearch.lastMs());
+                DrawText(status, (int)headX + MeasureText("Students", 28) + 16, (int)(listArea.y - 38), smallFont - 2, DARKGRAY);
+            }
+            // Enter picks the first hit: the exact roll for a roll number, else the best name match.
+            if (tfSearchRoll.active && IsKeyPressed(KEY_ENTER)) {
+                if (rows > 0) studentList.jumpTo(0, rows);
+            } else if (!tfSearchRoll.active) {
+                if (IsKeyPressed(KEY_PAGE_DOWN)) studentList.pageDown(rows);
+                if (IsKeyPressed(KEY_PAGE_UP)) studentList.pageUp(rows);
+                if (IsKeyPressed(KEY_HOME)) studentList.home();
+                if (IsKeyPressed(KEY_END)) studentList.end(rows);
+                if (IsKeyPressed(KEY_DOWN)) studentList.moveSelection(1, rows);
+                if (IsKeyPressed(KEY_UP)) studentList.moveSelection(-1, rows);
+            }
+            int sel = DrawStudentList(db, listArea, studentList, hits, smallFont);
+            if (sel != -1) studentList.selected = sel;
+
+            int selectedSlot = -1;
+            if (studentList.selected >= 0 && studentList.selected < (int)rows)
+                selectedSlot = hits ? (int)(*hits)[studentList.selected] : studentList.selected;
+            selectedRoll = selectedSlot >= 0 ? db.info(selectedSlot).roll : -1;
+            if (selectedSlot >= 0) {
+                Student s = db.get(selectedSlot);
                 Rectangle infoR = { formArea.x, formArea.y + 20, formArea.width - 40, 360 };
                 DrawRectangleRec(infoR, Fade(LIGHTGRAY, 0.18f));
                 DrawRectangleLinesEx(infoR, 2, BLACK);
                 DrawText(("Roll: " + std::to_string(s.roll)).c_str(), (int)infoR.x + 12, (int)infoR.y + 8, 22, BLACK);
                 DrawText(("Name: " + s.name).c_str(), (int)infoR.x + 12, (int)infoR.y + 44, 20, BLACK);
-                DrawText(("Password: " + s.password).c_str(), (int)infoR.x + 12, (int)infoR.y + 74, 18, BLACK);
-                DrawText(("Total: " + std::to_string((int)s.totalScore())).c_str(), (int)infoR.x + 12, (int)infoR.y + 106, 18, BLACK);
+                DrawText(is_password_hash(s.password) ? "Password: set" : "Password: set (hashed at next login)", (int)infoR.x + 12, (int)infoR.y + 74, 18, BLACK);
+                DrawText(("Total: " + std::to_string((int)db.totalScore(selectedSlot))).c_str(), (int)infoR.x + 12, (int)infoR.y + 106, 18, BLACK);
+                DrawText(("Rank: " + std::to_string(db.rankOf(s.roll)) + " of " + std::to_string(db.size())).c_str(), (int)infoR.x + 12, (int)infoR.y + 134, 18, BLACK);
 
                 if (Button({ infoR.x + 12, infoR.y + 170, 180, 48 }, "Edit", btnFont)) {
-                    tfRoll.text = std::to_string(s.roll); tfName.text = s.name; tfPassword.text = s.password;
+                    tfRoll.text = std::to_string(s.roll); tfName.text = s.name; tfPassword.text = ""; tfPassword.placeholder = "Leave empty to keep";
                     tfSubCount.text = std::to_string((int)s.marks.size());
                     ensureMarksForCount((int)s.marks.size());
                     for (size_t i = 0; i < s.marks.size() && i < tfMarks.size(); ++i) tfMarks[i].text = std::to_string(s.marks[i]);
@@ -476,62 +602,178 @@ int main() {
                     screen = SCR_ADD_STUDENT;
                 }
                 if (Button({ infoR.x + 210, infoR.y + 170, 180, 48 }, "Delete", btnFont)) {
-                    db.erase(db.begin() + selectedStudentIndex);
-                    selectedStudentIndex = -1;
-                    save_to_file(db);
+                    int roll = s.roll;
+                    history.erase(db, roll);
+                    studentList.selected = -1;
+                    journal.logErase(roll);
+                    pendingSave = journal.queued(); pendingSaveMsg = "Deleted (Ctrl+Z to undo)";
+                }
+
+                // Audit trail: step through this student's changes, each with the row before and after it.
+                const vector<uint32_t> *versions = history.versionsOf(s.roll);
+                if (auditRoll != s.roll) { auditRoll = s.roll; auditStep = -1; }
+                int changes = versions ? (int)versions->size() : 0;
+                DrawText(TextFormat("History: %d change%s", changes, changes == 1 ? "" : "s"), (int)infoR.x + 12, (int)infoR.y + 240, 18, BLACK);
+                if (changes > 0) {
+                    if (Button({ infoR.x + 210, infoR.y + 230, 120, 40 }, "Older", smallFont))
+                        auditStep = auditStep < 0 ? changes - 1 : std::max(0, auditStep - 1);
+                    if (Button({ infoR.x + 342, infoR.y + 230, 120, 40 }, "Newer", smallFont))
+                        auditStep = (auditStep < 0 || auditStep + 1 >= changes) ? -1 : auditStep + 1;
+                }
+                if (auditStep >= 0 && auditStep < changes) {
+                    uint64_t v = (*versions)[auditStep];
+                    const EditHistory::Change &c = history.change(v);
+                    time_t t = (time_t)c.time;
+                    char when[32];
+                    strftime(when, sizeof when, "%Y-%m-%d %H:%M:%S", localtime(&t));
+                    DrawText(TextFormat("%d of %d: %s at %s", auditStep + 1, changes, EditHistory::kindName(c.kind), when), (int)infoR.x + 476, (int)infoR.y + 240, 18, DARKBLUE);
+                    Student before;
+                    bool existed = history.find(db, s.roll, v - 1, before);
+                    string was = existed ? before.name + " | " + join_marks(before.marks) : "(not there)";
+                    string now = c.exists ? c.row.name + " | " + join_marks(c.row.marks) : "(deleted)";
+                    DrawText(("Before: " + was).c_str(), (int)infoR.x + 12, (int)infoR.y + 282, 18, BLACK);
+                    DrawText(("After:  " + now).c_str(), (int)infoR.x + 12, (int)infoR.y + 312, 18, BLACK);
                 }
             }
             if (Button({ margin, screenH - 84, 180, 48 }, "Back", btnFont)) screen = SCR_ADMIN_PANEL;
+            if (Button({ margin + 192, screenH - 84, 140, 48 }, "Undo", btnFont)) undoRedo(false);
+            if (Button({ margin + 344, screenH - 84, 140, 48 }, "Redo", btnFont)) undoRedo(true);
+            if (!infoMsg.empty()) DrawText(infoMsg.c_str(), (int)(margin + 504), screenH - 72, smallFont, RED);
         }
 
         else if (screen == SCR_VIEW_REQUESTS) {
+            // New lines from the student screen (or another instance) are read from the last offset on.
+            inbox.poll();
+            // A compaction (here or elsewhere) renumbers the records, so the selected row means nothing now.
+            if (inbox.generation() != inboxGeneration) { inboxGeneration = inbox.generation(); requestList.selected = -1; }
+            const RequestRows &reqRows = inbox.rows(showResolved);
+            size_t rows = reqRows.size();
             DrawText("Requests", (int)reqArea.x, (int)(reqArea.y - 36), 28, DARKBLUE);
-            vector<string> reqs = LoadRequests();
-            float y = reqArea.y + 12;
-            float lineH = smallFont + 8;
-            for (size_t i = 0; i < reqs.size(); ++i) {
-                DrawText(reqs[i].c_str(), (int)reqArea.x + 8, (int)y, smallFont, BLACK);
-                y += lineH;
-                if (y > reqArea.y + reqArea.height - 80) break;
+            DrawText(TextFormat("%d open, %d in total", (int)inbox.openCount(), (int)inbox.liveCount()),
+                     (int)reqArea.x + MeasureText("Requests", 28) + 16, (int)(reqArea.y - 30), smallFont, DARKGRAY);
+            if (IsKeyPressed(KEY_PAGE_DOWN)) requestList.pageDown(rows);
+            if (IsKeyPressed(KEY_PAGE_UP)) requestList.pageUp(rows);
+            if (IsKeyPressed(KEY_HOME)) requestList.home();
+            if (IsKeyPressed(KEY_END)) requestList.end(rows);
+            if (IsKeyPressed(KEY_DOWN)) requestList.moveSelection(1, rows);
+            if (IsKeyPressed(KEY_UP)) requestList.moveSelection(-1, rows);
+            Rectangle listR = { reqArea.x, reqArea.y, reqArea.width, reqArea.height - 84 };
+            int sel = DrawRequestList(inbox, listR, requestList, reqRows, smallFont);
+            if (sel != -1) requestList.selected = sel;
+            if (requestList.selected >= (int)rows) requestList.selected = (int)rows - 1;
+            int selectedRec = requestList.selected >= 0 ? (int)reqRows[requestList.selected] : -1;
+
+            float by = reqArea.y + reqArea.height - 72;
+            float bx = reqArea.x + 8;
+            if (Button({ bx, by, 160, 48 }, "Resolve", btnFont) && selectedRec >= 0) {
+                if (!inbox.resolve(selectedRec)) infoMsg = inbox.generation() != inboxGeneration ? "Requests were reloaded; select again" : "Already resolved";
+                else { infoMsg = "Request resolved"; inbox.maybeCompact(); }
+            }
+            if (Button({ bx + 172, by, 160, 48 }, "Delete", btnFont) && selectedRec >= 0) {
+                if (inbox.remove(selectedRec)) { infoMsg = "Request deleted"; inbox.maybeCompact(); }
             }
-            if (Button({ reqArea.x + 8, reqArea.y + reqArea.height - 72, 180, 48 }, "Clear All", btnFont)) { ClearRequests(); infoMsg = "Requests cleared"; }
-            if (Button({ reqArea.x + 200, reqArea.y + reqArea.height - 72, 180, 48 }, "Back", btnFont)) screen = SCR_ADMIN_PANEL;
-            if (!infoMsg.empty()) DrawText(infoMsg.c_str(), (int)(reqArea.x + 400), (int)(reqArea.y + reqArea.height - 64), smallFont, DARKGRAY);
+            if (Button({ bx + 344, by, 220, 48 }, showResolved ? "Hide resolved" : "Show resolved", btnFont)) {
+                showResolved = !showResolved;
+                requestList.reset();
+            }
+            if (Button({ bx + 576, by, 160, 48 }, "Clear All", btnFont)) { inbox.clear(); requestList.reset(); infoMsg = "Requests cleared"; }
+            if (Button({ bx + 748, by, 160, 48 }, "Back", btnFont)) screen = SCR_ADMIN_PANEL;
+            if (!infoMsg.empty()) DrawText(infoMsg.c_str(), (int)(bx + 928), (int)(by + 8), smallFont, DARKGRAY);
         }
 
         else if (screen == SCR_STUDENT_PANEL) {
-            if (loggedStudentIndex >= 0 && loggedStudentIndex < (int)db.size()) {
-                Student &s = db[loggedStudentIndex];
-                Rectangle studentInfo = { margin, topY + 110, leftW - margin*0.5f, 420 };
+            if (db.contains(loggedStudentRoll)) {
+                Student s = db.get(db.indexOf(loggedStudentRoll));
+                Rectangle studentInfo = { margin, topY + 110, leftW - margin*0.5f, 520 };
                 DrawRectangleLinesEx(studentInfo, 2, Fade(DARKGRAY, 0.4f));
                 DrawText(("Welcome, " + s.name).c_str(), (int)studentInfo.x + 12, (int)studentInfo.y + 8, 26, DARKBLUE);
                 DrawText(("Roll: " + std::to_string(s.roll)).c_str(), (int)studentInfo.x + 12, (int)studentInfo.y + 46, 20, BLACK);
                 float y = studentInfo.y + 86;
+                // Up to 16 subjects: two columns once one would overflow the box.
+                float colW = (studentInfo.width - 40) / (s.marks.size() > 8 ? 2 : 1);
                 for (size_t i = 0; i < s.marks.size(); ++i) {
-                    DrawText(("Subject " + std::to_string(i+1) + ": " + std::to_string(s.marks[i])).c_str(), (int)studentInfo.x + 20, (int)y, 20, BLACK);
-                    y += 36;
+                    string line = course.subjectName((int)i) + ": " + std::to_string(s.marks[i]) + " / " + std::to_string(course.maxMark((int)i));
+                    DrawText(line.c_str(), (int)(studentInfo.x + 20 + (i / 8) * colW), (int)(y + (i % 8) * 30), 20, BLACK);
+                }
+                y += std::min<size_t>(s.marks.size(), 8) * 30 + 6;
+                int slot = db.indexOf(s.roll);
+                DrawText(("Total: " + std::to_string((int)db.totalScore(slot))).c_str(), (int)studentInfo.x + 12, (int)y, 20, BLACK); y += 36;
+                if (course.weighted()) {
+                    double weighted = 0;
+                    for (size_t i = 0; i < s.marks.size(); ++i) weighted += course.weight((int)i) * s.marks[i];
+                    DrawText(TextFormat("Weighted: %.1f of %.1f", weighted, course.maxWeightedTotal()), (int)studentInfo.x + 12, (int)y, 20, BLACK); y += 36;
                 }
-                DrawText(("Total: " + std::to_string((int)s.totalScore())).c_str(), (int)studentInfo.x + 12, (int)y, 20, BLACK); y += 36;
+                DrawText(TextFormat("Average: %.2f", db.averageScore(slot)), (int)studentInfo.x + 12, (int)y, 20, BLACK); y += 36;
+                DrawText(TextFormat("Rank: %d of %d (percentile %.1f)", (int)db.rankOf(s.roll), (int)db.size(), db.percentileOf(db.totalScore(slot))), (int)studentInfo.x + 12, (int)y, 20, BLACK); y += 36;
 
                 DrawRectangleLinesEx(formArea, 2, Fade(DARKGRAY, 0.4f));
                 DrawText("Message", (int)tfRequestMsg.rect.x, (int)(tfRequestMsg.rect.y - labelFont - 6), labelFont, BLACK);
                 DrawTextField(tfRequestMsg, smallFont);
 
                 if (Button({ formArea.x + 28, formArea.y + 180, 180, 48 }, "Send Request", btnFont)) {
-                    SaveRequest(s.roll, tfRequestMsg.text);
-                    tfRequestMsg.text.clear();
-                    infoMsg = "Request sent";
+                    if (!inbox.append(s.roll, tfRequestMsg.text)) infoMsg = "Failed to send request";
+                    else { tfRequestMsg.text.clear(); infoMsg = "Request sent"; }
                 }
-                if (Button({ margin, screenH - 84, 180, 48 }, "Logout", btnFont)) { loggedStudentIndex = -1; screen = SCR_MAIN; infoMsg.clear(); }
+                if (Button({ margin, screenH - 84, 180, 48 }, "Logout", btnFont)) { loggedStudentRoll = -1; screen = SCR_MAIN; infoMsg.clear(); }
                 if (!infoMsg.empty()) DrawText(infoMsg.c_str(), (int)(formArea.x + 220), (int)(formArea.y + 184), smallFont, DARKGREEN);
             } else {
-                loggedStudentIndex = -1; screen = SCR_MAIN;
+                loggedStudentRoll = -1; screen = SCR_MAIN;
             }
         }
 
+        if (showProfile) DrawProfileOverlay(smallFont);
         EndDrawing();
+        profile_frame();
+
+        // A finished import is swapped in here, on the thread that owns the store.
+        ImportReport importReport;
+        bool importOk = false;
+        std::shared_ptr<const StudentSnapshot> imported;
+        if (importJob.finish(db, importReport, importOk, &history, &imported)) {
+            if (!importOk) {
+                infoMsg = "Cannot read " + tfCsvPath.text;
+            } else {
+                infoMsg = "Imported " + std::to_string(importReport.added) + " new, " + std::to_string(importReport.updated) +
+                          " updated, " + std::to_string(importReport.rejects.size()) + " rejected";
+                if (!importReport.rejects.empty()) {
+                    string reportPath = tfCsvPath.text + ".rejects.csv";
+                    if (write_reject_report(importReport, reportPath)) infoMsg += " (see " + reportPath + ")";
+                }
+                // The merge bypassed the journal, so write a snapshot as soon as possible.
+                journal.setSnapshot(std::move(imported));
+                snapshotDue = true;
+            }
+        }
+        bool exportOk = false;
+        size_t exported = 0;
+        if (exportJob.finish(exportOk, exported)) {
+            if (exportOk) infoMsg = "Exported " + std::to_string(exported) + " students to " + exportPath;
+            else infoMsg = "Failed to write " + exportPath;
+        }
+        ReportResult reportResult;
+        if (reportJob.finish(reportResult)) {
+            if (!reportResult.ok) infoMsg = "Report cards failed: " + reportResult.error;
+            else infoMsg = "Wrote " + std::to_string(reportResult.cards) + " report cards to " + REPORT_DIR;
+        }
+        if (history.takeWriteError()) infoMsg = "Failed to write the edit history";
+        if (journal.takeWriteError()) {
+            infoMsg = "Failed to save to disk; retrying with a full snapshot";
+            pendingSave = 0;
+        } else if (pendingSave && journal.completed() >= pendingSave) {
+            infoMsg = pendingSaveMsg;
+            pendingSave = 0;
+        }
+        if (snapshotDue) snapshotDue = !journal.maybeCompact(db, true);
+        else journal.maybeCompact(db);
     }
 
+    // Nothing saved may be lost on exit: drain the write queue, or write a full
+    // snapshot when the journal alone can't cover every edit.
+    if (snapshotDue || journal.snapshotNeeded()) journal.compactNow(db);
+    else journal.flush();
+
+    string why;
+    if (!profile_write(profileArgs, &why)) std::cerr << why << "\n";
     CloseWindow();
     return 0;
 }
@@ -0,0 +1,399 @@
+#include "student_auth.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using std::string;
+namespace fs = std::filesystem;
+
+// ---------- SHA-256 ----------
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32_t IV256[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static void sha256_compress(uint32_t h[8], const uint32_t block[16]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) w[i] = block[i];
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K256[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static inline uint32_t load_be(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline void store_be(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+// Streaming hash over byte pieces.
+struct Sha256 {
+    uint32_t h[8];
+    uint8_t buf[64];
+    size_t fill = 0;
+    uint64_t total = 0;
+
+    Sha256() { memcpy(h, IV256, sizeof h); }
+    void block(const uint8_t* p) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; ++i) w[i] = load_be(p + 4 * i);
+        sha256_compress(h, w);
+    }
+    void update(const void* data, size_t n) {
+        const uint8_t* p = (const uint8_t*)data;
+        total += n;
+        if (fill) {
+            size_t take = std::min(n, 64 - fill);
+            memcpy(buf + fill, p, take);
+            fill += take; p += take; n -= take;
+            if (fill < 64) return;
+            block(buf);
+            fill = 0;
+        }
+        for (; n >= 64; p += 64, n -= 64) block(p);
+        memcpy(buf, p, n);
+        fill = n;
+    }
+    void final(uint8_t out[32]) {
+        uint64_t bits = total * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        uint8_t zero = 0;
+        while (fill != 56) update(&zero, 1);
+        uint8_t len[8];
+        for (int i = 0; i < 8; ++i) len[i] = (uint8_t)(bits >> (56 - 8 * i));
+        update(len, 8);
+        for (int i = 0; i < 8; ++i) store_be(out + 4 * i, h[i]);
+    }
+};
+
+// ---------- PBKDF2-HMAC-SHA256 ----------
+// HMAC state after absorbing the padded key; reused for every round.
+struct HmacKey {
+    uint32_t inner[8], outer[8];
+
+    explicit HmacKey(std::string_view key) {
+        uint8_t k[64] = {0};
+        if (key.size() > 64) {
+            Sha256 s;
+            s.update(key.data(), key.size());
+            s.final(k);
+        } else {
+            memcpy(k, key.data(), key.size());
+        }
+        uint8_t pad[64];
+        Sha256 i, o;
+        for (int j = 0; j < 64; ++j) pad[j] = k[j] ^ 0x36;
+        i.block(pad);
+        for (int j = 0; j < 64; ++j) pad[j] = k[j] ^ 0x5c;
+        o.block(pad);
+        memcpy(inner, i.h, sizeof inner);
+        memcpy(outer, o.h, sizeof outer);
+    }
+
+    // MAC of a message made of up to three pieces.
+    void mac(std::string_view a, std::string_view b, std::string_view c, uint8_t out[32]) const {
+        Sha256 s;
+        memcpy(s.h, inner, sizeof inner);
+        s.total = 64;
+        s.update(a.data(), a.size());
+        s.update(b.data(), b.size());
+        s.update(c.data(), c.size());
+        uint8_t d[32];
+        s.final(d);
+        Sha256 t;
+        memcpy(t.h, outer, sizeof outer);
+        t.total = 64;
+        t.update(d, 32);
+        t.final(out);
+    }
+
+    // MAC of a 32-byte message in 32-bit words: exactly one compression per
+    // half, with the padding fixed. This is the loop PBKDF2 spends its time in.
+    void mac32(const uint32_t in[8], uint32_t out[8]) const {
+        uint32_t w[16] = {0};
+        for (int i = 0; i < 8; ++i) w[i] = in[i];
+        w[8] = 0x80000000u;
+        w[15] = (64 + 32) * 8;
+        uint32_t h[8];
+        memcpy(h, inner, sizeof h);
+        sha256_compress(h, w);
+        for (int i = 0; i < 8; ++i) w[i] = h[i];
+        memcpy(out, outer, sizeof h);
+        sha256_compress(out, w);
+    }
+};
+
+static void pbkdf2_sha256(std::string_view password, const uint8_t* salt, size_t saltLen, uint64_t rounds,
+                          uint8_t out[32]) {
+    HmacKey key(password);
+    static const char blockIndex[4] = {0, 0, 0, 1};
+    uint8_t first[32];
+    key.mac(std::string_view((const char*)salt, saltLen), std::string_view(blockIndex, 4), {}, first);
+    uint32_t u[8], acc[8];
+    for (int i = 0; i < 8; ++i) u[i] = acc[i] = load_be(first + 4 * i);
+    for (uint64_t r = 1; r < rounds; ++r) {
+        key.mac32(u, u);
+        for (int i = 0; i < 8; ++i) acc[i] ^= u[i];
+    }
+    for (int i = 0; i < 8; ++i) store_be(out + 4 * i, acc[i]);
+}
+
+// ---------- Password Hashes ----------
+static const char HASH_PREFIX[] = "$pbkdf2-sha256$";
+static const size_t SALT_BYTES = 16;
+
+static string to_hex(const uint8_t* p, size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    string s(n * 2, '0');
+    for (size_t i = 0; i < n; ++i) {
+        s[2 * i] = digits[p[i] >> 4];
+        s[2 * i + 1] = digits[p[i] & 15];
+    }
+    return s;
+}
+
+static bool from_hex(std::string_view s, uint8_t* out, size_t n) {
+    if (s.size() != n * 2) return false;
+    auto nibble = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        int hi = nibble(s[2 * i]), lo = nibble(s[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+static void random_bytes(uint8_t* out, size_t n) {
+    std::random_device rd;
+    for (size_t i = 0; i < n; i += 4) {
+        uint32_t v = rd();
+        for (size_t j = 0; j < 4 && i + j < n; ++j) out[i + j] = (uint8_t)(v >> (8 * j));
+    }
+}
+
+struct ParsedHash {
+    int cost;
+    uint8_t salt[SALT_BYTES];
+    uint8_t hash[32];
+};
+
+static bool parse_hash(std::string_view s, ParsedHash& p) {
+    if (s.substr(0, sizeof HASH_PREFIX - 1) != HASH_PREFIX) return false;
+    s.remove_prefix(sizeof HASH_PREFIX - 1);
+    size_t d1 = s.find('$');
+    if (d1 == 0 || d1 > 2) return false;
+    p.cost = 0;
+    for (char c : s.substr(0, d1)) {
+        if (c < '0' || c > '9') return false;
+        p.cost = p.cost * 10 + (c - '0');
+    }
+    // A hand-edited cost can't make a login take hours.
+    if (p.cost < AUTH_MIN_COST || p.cost > AUTH_MAX_COST) return false;
+    s.remove_prefix(d1 + 1);
+    size_t d2 = s.find('$');
+    if (d2 == std::string_view::npos) return false;
+    return from_hex(s.substr(0, d2), p.salt, SALT_BYTES) && from_hex(s.substr(d2 + 1), p.hash, 32);
+}
+
+string hash_password(std::string_view password, int cost) {
+    cost = std::max(AUTH_MIN_COST, std::min(AUTH_MAX_COST, cost));
+    uint8_t salt[SALT_BYTES], hash[32];
+    random_bytes(salt, SALT_BYTES);
+    pbkdf2_sha256(password, salt, SALT_BYTES, (uint64_t)1 << cost, hash);
+    return HASH_PREFIX + std::to_string(cost) + "$" + to_hex(salt, SALT_BYTES) + "$" + to_hex(hash, 32);
+}
+
+bool is_password_hash(std::string_view stored) {
+    ParsedHash p;
+    return parse_hash(stored, p);
+}
+
+int password_cost(std::string_view stored) {
+    ParsedHash p;
+    return parse_hash(stored, p) ? p.cost : -1;
+}
+
+bool constant_time_equal(std::string_view a, std::string_view b) {
+    // Length is not secret here: the hashes all have the same length, and
+    // plaintext is compared through its digest.
+    if (a.size() != b.size()) return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); ++i) diff |= (unsigned char)(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+bool verify_password(std::string_view stored, std::string_view password) {
+    ParsedHash p;
+    uint8_t got[32];
+    if (!parse_hash(stored, p)) {
+        // Plaintext: compare digests so the time doesn't depend on where they differ.
+        uint8_t want[32];
+        Sha256 a, b;
+        a.update(stored.data(), stored.size());
+        a.final(want);
+        b.update(password.data(), password.size());
+        b.final(got);
+        return constant_time_equal(std::string_view((char*)want, 32), std::string_view((char*)got, 32));
+    }
+    pbkdf2_sha256(password, p.salt, SALT_BYTES, (uint64_t)1 << p.cost, got);
+    return constant_time_equal(std::string_view((char*)p.hash, 32), std::string_view((char*)got, 32));
+}
+
+bool password_needs_rehash(std::string_view stored, int cost) {
+    return password_cost(stored) < cost;
+}
+
+// ---------- Admin Config ----------
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+bool load_admin_config(const string& path, AdminConfig& out) {
+    out = AdminConfig();
+    string password = "12345";
+    std::error_code ec;
+    if (fs::exists(path, ec)) {
+        std::ifstream f(path);
+        if (!f) return false;
+        string line;
+        while (std::getline(f, line)) {
+            size_t colon = line.find(':');
+            if (colon == string::npos) continue;
+            std::string_view k = trim(std::string_view(line).substr(0, colon));
+            std::string_view v = trim(std::string_view(line).substr(colon + 1));
+            if (k == "admin username") out.username = string(v);
+            else if (k == "admin password") password = string(v);
+            else if (k == "password cost") out.cost = std::max(AUTH_MIN_COST, std::min(AUTH_MAX_COST, atoi(string(v).c_str())));
+        }
+    }
+    if (is_password_hash(password)) {
+        out.credential = password;
+    } else {
+        out.credential = hash_password(password, out.cost);
+        out.upgraded = true;
+    }
+    return true;
+}
+
+bool save_admin_config(const string& path, const AdminConfig& cfg) {
+    string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        f << "admin username: " << cfg.username << "\n"
+          << "admin password: " << cfg.credential << "\n"
+          << "password cost: " << cfg.cost << "\n";
+        if (!f.flush()) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+bool verify_admin(const AdminConfig& cfg, std::string_view user, std::string_view password) {
+    if (cfg.credential.empty()) return false;
+    // Always hash, so a wrong username takes as long as a wrong password.
+    bool ok = verify_password(cfg.credential, password);
+    return constant_time_equal(user, cfg.username) && ok;
+}
+
+// ---------- Session Cache ----------
+static double mono_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+SessionCache::SessionCache(double ttlSec, size_t capacity)
+    : ttl(ttlSec), perShard(std::max<size_t>(1, capacity / SHARDS)) {
+    random_bytes(key, sizeof key);
+}
+
+void SessionCache::tagOf(int roll, std::string_view stored, std::string_view password, uint8_t out[32]) const {
+    // The roll and the credential's length go first so no two inputs run together.
+    char head[8];
+    uint32_t r = (uint32_t)roll, n = (uint32_t)stored.size();
+    memcpy(head, &r, 4);
+    memcpy(head + 4, &n, 4);
+    HmacKey k(std::string_view((const char*)key, sizeof key));
+    k.mac(std::string_view(head, 8), stored, password, out);
+}
+
+bool SessionCache::verify(int roll, std::string_view stored, std::string_view password) {
+    // Plaintext is as cheap to check as the cache itself.
+    if (!is_password_hash(stored)) return verify_password(stored, password);
+    uint8_t tag[32];
+    tagOf(roll, stored, password, tag);
+    std::string_view want((const char*)tag, 32);
+    double now = mono_sec();
+    Shard& s = shardOf(roll);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.entries.find(roll);
+        if (it != s.entries.end() && it->second.expires > now &&
+            constant_time_equal(std::string_view((const char*)it->second.tag, 32), want)) {
+            hitCount++;
+            return true;
+        }
+    }
+    missCount++;
+    if (!verify_password(stored, password)) return false;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.entries.size() >= perShard && !s.entries.count(roll)) {
+        for (auto it = s.entries.begin(); it != s.entries.end();) {
+            if (it->second.expires <= now) it = s.entries.erase(it);
+            else ++it;
+        }
+        if (s.entries.size() >= perShard) s.entries.erase(s.entries.begin());
+    }
+    Entry& e = s.entries[roll];
+    memcpy(e.tag, tag, 32);
+    e.expires = now + ttl;
+    return true;
+}
+
+void SessionCache::forget(int roll) {
+    Shard& s = shardOf(roll);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.entries.erase(roll);
+}
+
+void SessionCache::clear() {
+    for (Shard& s : shards) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.entries.clear();
+    }
+}
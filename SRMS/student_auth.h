@@ -0,0 +1,87 @@
+// Salted password hashes, admin.cfg and the verified-login cache (no raylib dependency)
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// ---------- Password Hashes ----------
+// A stored credential is "$pbkdf2-sha256$<cost>$<salt hex>$<hash hex>":
+// PBKDF2-HMAC-SHA256 with 2^cost rounds and a random 16-byte salt. Each step
+// of cost doubles the time one login takes. Anything else in a password field
+// is a plaintext password from before hashing; it still verifies, and is
+// replaced with a hash the next time it is saved.
+const int AUTH_DEFAULT_COST = 12;
+const int AUTH_MIN_COST = 4;
+const int AUTH_MAX_COST = 24;
+
+std::string hash_password(std::string_view password, int cost = AUTH_DEFAULT_COST);
+bool is_password_hash(std::string_view stored);
+// Cost of a stored hash, or -1 for plaintext.
+int password_cost(std::string_view stored);
+// Takes the same time whether the password is wrong early or late.
+bool verify_password(std::string_view stored, std::string_view password);
+// True for plaintext and for hashes cheaper than cost.
+bool password_needs_rehash(std::string_view stored, int cost = AUTH_DEFAULT_COST);
+bool constant_time_equal(std::string_view a, std::string_view b);
+
+// ---------- Admin Config ----------
+// admin.cfg:
+//   admin username: admin
+//   admin password: <hash, or plaintext until the first load>
+//   password cost: 12        (optional; cost of hashes written from now on)
+struct AdminConfig {
+    std::string username = "admin";
+    std::string credential;
+    int cost = AUTH_DEFAULT_COST;
+    bool upgraded = false;   // the file had a plaintext password; save it back
+};
+
+// A missing file gives admin / 12345, the login the GUI used to hard-code.
+// False only if the file exists and can't be read.
+bool load_admin_config(const std::string& path, AdminConfig& out);
+bool save_admin_config(const std::string& path, const AdminConfig& cfg);
+bool verify_admin(const AdminConfig& cfg, std::string_view user, std::string_view password);
+
+// ---------- Session Cache ----------
+// Remembers the logins that passed verify_password for ttlSec, so a client
+// that logs in again (or the server checking every request of a session)
+// pays one keyed SHA-256 instead of 2^cost rounds. An entry is a MAC of the
+// roll, the stored credential and the password under a key made at startup:
+// changing the password changes the stored credential and misses the cache,
+// and the cache never holds anything a password can be read back from.
+// Plaintext credentials skip the cache. Safe to share between threads.
+class SessionCache {
+public:
+    explicit SessionCache(double ttlSec = 600, size_t capacity = 1 << 16);
+
+    bool verify(int roll, std::string_view stored, std::string_view password);
+    void forget(int roll);
+    void clear();
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+private:
+    struct Entry {
+        uint8_t tag[32];
+        double expires;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<int, Entry> entries;
+    };
+    static const size_t SHARDS = 64;
+
+    void tagOf(int roll, std::string_view stored, std::string_view password, uint8_t out[32]) const;
+    Shard& shardOf(int roll) { return shards[(uint32_t)roll % SHARDS]; }
+
+    double ttl;
+    size_t perShard;
+    uint8_t key[32];
+    Shard shards[SHARDS];
+    std::atomic<size_t> hitCount{0}, missCount{0};
+};
@@ -0,0 +1,434 @@
+#include "student_bulk.h"
+#include "student_io.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+
+using std::string;
+using std::vector;
+
+static double now_sec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Calls fn(i) for i in [0, tasks) on `threads` threads (the caller is one of them).
+static void run_parallel(size_t tasks, unsigned threads, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next++) < tasks;) fn(i);
+    };
+    vector<std::thread> pool;
+    for (unsigned t = 1; t < threads && t < tasks; ++t) pool.emplace_back(work);
+    work();
+    for (auto& th : pool) th.join();
+}
+
+// ---------- Import ----------
+static const size_t CHUNK_BYTES = 1 << 20;
+
+struct ParsedChunk {
+    vector<Student> rows;
+    vector<size_t> lines;          // chunk-local, 0-based
+    vector<ImportReject> rejects;  // chunk-local lines
+    size_t lineCount = 0;          // every line, blank ones included
+    size_t dataLines = 0;
+};
+
+static bool strict_int(std::string_view v, int& out) {
+    if (v.empty()) return false;
+    auto r = std::from_chars(v.data(), v.data() + v.size(), out);
+    return r.ec == std::errc() && r.ptr == v.data() + v.size();
+}
+
+// Null if the row is good, else why it isn't.
+static const char* validate_row(std::string_view line, const ImportOptions& opt, Student& s) {
+    std::string_view f[4];
+    string owned[4];
+    if (!split_student_row(line, f, owned)) return "expected roll,name,password,marks";
+    if (!strict_int(f[0], s.roll)) return "roll is not a number";
+    if (s.roll < 0) return "negative roll";
+    if (f[1].empty()) return "empty name";
+    s.name.assign(f[1]);
+    s.password.assign(f[2]);
+    s.marks.clear();
+    std::string_view m = f[3];
+    while (!m.empty()) {
+        size_t semi = m.find(';');
+        int v;
+        if (!strict_int(m.substr(0, semi), v)) return "mark is not a number";
+        size_t j = s.marks.size();
+        if (!opt.subjectMax.empty() && j >= opt.subjectMax.size()) return "more marks than the course has subjects";
+        if (v < 0 || v > (opt.subjectMax.empty() ? opt.maxMark : opt.subjectMax[j])) return "mark out of range";
+        s.marks.push_back(v);
+        if (semi == std::string_view::npos) break;
+        m.remove_prefix(semi + 1);
+    }
+    if (s.marks.size() > UINT16_MAX) return "too many marks";
+    if ((int)s.marks.size() < opt.minSubjects) s.marks.resize(opt.minSubjects, 0);
+    return nullptr;
+}
+
+static void parse_chunk(const char* p, const char* end, bool skipHeader, const ImportOptions& opt, ParsedChunk& out) {
+    Student s;
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = nl ? nl : end;
+        std::string_view line(p, lineEnd - p);
+        p = nl ? nl + 1 : end;
+        size_t lineNo = out.lineCount++;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        if (skipHeader && lineNo == 0) continue;
+        out.dataLines++;
+        if (const char* why = validate_row(line, opt, s)) {
+            out.rejects.push_back(ImportReject{lineNo, why, string(line)});
+            continue;
+        }
+        out.rows.push_back(std::move(s));
+        out.lines.push_back(lineNo);
+        s = Student();
+    }
+}
+
+bool parse_import(const string& path, const ImportOptions& opt, ImportBatch& batch) {
+    batch = ImportBatch();
+    double t0 = now_sec();
+    MappedFile f;
+    if (!f.open(path)) return false;
+    const char* data = f.data();
+    size_t size = f.size();
+    // A header is any first line that starts with "roll," in any case.
+    bool header = size >= 5;
+    for (size_t i = 0; header && i < 5; ++i) header = tolower((unsigned char)data[i]) == "roll,"[i];
+
+    // Chunk boundaries sit just after a newline.
+    vector<size_t> cuts{0};
+    while (cuts.back() < size) {
+        size_t at = std::min(size, cuts.back() + CHUNK_BYTES);
+        if (at < size) {
+            const char* nl = (const char*)memchr(data + at, '\n', size - at);
+            at = nl ? (size_t)(nl - data) + 1 : size;
+        }
+        cuts.push_back(at);
+    }
+    size_t chunks = cuts.size() - 1;
+    vector<ParsedChunk> parsed(chunks);
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    run_parallel(chunks, threads, [&](size_t i) {
+        parse_chunk(data + cuts[i], data + cuts[i + 1], header && i == 0, opt, parsed[i]);
+    });
+
+    // Stitch chunks in file order, turning chunk-local lines into file lines
+    // and keeping the first row of every roll.
+    ImportReport& rep = batch.report;
+    size_t rows = 0;
+    for (auto& c : parsed) rows += c.rows.size();
+    batch.rows.reserve(rows);
+    batch.lines.reserve(rows);
+    RollIndex firstLine;
+    firstLine.reserve(rows);
+    size_t base = 1;
+    for (auto& c : parsed) {
+        rep.lines += c.dataLines;
+        for (auto& r : c.rejects) {
+            r.line += base;
+            rep.rejects.push_back(std::move(r));
+        }
+        for (size_t i = 0; i < c.rows.size(); ++i) {
+            size_t line = c.lines[i] + base;
+            uint32_t at = firstLine.insert(c.rows[i].roll, (uint32_t)line);
+            if (at != (uint32_t)line) {
+                rep.rejects.push_back(ImportReject{line, "duplicate roll (first on line " + std::to_string(at) + ")",
+                                                   format_student_row(c.rows[i])});
+                continue;
+            }
+            batch.rows.push_back(std::move(c.rows[i]));
+            batch.lines.push_back(line);
+        }
+        base += c.lineCount;
+        c = ParsedChunk();
+    }
+    std::sort(rep.rejects.begin(), rep.rejects.end(),
+              [](const ImportReject& a, const ImportReject& b) { return a.line < b.line; });
+    rep.parseSec = now_sec() - t0;
+    return true;
+}
+
+void merge_import(StudentStore& db, ImportBatch& batch, const ImportOptions& opt, EditHistory* history) {
+    double t0 = now_sec();
+    ImportReport& rep = batch.report;
+    if (db.empty()) {
+        rep.added += batch.rows.size();
+        if (history) history->applyAll(db, std::move(batch.rows));
+        else db.assign(std::move(batch.rows));
+    } else {
+        size_t firstReject = rep.rejects.size();
+        db.reserve(db.size() + batch.rows.size());
+        vector<Student> accepted;   // for the history, which applies them
+        for (size_t i = 0; i < batch.rows.size(); ++i) {
+            const Student& s = batch.rows[i];
+            if (!db.contains(s.roll)) {
+                if (history) accepted.push_back(std::move(batch.rows[i]));
+                else db.insert(s);
+                rep.added++;
+            } else if (opt.overwrite) {
+                if (history) accepted.push_back(std::move(batch.rows[i]));
+                else db.update(s);
+                rep.updated++;
+            } else {
+                rep.rejects.push_back(ImportReject{batch.lines[i], "roll already exists", format_student_row(s)});
+            }
+        }
+        std::inplace_merge(rep.rejects.begin(), rep.rejects.begin() + firstReject, rep.rejects.end(),
+                           [](const ImportReject& a, const ImportReject& b) { return a.line < b.line; });
+        if (history) history->applyAll(db, std::move(accepted));
+    }
+    batch.rows.clear();
+    batch.lines.clear();
+    rep.mergeSec = now_sec() - t0;
+}
+
+bool import_csv(StudentStore& db, const string& path, const ImportOptions& opt, ImportReport& report, EditHistory* history) {
+    ImportBatch batch;
+    if (!parse_import(path, opt, batch)) return false;
+    merge_import(db, batch, opt, history);
+    report = std::move(batch.report);
+    return true;
+}
+
+// ---------- Export ----------
+// Appends v, quoted the way format_student_row quotes it.
+static void append_field(string& out, std::string_view v) {
+    if (v.find_first_of(",\"") == std::string_view::npos) {
+        out += v;
+        return;
+    }
+    out += '"';
+    for (char c : v) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+static void append_int(string& out, long long v) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof buf, v);
+    out.append(buf, r.ptr - buf);
+}
+
+bool write_reject_report(const ImportReport& report, const string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    string buf = "line,reason,text\n";
+    bool ok = true;
+    for (auto& r : report.rejects) {
+        append_int(buf, (long long)r.line);
+        buf += ',';
+        append_field(buf, r.reason);
+        buf += ',';
+        append_field(buf, r.text);
+        buf += '\n';
+        if (buf.size() >= CHUNK_BYTES) {
+            ok = ok && fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+            buf.clear();
+        }
+    }
+    ok = ok && fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    return (fclose(f) == 0) && ok;
+}
+
+// One row in the students.csv layout; mark(j) gives mark j of count.
+template <class MarkAt>
+static void append_row(string& out, int roll, std::string_view name, std::string_view password, int count, MarkAt mark) {
+    append_int(out, roll);
+    out += ',';
+    append_field(out, name);
+    out += ',';
+    append_field(out, password);
+    out += ',';
+    for (int j = 0; j < count; ++j) {
+        if (j) out += ';';
+        append_int(out, mark(j));
+    }
+    out += '\n';
+}
+
+// Writes the header, then row(buf, k) for k in [0, n), spilling buf every ~1 MB.
+template <class RowAt>
+static bool write_rows(const string& path, size_t n, RowAt row) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    string buf;
+    buf.reserve(CHUNK_BYTES + 4096);
+    buf = "roll,name,password,marks\n";
+    bool ok = true;
+    for (size_t k = 0; ok && k < n; ++k) {
+        row(buf, k);
+        if (buf.size() >= CHUNK_BYTES) {
+            ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+            buf.clear();
+        }
+    }
+    ok = ok && fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    return (fclose(f) == 0) && ok;
+}
+
+bool export_csv(const StudentStore& db, const string& path, const vector<uint32_t>* slots) {
+    const MarksTable& marks = db.marks();
+    return write_rows(path, slots ? slots->size() : db.size(), [&](string& buf, size_t k) {
+        size_t i = slots ? (*slots)[k] : k;
+        const StudentInfo& info = db.info(i);
+        append_row(buf, info.roll, info.name, info.password, marks.count(i), [&](int j) { return marks.get(i, j); });
+    });
+}
+
+bool export_csv(const StudentSnapshot& snap, const string& path) {
+    vector<StudentSnapshot::Row> rows = snap.sorted();
+    return write_rows(path, rows.size(), [&](string& buf, size_t k) {
+        const StudentSnapshot::Row& r = rows[k];
+        append_row(buf, r.roll, r.name, r.password, r.count, [&](int j) { return r.marks[j]; });
+    });
+}
+
+// ---------- Background Import ----------
+// What history->applyAll() would record for merging batch into db: the
+// accepted rows past the cap, each with the row it replaces.
+static void record_import(const StudentStore& db, const ImportBatch& batch, const ImportOptions& opt, size_t limit,
+                          EditHistory::Batch& out) {
+    vector<uint32_t> accepted;
+    for (uint32_t i = 0; i < batch.rows.size(); ++i)
+        if (opt.overwrite || !db.contains(batch.rows[i].roll)) accepted.push_back(i);
+    out.skip = limit && accepted.size() > limit ? accepted.size() - limit : 0;
+    size_t n = accepted.size() - out.skip;
+    out.changes.resize(n);
+    out.bases.resize(n);
+    int64_t now = (int64_t)std::time(nullptr);
+    for (size_t k = 0; k < n; ++k) {
+        const Student& s = batch.rows[accepted[out.skip + k]];
+        EditHistory::Change& c = out.changes[k];
+        c.time = now;
+        c.roll = s.roll;
+        c.kind = EditHistory::EXTERNAL;
+        c.exists = true;
+        c.row = s;
+        EditHistory::Change& b = out.bases[k];
+        b.time = now;
+        b.roll = s.roll;
+        int slot = db.indexOf(s.roll);
+        b.exists = slot >= 0;
+        if (b.exists) b.row = db.get(slot);
+        else b.row.roll = s.roll;
+    }
+}
+
+ImportJob::~ImportJob() {
+    if (worker.joinable()) worker.join();
+    if (reaper.joinable()) reaper.join();
+}
+
+bool ImportJob::start(const string& path, const ImportOptions& opt, std::shared_ptr<const StudentSnapshot> snap,
+                      const EditHistory* history) {
+    if (worker.joinable()) return false;
+    if (reaper.joinable()) reaper.join();
+    options = opt;
+    since = history ? history->version() : 0;
+    bool record = history != nullptr;
+    size_t limit = history ? history->limit() : 0;
+    done = false;
+    worker = std::thread([this, path, snap, record, limit]() {
+        readOk = parse_import(path, options, batch);
+        if (readOk) merge(*snap, record, limit);
+        done = true;
+    });
+    return true;
+}
+
+void ImportJob::merge(const StudentSnapshot& before, bool record, size_t limit) {
+    merged = std::make_unique<StudentStore>();
+    vector<StudentSnapshot::Row> rows = before.sorted();
+    vector<Student> copy(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        copy[i].roll = rows[i].roll;
+        copy[i].name = rows[i].name;
+        copy[i].password = rows[i].password;
+        copy[i].marks.assign(rows[i].marks, rows[i].marks + rows[i].count);
+    }
+    rows = vector<StudentSnapshot::Row>();
+    merged->assign(std::move(copy));
+    if (record) record_import(*merged, batch, options, limit, changes);
+    merge_import(*merged, batch, options);
+    merged->warmRanking();
+    after = StudentSnapshot::build(*merged);
+    if (record) EditHistory::prepare(changes);
+}
+
+bool ImportJob::finish(StudentStore& db, ImportReport& report, bool& ok, EditHistory* history,
+                       std::shared_ptr<const StudentSnapshot>* snap) {
+    if (!worker.joinable() || !done) return false;
+    worker.join();
+    ok = readOk;
+    if (ok) {
+        // Rolls edited while the worker ran: their live row goes on top.
+        vector<int> keep;
+        if (history) keep = history->changedSince(since);
+        vector<StudentSnapshot::Edit> edits(keep.size());
+        for (size_t i = 0; i < keep.size(); ++i) {
+            int slot = db.indexOf(keep[i]);
+            edits[i].roll = keep[i];
+            edits[i].erase = slot < 0;
+            if (slot < 0) {
+                merged->erase(keep[i]);
+            } else {
+                edits[i].row = db.get(slot);
+                merged->upsert(edits[i].row);
+            }
+        }
+        if (history) history->commit(std::move(changes), keep);
+        db.swap(*merged);
+        if (snap) *snap = edits.empty() ? after : after->apply(edits);
+    }
+    report = std::move(batch.report);
+    // Freeing the replaced store's rows and trees, and the batch's buffers,
+    // takes tens of ms at 1M students: not on this thread.
+    reaper = std::thread([old = std::move(merged), rows = std::move(batch), spent = std::move(changes)]() mutable {
+        old.reset();
+        rows = ImportBatch();
+        spent = EditHistory::Batch();
+    });
+    batch = ImportBatch();
+    changes = EditHistory::Batch();
+    after.reset();
+    return true;
+}
+
+// ---------- Background Export ----------
+ExportJob::~ExportJob() {
+    if (worker.joinable()) worker.join();
+}
+
+bool ExportJob::start(std::shared_ptr<const StudentSnapshot> snap, const string& path) {
+    if (worker.joinable()) return false;
+    done = false;
+    worker = std::thread([this, snap, path]() {
+        written = export_csv(*snap, path);
+        count = snap->size();
+        done = true;
+    });
+    return true;
+}
+
+bool ExportJob::finish(bool& ok, size_t& rows) {
+    if (!worker.joinable() || !done) return false;
+    worker.join();
+    ok = written;
+    rows = count;
+    return true;
+}
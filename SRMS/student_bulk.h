@@ -0,0 +1,120 @@
+// Bulk CSV import and export (no raylib dependency)
+
+#pragma once
+#include "student_history.h"
+#include "student_snapshot.h"
+#include "student_store.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ImportOptions {
+    unsigned threads = 0;     // 0 = std::thread::hardware_concurrency()
+    bool overwrite = true;    // rolls already in the store are updated, else rejected
+    int minSubjects = 3;      // shorter mark lists are padded with zeros
+    int maxMark = 100;        // marks must lie in [0, maxMark]
+    // From the course, when there is one: mark j must lie in [0, subjectMax[j]]
+    // and a row may hold at most subjectMax.size() marks.
+    std::vector<int> subjectMax;
+};
+
+struct ImportReject {
+    size_t line;              // 1-based line in the imported file
+    std::string reason;
+    std::string text;
+};
+
+struct ImportReport {
+    size_t lines = 0;         // data lines read (header and blank lines excluded)
+    size_t added = 0;
+    size_t updated = 0;
+    std::vector<ImportReject> rejects;   // by line
+    double parseSec = 0;
+    double mergeSec = 0;
+};
+
+// Rows that passed validation, in file order, with no roll twice.
+struct ImportBatch {
+    std::vector<Student> rows;
+    std::vector<size_t> lines;   // source line of each row
+    ImportReport report;
+};
+
+// Parses and validates a CSV in the students.csv layout (header optional) on
+// a pool of threads, one ~1 MB chunk of lines at a time. Repeated rolls keep
+// their first row. Touches no store, so it can run off the UI thread. False
+// if the file can't be read.
+bool parse_import(const std::string& path, const ImportOptions& opt, ImportBatch& batch);
+// Merges a parsed batch in one pass: bulk-assigns into an empty store,
+// otherwise inserts or updates row by row. Fills added/updated and adds
+// rejects for existing rolls when overwrite is off. With a history, the rows
+// go on its timeline (EditHistory::applyAll) and undo/redo are dropped.
+void merge_import(StudentStore& db, ImportBatch& batch, const ImportOptions& opt, EditHistory* history = nullptr);
+// parse_import + merge_import.
+bool import_csv(StudentStore& db, const std::string& path, const ImportOptions& opt, ImportReport& report,
+                EditHistory* history = nullptr);
+// "line,reason,text" per reject.
+bool write_reject_report(const ImportReport& report, const std::string& path);
+
+// Writes the given slots (all when null) in the students.csv layout through a
+// fixed 1 MB buffer, so memory stays flat however large the store is.
+bool export_csv(const StudentStore& db, const std::string& path, const std::vector<uint32_t>* slots = nullptr);
+// Every row of snap, by roll. Reads nothing else, so it can run off the UI thread.
+bool export_csv(const StudentSnapshot& snap, const std::string& path);
+
+// Runs a whole import on a worker thread: parse_import, then merge_import
+// into a store rebuilt from a snapshot of the live one, the ranking, and a
+// snapshot of the result. The UI polls finish() each frame, which swaps the
+// merged store in and splices the history, so even a 1M-row merge never
+// holds up a frame.
+class ImportJob {
+public:
+    ~ImportJob();
+    bool running() const { return worker.joinable(); }
+    // snap is the store as it is now (StudentJournal::snapshot()). With a
+    // history, the job records the rows as history->applyAll() would and
+    // finish() must get the same history. False if an import is running.
+    bool start(const std::string& path, const ImportOptions& opt, std::shared_ptr<const StudentSnapshot> snap,
+               const EditHistory* history = nullptr);
+    // Once the worker is done: replaces db with the merged store, commits the
+    // import to the history, sets snap (if given) to db's new state, fills
+    // report and returns true. ok is false if the file couldn't be read, and
+    // then db is untouched. Rolls the history shows were edited after start()
+    // keep their edit; without a history such edits are lost, so the caller
+    // must hold them off.
+    bool finish(StudentStore& db, ImportReport& report, bool& ok, EditHistory* history = nullptr,
+                std::shared_ptr<const StudentSnapshot>* snap = nullptr);
+
+private:
+    void merge(const StudentSnapshot& before, bool record, size_t limit);
+
+    std::thread worker;
+    std::thread reaper;   // frees the replaced store
+    std::atomic<bool> done{false};
+    bool readOk = false;
+    ImportOptions options;
+    ImportBatch batch;
+    uint64_t since = 0;   // history version at start()
+    std::unique_ptr<StudentStore> merged;
+    std::shared_ptr<const StudentSnapshot> after;
+    EditHistory::Batch changes;
+};
+
+// export_csv(snapshot) on a worker thread; the store stays editable meanwhile.
+class ExportJob {
+public:
+    ~ExportJob();
+    bool running() const { return worker.joinable(); }
+    // False if an export is running.
+    bool start(std::shared_ptr<const StudentSnapshot> snap, const std::string& path);
+    // Once written: whether it worked and how many rows went out.
+    bool finish(bool& ok, size_t& rows);
+
+private:
+    std::thread worker;
+    std::atomic<bool> done{false};
+    bool written = false;
+    size_t count = 0;
+};
@@ -0,0 +1,443 @@
+#include "student_history.h"
+#include "student_io.h"
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+using std::string;
+using std::vector;
+
+// ---------- File ----------
+EditHistory::~EditHistory() {
+    close();
+}
+
+void EditHistory::close() {
+    if (out) fclose(out);
+    out = nullptr;
+}
+
+static const char* const KIND_NAMES[] = {"edit", "undo", "redo", "external"};
+
+const char* EditHistory::kindName(Kind k) {
+    return KIND_NAMES[k];
+}
+
+// "<time> <kind> U <csv row>" or "<time> <kind> D <roll>"; kind "base" gives base = true.
+static bool parse_line(std::string_view s, int64_t& time, int& kind, bool& exists, Student& row) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), time);
+    if (r.ec != std::errc() || r.ptr == s.data() + s.size() || *r.ptr != ' ') return false;
+    s.remove_prefix(r.ptr - s.data() + 1);
+    size_t sp = s.find(' ');
+    if (sp == std::string_view::npos) return false;
+    std::string_view word = s.substr(0, sp);
+    kind = -1;
+    for (int k = 0; k < 4; ++k)
+        if (word == KIND_NAMES[k]) kind = k;
+    if (kind < 0 && word != "base") return false;
+    s.remove_prefix(sp + 1);
+    if (s.size() < 3 || s[1] != ' ' || (s[0] != 'U' && s[0] != 'D')) return false;
+    exists = s[0] == 'U';
+    s.remove_prefix(2);
+    if (exists) return parse_student_row(s, row, 0);
+    row = Student();
+    r = std::from_chars(s.data(), s.data() + s.size(), row.roll);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+void EditHistory::load(const string& path) {
+    timeline.clear();
+    chains.clear();
+    undoStack.clear();
+    redoStack.clear();
+    dropped = 0;
+    skipped = 0;
+    std::ifstream f(path, std::ios::binary);
+    string line;
+    while (f && std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        int64_t time;
+        int kind;
+        bool exists;
+        Student row;
+        if (!parse_line(line, time, kind, exists, row)) {
+            skipped++;
+            continue;
+        }
+        Chain& ch = chains[row.roll];
+        if (kind < 0) {
+            // A base line only counts before the roll's first change.
+            if (ch.versions.empty()) {
+                ch.existed = exists;
+                ch.base = std::move(row);
+            }
+            continue;
+        }
+        Change c;
+        c.time = timeline.empty() ? time : std::max(time, timeline.back().time);
+        c.roll = row.roll;
+        c.kind = (Kind)kind;
+        c.exists = exists;
+        c.row = std::move(row);
+        timeline.push_back(std::move(c));
+        ch.versions.push_back((uint32_t)timeline.size());
+    }
+    // A base line whose change never made it (a torn write) says nothing.
+    for (auto it = chains.begin(); it != chains.end();) {
+        if (it->second.versions.empty()) it = chains.erase(it);
+        else ++it;
+    }
+}
+
+bool EditHistory::open(const string& path, string* why) {
+    close();
+    load(path);
+    filePath = path;
+    out = fopen(path.c_str(), "ab");
+    if (!out) {
+        if (why) *why = "cannot write " + path;
+        return false;
+    }
+    maybeTrim();
+    return true;
+}
+
+static void append_line(string& buf, int64_t time, const char* kind, bool exists, const Student& row) {
+    buf += std::to_string(time);
+    buf += ' ';
+    buf += kind;
+    if (exists) buf += " U " + format_student_row(row);
+    else buf += " D " + std::to_string(row.roll);
+    buf += '\n';
+}
+
+void EditHistory::append(const Change& c, const char* kind, bool flushNow) {
+    if (!out) return;
+    string line;
+    append_line(line, c.time, kind, c.exists, c.row);
+    if (fwrite(line.data(), 1, line.size(), out) != line.size()) writeError = true;
+    if (flushNow) flush();
+}
+
+void EditHistory::flush() {
+    if (out && fflush(out) != 0) writeError = true;
+}
+
+void EditHistory::setLimit(size_t changes) {
+    maxChanges = changes;
+    maybeTrim();
+}
+
+void EditHistory::trim(size_t keep) {
+    if (timeline.size() <= keep) return;
+    size_t cut = timeline.size() - keep;
+    for (size_t i = 0; i < cut; ++i) {
+        Change& c = timeline[i];
+        Chain& ch = chains[c.roll];
+        ch.existed = c.exists;
+        ch.base = std::move(c.row);
+        ch.base.roll = c.roll;
+    }
+    timeline.erase(timeline.begin(), timeline.begin() + cut);
+    dropped += cut;
+    for (auto it = chains.begin(); it != chains.end();) {
+        vector<uint32_t>& v = it->second.versions;
+        v.erase(v.begin(), std::upper_bound(v.begin(), v.end(), (uint32_t)dropped));
+        // Every write is on the timeline, so a roll with no change left
+        // holds its base row in the store.
+        if (v.empty()) it = chains.erase(it);
+        else ++it;
+    }
+    auto folded = [&](uint64_t v) { return v <= dropped; };
+    undoStack.erase(std::remove_if(undoStack.begin(), undoStack.end(), folded), undoStack.end());
+    redoStack.erase(std::remove_if(redoStack.begin(), redoStack.end(), folded), redoStack.end());
+    rewrite();
+}
+
+// The file to match memory: a base line per roll still on the timeline, then
+// the changes kept.
+void EditHistory::rewrite() {
+    if (!out) return;
+    fclose(out);
+    out = nullptr;
+    string tmp = filePath + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    bool ok = f != nullptr;
+    if (f) {
+        string buf;
+        auto spill = [&](size_t atLeast) {
+            if (buf.size() < atLeast) return;
+            if (fwrite(buf.data(), 1, buf.size(), f) != buf.size()) ok = false;
+            buf.clear();
+        };
+        int64_t t = timeline.empty() ? 0 : timeline.front().time;
+        for (const auto& kv : chains) {
+            append_line(buf, t, "base", kv.second.existed, kv.second.base);
+            spill(1 << 20);
+        }
+        for (const Change& c : timeline) {
+            append_line(buf, c.time, KIND_NAMES[c.kind], c.exists, c.row);
+            spill(1 << 20);
+        }
+        spill(1);
+        ok = fclose(f) == 0 && ok;
+    }
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, filePath, ec);
+    if (!ok || ec) writeError = true;
+    out = fopen(filePath.c_str(), "ab");
+    if (!out) writeError = true;
+}
+
+// ---------- Edits ----------
+const EditHistory::Change& EditHistory::record(StudentStore& db, int roll, Kind kind, const Student* row, bool toStore) {
+    Change c;
+    // The clock may step back; versionAt() needs times in order.
+    c.time = (int64_t)std::time(nullptr);
+    if (!timeline.empty()) c.time = std::max(c.time, timeline.back().time);
+    c.roll = roll;
+    c.kind = kind;
+    c.exists = row != nullptr;
+    if (row) c.row = *row;
+    else c.row.roll = roll;
+
+    auto ins = chains.try_emplace(roll);
+    Chain& ch = ins.first->second;
+    if (ins.second) {
+        int slot = db.indexOf(roll);
+        ch.existed = slot >= 0;
+        if (ch.existed) ch.base = db.get(slot);
+        else ch.base.roll = roll;
+        Change base;
+        base.time = c.time;
+        base.roll = roll;
+        base.exists = ch.existed;
+        base.row = ch.base;
+        append(base, "base", kind != EXTERNAL);
+    }
+    if (toStore) {
+        if (row) db.upsert(*row);
+        else db.erase(roll);
+    }
+    timeline.push_back(std::move(c));
+    ch.versions.push_back((uint32_t)version());
+    append(timeline.back(), KIND_NAMES[kind], kind != EXTERNAL);
+    return timeline.back();
+}
+
+void EditHistory::upsert(StudentStore& db, const Student& s) {
+    record(db, s.roll, EDIT, &s);
+    undoStack.push_back(version());
+    redoStack.clear();
+    maybeTrim();
+}
+
+bool EditHistory::erase(StudentStore& db, int roll) {
+    if (!db.contains(roll)) return false;
+    record(db, roll, EDIT, nullptr);
+    undoStack.push_back(version());
+    redoStack.clear();
+    maybeTrim();
+    return true;
+}
+
+const EditHistory::Change* EditHistory::undo(StudentStore& db) {
+    if (undoStack.empty()) return nullptr;
+    uint64_t v = undoStack.back();
+    undoStack.pop_back();
+    int roll = change(v).roll;
+    Student before;
+    bool existed = find(db, roll, v - 1, before);
+    record(db, roll, UNDO, existed ? &before : nullptr);
+    redoStack.push_back(v);
+    maybeTrim();
+    return &timeline.back();
+}
+
+const EditHistory::Change* EditHistory::redo(StudentStore& db) {
+    if (redoStack.empty()) return nullptr;
+    uint64_t v = redoStack.back();
+    redoStack.pop_back();
+    Change again = change(v);
+    record(db, again.roll, REDO, again.exists ? &again.row : nullptr);
+    undoStack.push_back(version());
+    maybeTrim();
+    return &timeline.back();
+}
+
+void EditHistory::dropUndo() {
+    undoStack.clear();
+    redoStack.clear();
+}
+
+void EditHistory::dropUndoOf(int roll) {
+    auto same = [&](uint64_t v) { return change(v).roll == roll; };
+    undoStack.erase(std::remove_if(undoStack.begin(), undoStack.end(), same), undoStack.end());
+    redoStack.erase(std::remove_if(redoStack.begin(), redoStack.end(), same), redoStack.end());
+}
+
+void EditHistory::apply(StudentStore& db, const Student& s, bool flushNow) {
+    dropUndoOf(s.roll);
+    record(db, s.roll, EXTERNAL, &s);
+    if (flushNow) flush();
+    maybeTrim();
+}
+
+bool EditHistory::applyErase(StudentStore& db, int roll, bool flushNow) {
+    if (!db.contains(roll)) return false;
+    dropUndoOf(roll);
+    record(db, roll, EXTERNAL, nullptr);
+    if (flushNow) flush();
+    maybeTrim();
+    return true;
+}
+
+void EditHistory::applyAll(StudentStore& db, vector<Student>&& rows) {
+    dropUndo();
+    // Past limit() rows, everything up to the last limit() of them would be
+    // folded straight away. So fold what is there now and apply the first
+    // rows without recording them: their rolls are distinct, so none has a
+    // later change that would need them as its base.
+    size_t skip = maxChanges && rows.size() > maxChanges ? rows.size() - maxChanges : 0;
+    if (skip) {
+        trim(0);
+        dropped += skip;
+    }
+    // Into an empty store every base is "not there" and the rows go in
+    // afterwards in one assign().
+    bool bulk = db.empty();
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i >= skip) record(db, rows[i].roll, EXTERNAL, &rows[i], !bulk);
+        else if (!bulk) db.upsert(rows[i]);
+    }
+    flush();
+    if (bulk) db.assign(std::move(rows));
+    maybeTrim();
+}
+
+void EditHistory::prepare(Batch& b) {
+    size_t n = b.changes.size();
+    b.lines.clear();
+    b.lineEnd.resize(n);
+    b.chains.clear();
+    b.chains.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Change& c = b.changes[i];
+        append_line(b.lines, c.time, "base", b.bases[i].exists, b.bases[i].row);
+        append_line(b.lines, c.time, KIND_NAMES[EXTERNAL], c.exists, c.row);
+        b.lineEnd[i] = b.lines.size();
+        Chain& ch = b.chains[c.roll];
+        ch.existed = b.bases[i].exists;
+        ch.base = std::move(b.bases[i].row);
+        ch.versions.assign(1, (uint32_t)i);
+    }
+    b.bases.clear();
+}
+
+void EditHistory::commit(Batch&& b, const vector<int>& keep) {
+    dropUndo();
+    if (b.skip) {
+        trim(0);
+        dropped += b.skip;
+    }
+    std::unordered_set<int> kept(keep.begin(), keep.end());
+    // The changes go on the timeline and their lines to the file, in runs
+    // that leave out the kept rolls. A base line for a roll that already has
+    // changes is ignored by load(), so the lines can go out as formatted.
+    vector<uint32_t> at(b.changes.size(), 0);   // version of each change; 0 if left out
+    timeline.reserve(timeline.size() + b.changes.size());
+    size_t run = 0;
+    auto writeRun = [&](size_t end) {
+        if (out && end > run && fwrite(b.lines.data() + run, 1, end - run, out) != end - run) writeError = true;
+    };
+    for (size_t i = 0; i < b.changes.size(); ++i) {
+        Change& c = b.changes[i];
+        if (kept.count(c.roll)) {
+            writeRun(i ? b.lineEnd[i - 1] : 0);
+            run = b.lineEnd[i];
+            continue;
+        }
+        if (!timeline.empty()) c.time = std::max(c.time, timeline.back().time);
+        timeline.push_back(std::move(c));
+        at[i] = (uint32_t)version();
+    }
+    writeRun(b.lines.size());
+    flush();
+    // New rolls' chains move over whole; the rest just gain a version.
+    chains.reserve(chains.size() + b.chains.size());
+    for (auto it = b.chains.begin(); it != b.chains.end();) {
+        uint32_t v = at[it->second.versions[0]];
+        auto old = v ? chains.find(it->first) : chains.end();
+        if (v && old == chains.end()) {
+            it->second.versions[0] = v;
+            ++it;
+            continue;
+        }
+        if (v) old->second.versions.push_back(v);
+        it = b.chains.erase(it);
+    }
+    chains.merge(b.chains);
+    maybeTrim();
+}
+
+// ---------- Reads ----------
+uint64_t EditHistory::versionAt(int64_t t) const {
+    auto it = std::upper_bound(timeline.begin(), timeline.end(), t,
+                               [](int64_t x, const Change& c) { return x < c.time; });
+    return dropped + (uint64_t)(it - timeline.begin());
+}
+
+bool EditHistory::find(const StudentStore& db, int roll, uint64_t v, Student& out) const {
+    auto it = chains.find(roll);
+    if (it == chains.end()) {
+        int slot = db.indexOf(roll);
+        if (slot < 0) return false;
+        out = db.get(slot);
+        return true;
+    }
+    const Chain& ch = it->second;
+    auto k = std::upper_bound(ch.versions.begin(), ch.versions.end(), v);
+    if (k == ch.versions.begin()) {
+        if (!ch.existed) return false;
+        out = ch.base;
+        return true;
+    }
+    const Change& c = change(*(k - 1));
+    if (!c.exists) return false;
+    out = c.row;
+    return true;
+}
+
+const vector<uint32_t>* EditHistory::versionsOf(int roll) const {
+    auto it = chains.find(roll);
+    return it == chains.end() || it->second.versions.empty() ? nullptr : &it->second.versions;
+}
+
+vector<int> EditHistory::changedSince(uint64_t v) const {
+    vector<int> rolls;
+    for (const auto& kv : chains)
+        if (!kv.second.versions.empty() && kv.second.versions.back() > v) rolls.push_back(kv.first);
+    std::sort(rolls.begin(), rolls.end());
+    return rolls;
+}
+
+static size_t heap_bytes(const string& s) {
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+static size_t heap_bytes(const Student& s) {
+    return heap_bytes(s.name) + heap_bytes(s.password) + s.marks.capacity() * sizeof(int);
+}
+
+size_t EditHistory::bytes() const {
+    size_t b = timeline.capacity() * sizeof(Change);
+    for (const Change& c : timeline) b += heap_bytes(c.row);
+    // Each map node holds the key, the chain and a next pointer.
+    b += chains.bucket_count() * sizeof(void*) + chains.size() * (sizeof(void*) + sizeof(std::pair<const int, Chain>));
+    for (const auto& kv : chains) b += heap_bytes(kv.second.base) + kv.second.versions.capacity() * sizeof(uint32_t);
+    b += (undoStack.capacity() + redoStack.capacity()) * sizeof(uint64_t);
+    return b;
+}
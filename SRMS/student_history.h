@@ -0,0 +1,167 @@
+// Edit history: undo/redo and as-of-time reads over per-roll version chains (no raylib dependency)
+
+#pragma once
+#include "student_store.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every edit made through the history becomes a Change on an append-only
+// timeline: the roll, its row afterwards (or that it was erased) and when.
+// Undo and redo are changes too, so the timeline always says what the store
+// held at any moment and as-of reads never depend on the undo stack.
+//
+// Versions share everything they don't change. Each roll keeps the versions
+// that touched it plus the row it had before the first one; a read at
+// version v takes the last of those at or before v (one binary search) and
+// falls back to the live store for rolls no change has touched. A version
+// therefore costs one row however large the store is. Publishing a
+// StudentSnapshot per version would cost about size() / 1024 rows each.
+//
+// Every write to the store has to come through here, admin edits through
+// upsert()/erase() and the rest (imports, the server, a login rehash) through
+// apply(), or as-of reads of the rolls it touched would be wrong.
+//
+// <csv>.history keeps the timeline across runs, one line per entry:
+//   <unix time> edit|undo|redo|external U <csv row>   the roll's row after a change
+//   <unix time> edit|undo|redo|external D <roll>      the roll was erased
+//   <unix time> base U <csv row> / D <roll>           the roll before its first change
+//
+// Only the latest limit() changes are kept. Once there are twice that many,
+// the older ones are folded into the rolls' base rows, rolls left with no
+// change drop out (the store holds their row), and the file is rewritten.
+// Reads at versions before firstVersion() see the state at firstVersion().
+class EditHistory {
+public:
+    enum Kind : uint8_t { EDIT, UNDO, REDO, EXTERNAL };
+    static const char* kindName(Kind k);
+    struct Change {
+        int64_t time = 0;      // unix seconds
+        int roll = 0;
+        Kind kind = EDIT;
+        bool exists = false;   // false: this change erased the roll
+        Student row;           // the row after this change, if exists
+    };
+
+    EditHistory() = default;
+    EditHistory(const EditHistory&) = delete;
+    EditHistory& operator=(const EditHistory&) = delete;
+    ~EditHistory();
+
+    // Replaces the history with the one in path; a missing file is empty.
+    // Lines that don't parse, such as a torn last line, are skipped. Read only.
+    void load(const std::string& path);
+    // load(), then appends every later change to path. Without open() the
+    // history lives in memory only.
+    bool open(const std::string& path, std::string* why = nullptr);
+    void close();
+
+    // The edit path: applies to db and records the change. A new edit drops
+    // the redo stack.
+    void upsert(StudentStore& db, const Student& s);
+    bool erase(StudentStore& db, int roll);
+    bool canUndo() const { return !undoStack.empty(); }
+    bool canRedo() const { return !redoStack.empty(); }
+    // Puts back the row from before the latest edit (or re-applies the latest
+    // undone one) and returns the change that made, for the caller to journal.
+    // Null if there is nothing to undo or redo.
+    const Change* undo(StudentStore& db);
+    const Change* redo(StudentStore& db);
+    // Forgets undo and redo. The timeline stays.
+    void dropUndo();
+
+    // Writes that are not the admin's to undo: applied and put on the
+    // timeline as EXTERNAL changes. Undo and redo entries for the same roll
+    // are dropped, since replaying them would overwrite this write. With
+    // flushNow false the file is only flushed by flush(), for bulk callers.
+    void apply(StudentStore& db, const Student& s, bool flushNow = true);
+    bool applyErase(StudentStore& db, int roll, bool flushNow = true);
+    // apply() for every row of an import (rolls distinct), without the cost
+    // of recording rows the cap would fold at once. Undo and redo are
+    // dropped. An empty store takes the rows in one bulk assign().
+    void applyAll(StudentStore& db, std::vector<Student>&& rows);
+    void flush();
+
+    // Per roll: its row before the first change kept, and the versions
+    // that touched it.
+    struct Chain {
+        bool existed = false;   // before the first change
+        Student base;
+        std::vector<uint32_t> versions;
+    };
+    // applyAll() in two halves, for an import merged into a copy of the
+    // store on a worker thread (ImportJob). The worker fills changes and
+    // bases, the rows past the first skip each with the row it replaced, and
+    // calls prepare(), which formats and allocates everything per row.
+    // commit() on the owning thread then only splices the result in.
+    struct Batch {
+        size_t skip = 0;                 // leading rows applied but not recorded
+        std::vector<Change> changes;     // EXTERNAL, rolls distinct
+        std::vector<Change> bases;       // per change, its roll before it
+        // Set by prepare():
+        std::string lines;               // a base and a change line per change
+        std::vector<size_t> lineEnd;     // where change i's lines end
+        std::unordered_map<int, Chain> chains;   // versions hold change indexes
+    };
+    static void prepare(Batch& b);
+    // Records b as applyAll() would have, except for changes to rolls in
+    // keep: those were edited since the batch was made and their edit stands.
+    // The store must already hold the batch's rows.
+    void commit(Batch&& b, const std::vector<int>& keep = {});
+
+    // Changes kept before older ones are folded away; 0 keeps all of them.
+    size_t limit() const { return maxChanges; }
+    void setLimit(size_t changes);
+
+    // Version v is the state after the first v changes; version() is live.
+    uint64_t version() const { return dropped + timeline.size(); }
+    // The oldest version reads can tell apart; changes up to it were folded.
+    uint64_t firstVersion() const { return dropped; }
+    // firstVersion() < v <= version()
+    const Change& change(uint64_t v) const { return timeline[v - dropped - 1]; }
+    // The version in effect at unix time t (firstVersion() before the first
+    // change kept).
+    uint64_t versionAt(int64_t t) const;
+    // roll's row at version v; false if it did not exist then. db must be the
+    // store this history records.
+    bool find(const StudentStore& db, int roll, uint64_t v, Student& out) const;
+    // Versions that touched roll, oldest first; null if none did.
+    const std::vector<uint32_t>* versionsOf(int roll) const;
+    // Every roll some change touched after version v.
+    std::vector<int> changedSince(uint64_t v) const;
+
+    size_t rollsTouched() const { return chains.size(); }
+    size_t skippedLines() const { return skipped; }
+    // Heap bytes held by the timeline and the chains.
+    size_t bytes() const;
+    // True once per failed append to the history file.
+    bool takeWriteError() {
+        bool e = writeError;
+        writeError = false;
+        return e;
+    }
+
+private:
+    const Change& record(StudentStore& db, int roll, Kind kind, const Student* row, bool toStore = true);
+    void append(const Change& c, const char* kind, bool flushNow = true);
+    void dropUndoOf(int roll);
+    // Folds all but the latest keep changes into the base rows and rewrites
+    // the file to match.
+    void trim(size_t keep);
+    void rewrite();
+    void maybeTrim() {
+        if (maxChanges && timeline.size() >= 2 * maxChanges) trim(maxChanges);
+    }
+
+    std::vector<Change> timeline;
+    uint64_t dropped = 0;          // changes folded away
+    size_t maxChanges = 100000;
+    std::string filePath;
+    std::unordered_map<int, Chain> chains;
+    std::vector<uint64_t> undoStack, redoStack;   // versions of the changes to revert / re-apply
+    FILE* out = nullptr;
+    size_t skipped = 0;
+    bool writeError = false;
+};
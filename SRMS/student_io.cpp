@@ -0,0 +1,703 @@
+#include "student_io.h"
+#include "crc32.h"
+#include "profiler.h"
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#define sys_open _open
+#define sys_write _write
+#define sys_close _close
+#define sys_fsync _commit
+#define O_APPEND_FLAGS (_O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY)
+#else
+#include <unistd.h>
+#define sys_open ::open
+#define sys_write ::write
+#define sys_close ::close
+#define sys_fsync ::fsync
+#define O_APPEND_FLAGS (O_WRONLY | O_APPEND | O_CREAT)
+#endif
+
+using std::string;
+using std::vector;
+namespace fs = std::filesystem;
+
+// ---------- CSV Helpers ----------
+string join_marks(const vector<int>& m) {
+    std::stringstream ss;
+    for (size_t i = 0; i < m.size(); ++i) {
+        if (i) ss << ';';
+        ss << m[i];
+    }
+    return ss.str();
+}
+
+// Same acceptance as std::stoi: leading whitespace, optional sign, then digits;
+// trailing junk is ignored. False on no digits or int overflow.
+static bool parse_int(std::string_view v, int& out) {
+    size_t i = 0;
+    while (i < v.size() && isspace((unsigned char)v[i])) i++;
+    if (i < v.size() && v[i] == '+') {
+        i++;
+        if (i < v.size() && v[i] == '-') return false;
+    }
+    auto r = std::from_chars(v.data() + i, v.data() + v.size(), out);
+    return r.ec == std::errc();
+}
+
+vector<int> parse_marks(std::string_view s) {
+    vector<int> out;
+    while (!s.empty()) {
+        size_t semi = s.find(';');
+        std::string_view cur = s.substr(0, semi);
+        int v;
+        if (!cur.empty() && parse_int(cur, v)) out.push_back(v);
+        if (semi == std::string_view::npos) break;
+        s.remove_prefix(semi + 1);
+    }
+    return out;
+}
+
+static string quote_field(const string& v) {
+    if (v.find(',') == string::npos && v.find('"') == string::npos) return v;
+    string tmp;
+    for (char c : v) tmp += (c == '"') ? "\"\"" : string(1,c);
+    return "\"" + tmp + "\"";
+}
+
+string format_student_row(const Student& s) {
+    return std::to_string(s.roll) + "," + quote_field(s.name) + "," + quote_field(s.password) + "," + join_marks(s.marks);
+}
+
+// Quoted rows keep the original character loop so RFC-4180 doubled quotes and
+// stray quotes behave exactly as before.
+static size_t split_quoted(std::string_view line, string* parts, size_t maxParts) {
+    size_t n = 0;
+    string cur;
+    bool inQuotes = false;
+    for (size_t i=0;i<line.size();i++) {
+        char c = line[i];
+        if (c == '"') {
+            if (inQuotes && i+1 < line.size() && line[i+1]=='"') { cur.push_back('"'); i++; }
+            else inQuotes = !inQuotes;
+        } else if (c==',' && !inQuotes) { if (n < maxParts) parts[n] = cur; n++; cur.clear(); }
+        else cur.push_back(c);
+    }
+    if (n < maxParts) parts[n] = cur;
+    return n + 1;
+}
+
+bool split_student_row(std::string_view line, std::string_view f[4], string owned[4]) {
+    if (memchr(line.data(), '"', line.size()) == nullptr) {
+        // Fast path: plain fields are views into the mapped file.
+        size_t n = 0, start = 0;
+        while (n < 4) {
+            const char* c = (const char*)memchr(line.data() + start, ',', line.size() - start);
+            size_t end = c ? (size_t)(c - line.data()) : line.size();
+            f[n++] = line.substr(start, end - start);
+            if (!c) break;
+            start = end + 1;
+        }
+        if (n < 4) return false;
+    } else {
+        if (split_quoted(line, owned, 4) < 4) return false;
+        for (int i = 0; i < 4; ++i) f[i] = owned[i];
+    }
+    return true;
+}
+
+bool parse_student_row(std::string_view line, Student& s, int minSubjects) {
+    std::string_view f[4];
+    string owned[4];
+    if (!split_student_row(line, f, owned)) return false;
+    if (!parse_int(f[0], s.roll)) return false;
+    s.name.assign(f[1]);
+    s.password.assign(f[2]);
+    s.marks = parse_marks(f[3]);
+    if ((int)s.marks.size() < minSubjects) s.marks.resize(minSubjects, 0);
+    return true;
+}
+
+size_t parse_students_csv(const char* data, size_t size, int minSubjects, vector<Student>& out) {
+    size_t before = out.size();
+    const char* p = data;
+    const char* end = data + size;
+    bool header = true;
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = nl ? nl : end;
+        std::string_view line(p, lineEnd - p);
+        p = nl ? nl + 1 : end;
+        if (header) { header = false; continue; }
+        if (line.empty()) continue;
+        Student s;
+        if (parse_student_row(line, s, minSubjects)) out.push_back(std::move(s));
+    }
+    return out.size() - before;
+}
+
+// ---------- Snapshot ----------
+static bool flush_and_sync(FILE* f) {
+    if (fflush(f) != 0) return false;
+    return sys_fsync(fileno(f)) == 0;
+}
+
+// A rename, or a file just created, survives a power cut only once the
+// directory holding it is fsynced too. Windows has no directory fsync; NTFS
+// journals the rename itself.
+static bool sync_parent_dir(const string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    fs::path dir = fs::path(path).parent_path();
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    // Some filesystems can't sync a directory and say EINVAL; they have
+    // nothing better to offer.
+    bool ok = ::fsync(fd) == 0 || errno == EINVAL;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+// Writes <path>.tmp through fill(FILE*), fsyncs it, renames it over path and
+// fsyncs the directory.
+template <class F>
+static bool write_atomically(const string& path, F fill) {
+    string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fill(f);
+    ok = flush_and_sync(f) && ok;
+    ok = (fclose(f) == 0) && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, path, ec);
+    if (!ok || ec) { fs::remove(tmp, ec); return false; }
+    return sync_parent_dir(path);
+}
+
+static bool write_csv(const vector<StudentInfo>& infos, const MarksTable& marks, const string& path) {
+    return write_atomically(path, [&](FILE* f) {
+        bool ok = fputs("roll,name,password,marks\n", f) >= 0;
+        Student s;
+        string row;
+        for (size_t i = 0; ok && i < infos.size(); ++i) {
+            s.roll = infos[i].roll;
+            s.name = infos[i].name;
+            s.password = infos[i].password;
+            marks.row(i, s.marks);
+            row = format_student_row(s);
+            row.push_back('\n');
+            ok = fwrite(row.data(), 1, row.size(), f) == row.size();
+        }
+        return ok;
+    });
+}
+
+bool save_to_file(const StudentStore& db, const string& path) {
+    PROFILE_SCOPE("save_to_file");
+    return write_csv(db.infos(), db.marks(), path);
+}
+
+bool load_from_file(StudentStore& db, const string& path, int minSubjects) {
+    PROFILE_SCOPE("load_from_file");
+    MappedFile f;
+    if (!f.open(path)) return false;
+    PROFILE_COUNT("csv bytes read", f.size());
+    vector<Student> rows;
+    // ~40 bytes per row is typical; a slight overestimate just wastes a little reserve.
+    rows.reserve(f.size() / 40 + 1);
+    parse_students_csv(f.data(), f.size(), minSubjects, rows);
+    f.close();
+    db.assign(std::move(rows));
+    replay_journal(db, path + ".journal.1", minSubjects);
+    replay_journal(db, path + ".journal", minSubjects);
+    return true;
+}
+
+// ---------- Binary Snapshot ----------
+struct BinHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t count;
+    uint32_t markStride;
+    uint32_t reserved;
+    uint64_t heapBytes;
+    uint8_t pad[24];
+};
+static_assert(sizeof(BinHeader) == 64, "students.bin header must stay 64 bytes");
+static const char BIN_MAGIC[8] = {'S','R','M','S','B','I','N','\0'};
+static const uint32_t BIN_BYTE_ORDER = 0x01020304;
+
+struct BinLayout { uint64_t roll, markCount, marks, strOff, heap, total; };
+
+static BinLayout bin_layout(uint64_t count, uint64_t stride, uint64_t heapBytes) {
+    auto align8 = [](uint64_t x) { return (x + 7) & ~uint64_t(7); };
+    BinLayout L;
+    L.roll = sizeof(BinHeader);
+    L.markCount = align8(L.roll + 4 * count);
+    L.marks = align8(L.markCount + 2 * count);
+    L.strOff = align8(L.marks + 4 * count * stride);
+    L.heap = align8(L.strOff + 4 * (2 * count + 1));
+    L.total = L.heap + heapBytes;
+    return L;
+}
+
+static bool write_binary(const vector<StudentInfo>& infos, const MarksTable& marks, const string& path) {
+    uint64_t n = infos.size();
+    vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return infos[a].roll < infos[b].roll; });
+    size_t stride = marks.subjects();
+    uint64_t heapBytes = 0;
+    for (auto& s : infos) heapBytes += s.name.size() + s.password.size();
+    if (heapBytes > UINT32_MAX || stride > UINT16_MAX) return false;
+
+    BinLayout L = bin_layout(n, stride, heapBytes);
+    vector<char> buf(L.heap);
+    BinHeader h{};
+    memcpy(h.magic, BIN_MAGIC, 8);
+    h.version = BIN_VERSION;
+    h.byteOrder = BIN_BYTE_ORDER;
+    h.count = n;
+    h.markStride = (uint32_t)stride;
+    h.heapBytes = heapBytes;
+    memcpy(buf.data(), &h, sizeof h);
+    int32_t* roll = (int32_t*)(buf.data() + L.roll);
+    uint16_t* markCount = (uint16_t*)(buf.data() + L.markCount);
+    int32_t* markCols = (int32_t*)(buf.data() + L.marks);
+    uint32_t* strOff = (uint32_t*)(buf.data() + L.strOff);
+    string heap;
+    heap.reserve(heapBytes);
+    for (uint64_t i = 0; i < n; ++i) {
+        uint32_t slot = order[i];
+        roll[i] = infos[slot].roll;
+        markCount[i] = (uint16_t)marks.count(slot);
+        strOff[2 * i] = (uint32_t)heap.size();
+        heap += infos[slot].name;
+        strOff[2 * i + 1] = (uint32_t)heap.size();
+        heap += infos[slot].password;
+    }
+    strOff[2 * n] = (uint32_t)heap.size();
+    for (size_t j = 0; j < stride; ++j) {
+        int32_t* dst = markCols + j * n;
+        marks.visitColumn((int)j, [&](const auto* src) {
+            for (uint64_t i = 0; i < n; ++i) dst[i] = src[order[i]];
+        });
+    }
+
+    return write_atomically(path, [&](FILE* f) {
+        bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+        return ok && fwrite(heap.data(), 1, heap.size(), f) == heap.size();
+    });
+}
+
+bool save_binary(const StudentStore& db, const string& path) {
+    return write_binary(db.infos(), db.marks(), path);
+}
+
+bool load_binary(StudentStore& db, const string& path, int minSubjects) {
+    MappedFile f;
+    if (!f.open(path) || f.size() < sizeof(BinHeader)) return false;
+    BinHeader h;
+    memcpy(&h, f.data(), sizeof h);
+    if (memcmp(h.magic, BIN_MAGIC, 8) != 0 || h.version != BIN_VERSION || h.byteOrder != BIN_BYTE_ORDER) return false;
+    // Reject counts whose column sizes could not fit in the file before computing offsets.
+    if (h.count > f.size() / 4 || h.markStride > UINT16_MAX || h.heapBytes > f.size()) return false;
+    BinLayout L = bin_layout(h.count, h.markStride, h.heapBytes);
+    if (L.total != f.size()) return false;
+
+    const char* base = f.data();
+    const int32_t* roll = (const int32_t*)(base + L.roll);
+    const uint16_t* markCount = (const uint16_t*)(base + L.markCount);
+    const int32_t* markCols = (const int32_t*)(base + L.marks);
+    const uint32_t* strOff = (const uint32_t*)(base + L.strOff);
+    const char* heap = base + L.heap;
+    if (strOff[2 * h.count] != h.heapBytes) return false;
+
+    size_t n = (size_t)h.count, stride = h.markStride;
+    vector<StudentInfo> infos;
+    infos.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t a = strOff[2 * i], b = strOff[2 * i + 1], c = strOff[2 * i + 2];
+        if (a > b || b > c || c > h.heapBytes || markCount[i] > stride) return false;
+        infos.push_back(StudentInfo{roll[i], string(heap + a, b - a), string(heap + b, c - b)});
+    }
+    // Mark columns are int32 on disk; MarksTable narrows each to the width its
+    // values need.
+    MarksTable marks;
+    marks.resizeRows(n);
+    marks.ensureSubjects(std::max<int>((int)stride, minSubjects));
+    for (size_t j = 0; j < stride; ++j) marks.loadColumn((int)j, markCols + j * n);
+    uint16_t* cnt = marks.countData();
+    for (size_t i = 0; i < n; ++i) cnt[i] = std::max<uint16_t>(markCount[i], (uint16_t)minSubjects);
+    return db.assign(std::move(infos), std::move(marks));
+}
+
+bool load_database(StudentStore& db, const string& csvPath, const string& binPath, int minSubjects) {
+    std::error_code e1, e2;
+    auto binTime = fs::last_write_time(binPath, e1);
+    auto csvTime = fs::last_write_time(csvPath, e2);
+    bool useBin = !e1 && (e2 || binTime >= csvTime);
+    if (useBin && load_binary(db, binPath, minSubjects)) {
+        replay_journal(db, csvPath + ".journal.1", minSubjects);
+        replay_journal(db, csvPath + ".journal", minSubjects);
+        return true;
+    }
+    return load_from_file(db, csvPath, minSubjects);
+}
+
+// ---------- Journal ----------
+static const uint32_t MAX_RECORD = 1u << 20;
+
+// Calls apply(kind, payload) for each intact record and returns the size of
+// the intact prefix.
+template <class F>
+static size_t scan_journal(const char* buf, size_t size, F&& apply) {
+    size_t pos = 0;
+    while (pos + 8 <= size) {
+        uint32_t len, crc;
+        memcpy(&len, buf + pos, 4);
+        memcpy(&crc, buf + pos + 4, 4);
+        if (len == 0 || len > MAX_RECORD || pos + 8 + len > size) break;
+        const char* p = buf + pos + 8;
+        if (crc32(p, len) != crc) break;
+        apply(p[0], std::string_view(p + 1, len - 1));
+        pos += 8 + len;
+    }
+    return pos;
+}
+
+static void cut_torn_tail(const string& logPath, size_t good, size_t size) {
+    if (good < size) {
+        std::error_code ec;
+        fs::resize_file(logPath, good, ec);
+    }
+}
+
+size_t replay_journal(StudentStore& db, const string& logPath, int minSubjects, bool truncate) {
+    MappedFile f;
+    if (!f.open(logPath)) return 0;
+    size_t applied = 0;
+    size_t good = scan_journal(f.data(), f.size(), [&](char kind, std::string_view payload) {
+        if (kind == 'U') {
+            Student s;
+            if (parse_student_row(payload, s, minSubjects)) db.upsert(s);
+        } else if (kind == 'D') {
+            int roll;
+            if (parse_int(payload, roll)) db.erase(roll);
+        }
+        applied++;
+    });
+    size_t size = f.size();
+    f.close();
+    if (truncate) cut_torn_tail(logPath, good, size);
+    return applied;
+}
+
+StudentJournal::StudentJournal(const string& csv)
+    : csvPath(csv), logPath(csv + ".journal"), oldPath(csv + ".journal.1"),
+      lastCompact(std::chrono::steady_clock::now()) {}
+
+StudentJournal::~StudentJournal() {
+    stopWriter();
+    waitCompaction();
+    close();
+}
+
+bool StudentJournal::open(const StudentStore& db, const string& bin) {
+    close();
+    binPath = bin;
+    std::error_code ec;
+    if (fs::exists(oldPath, ec) && !compactNow(db)) return false;
+    {
+        // Readers stop at a torn tail; the writer cuts it so its appends
+        // stay reachable on replay.
+        MappedFile f;
+        if (f.open(logPath)) {
+            size_t good = scan_journal(f.data(), f.size(), [](char, std::string_view) {});
+            size_t size = f.size();
+            f.close();
+            cut_torn_tail(logPath, good, size);
+        }
+    }
+    std::lock_guard<std::mutex> lk(fdMutex);
+    fd = sys_open(logPath.c_str(), O_APPEND_FLAGS, 0644);
+    if (fd < 0) return false;
+    bytes = (size_t)fs::file_size(logPath, ec);
+    // The journal may have just been created.
+    return sync_parent_dir(logPath);
+}
+
+void StudentJournal::close() {
+    flush();
+    std::lock_guard<std::mutex> lk(fdMutex);
+    if (fd >= 0) sys_close(fd);
+    fd = -1;
+}
+
+static void encode_record(string& out, const string& payload) {
+    uint32_t len = (uint32_t)payload.size();
+    uint32_t crc = crc32(payload.data(), payload.size());
+    size_t at = out.size();
+    out.resize(at + 8 + payload.size());
+    memcpy(&out[at], &len, 4);
+    memcpy(&out[at + 4], &crc, 4);
+    memcpy(&out[at + 8], payload.data(), payload.size());
+}
+
+// Caller holds fdMutex.
+bool StudentJournal::writeRecords(const string& recs) {
+    if (fd < 0) return false;
+    // One write() per batch keeps it contiguous in the O_APPEND file.
+    if (sys_write(fd, recs.data(), (unsigned)recs.size()) != (int)recs.size() || sys_fsync(fd) != 0) {
+        // Drop a partial batch so later appends stay reachable on replay.
+        std::error_code ec;
+        fs::resize_file(logPath, bytes, ec);
+        return false;
+    }
+    bytes += recs.size();
+    return true;
+}
+
+bool StudentJournal::appendRecord(int roll, string&& payload) {
+    if (!writer.joinable()) {
+        string rec;
+        encode_record(rec, payload);
+        std::lock_guard<std::mutex> lk(fdMutex);
+        return writeRecords(rec);
+    }
+    {
+        std::unique_lock<std::mutex> lk(queueMutex);
+        queueSpace.wait(lk, [&] { return pending.size() < maxPending; });
+        pending.push_back(Pending{roll, std::move(payload)});
+        queuedSeq++;
+    }
+    queueReady.notify_one();
+    return true;
+}
+
+bool StudentJournal::logUpsert(const Student& s) {
+    if (snap) {
+        vector<StudentSnapshot::Edit> e(1);
+        e[0].roll = s.roll;
+        e[0].row = s;
+        snap = snap->apply(e);
+    }
+    return appendRecord(s.roll, "U" + format_student_row(s));
+}
+
+bool StudentJournal::logErase(int roll) {
+    if (snap) {
+        vector<StudentSnapshot::Edit> e(1);
+        e[0].erase = true;
+        e[0].roll = roll;
+        snap = snap->apply(e);
+    }
+    return appendRecord(roll, "D" + std::to_string(roll));
+}
+
+void StudentJournal::trackSnapshot(const StudentStore& db) {
+    snap = StudentSnapshot::build(db);
+}
+
+// ---------- Background Writes ----------
+bool StudentJournal::startWriter() {
+    if (writer.joinable()) return true;
+    stopping = false;
+    writer = std::thread([this] { writerLoop(); });
+    return true;
+}
+
+void StudentJournal::writerLoop() {
+    vector<Pending> batch;
+    vector<char> keep;
+    std::unordered_set<int> seen;
+    string recs;
+    for (;;) {
+        uint64_t upTo;
+        {
+            std::unique_lock<std::mutex> lk(queueMutex);
+            queueReady.wait(lk, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;   // stopping, and nothing left
+            batch.swap(pending);
+            upTo = queuedSeq;
+            writing = true;
+        }
+        queueSpace.notify_all();
+
+        // Records replay in order and each one replaces the whole row, so
+        // only the last record of a roll in the batch matters.
+        keep.assign(batch.size(), 0);
+        seen.clear();
+        for (size_t i = batch.size(); i-- > 0;) keep[i] = seen.insert(batch[i].roll).second;
+        recs.clear();
+        for (size_t i = 0; i < batch.size(); ++i)
+            if (keep[i]) encode_record(recs, batch[i].payload);
+        coalesced += batch.size() - seen.size();
+        batch.clear();
+
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lk(fdMutex);
+            ok = writeRecords(recs);
+        }
+        if (ok) {
+            batches++;
+        } else {
+            needSnapshot = true;
+            writeError = true;
+        }
+        {
+            std::lock_guard<std::mutex> lk(queueMutex);
+            writing = false;
+            completedSeq = upTo;
+        }
+        queueDone.notify_all();
+    }
+}
+
+bool StudentJournal::flush() {
+    if (writer.joinable()) {
+        std::unique_lock<std::mutex> lk(queueMutex);
+        queueDone.wait(lk, [&] { return pending.empty() && !writing; });
+    }
+    return !writeError;
+}
+
+void StudentJournal::stopWriter() {
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_one();
+    writer.join();
+}
+
+// Records still queued land in the new journal. The snapshot already has
+// their edits, and replaying them over it again is harmless.
+bool StudentJournal::rotate() {
+    std::lock_guard<std::mutex> lk(fdMutex);
+    if (fd >= 0) sys_close(fd);
+    std::error_code ec;
+    fs::rename(logPath, oldPath, ec);
+    if (ec && fs::exists(logPath)) {
+        fd = sys_open(logPath.c_str(), O_APPEND_FLAGS, 0644);
+        return false;
+    }
+    fd = sys_open(logPath.c_str(), O_APPEND_FLAGS, 0644);
+    bytes = 0;
+    lastCompact = std::chrono::steady_clock::now();
+    // Both the rename and the new journal must be on disk before an edit is
+    // acknowledged from it, or a power cut could bring back the old journal
+    // without the new one.
+    return fd >= 0 && sync_parent_dir(logPath);
+}
+
+void StudentJournal::waitCompaction() {
+    if (worker.joinable()) worker.join();
+}
+
+// The rows of snap as the writers above take them, in roll order.
+static void snapshot_columns(const StudentSnapshot& snap, vector<StudentInfo>& infos, MarksTable& marks) {
+    vector<StudentSnapshot::Row> rows = snap.sorted();
+    size_t n = rows.size();
+    infos.resize(n);
+    int width = 0;
+    for (size_t i = 0; i < n; ++i) {
+        infos[i] = StudentInfo{rows[i].roll, string(rows[i].name), string(rows[i].password)};
+        width = std::max(width, rows[i].count);
+    }
+    marks.clear();
+    marks.resizeRows(n);
+    marks.ensureSubjects(width);
+    vector<int32_t> col(n);
+    for (int j = 0; j < width; ++j) {
+        for (size_t i = 0; i < n; ++i) col[i] = j < rows[i].count ? rows[i].marks[j] : 0;
+        marks.loadColumn(j, col.data());
+    }
+    uint16_t* counts = marks.countData();
+    for (size_t i = 0; i < n; ++i) counts[i] = (uint16_t)rows[i].count;
+    marks.recomputeTotals();
+}
+
+bool StudentJournal::maybeCompact(const StudentStore& db, bool force) {
+    auto now = std::chrono::steady_clock::now();
+    // A lost batch forces a snapshot, retried at most once a second while the disk keeps failing.
+    if (needSnapshot && now - lastAttempt >= std::chrono::seconds(1)) force = true;
+    if (busy || (bytes == 0 && !force)) return false;
+    bool big = bytes >= maxBytes;
+    bool old = now - lastCompact >= maxAge;
+    if (!big && !old && !force) return false;
+    lastAttempt = now;
+    waitCompaction();
+    std::error_code ec;
+    // A previous worker failed and left .journal.1 unfolded, which rotating
+    // would clobber. The snapshot holds the edits of both journals, so write
+    // it without rotating; the live journal still replays on top of it.
+    bool rotating = !fs::exists(oldPath, ec);
+    // Cleared before the state is taken below: a batch that fails from here
+    // on either holds edits that state has, or sets it again.
+    needSnapshot = false;
+    if (rotating && !rotate()) { compactFailed = needSnapshot = true; return false; }
+    busy = true;
+    // With a tracked snapshot the worker makes the columns itself; otherwise
+    // db has to be copied here, before the caller edits it again.
+    std::shared_ptr<const StudentSnapshot> from = snap;
+    vector<StudentInfo> infos;
+    MarksTable marks;
+    if (!from) {
+        infos = db.infos();
+        marks = db.marks();
+    }
+    worker = std::thread([this, from, infos = std::move(infos), marks = std::move(marks)]() mutable {
+        if (from) snapshot_columns(*from, infos, marks);
+        bool ok = write_csv(infos, marks, csvPath);
+        // Written after the CSV so load_database() sees it as the newer snapshot.
+        if (ok && !binPath.empty()) ok = write_binary(infos, marks, binPath);
+        std::error_code ec;
+        if (ok) fs::remove(oldPath, ec);
+        else needSnapshot = true;
+        compactFailed = !ok;
+        busy = false;
+    });
+    return true;
+}
+
+bool StudentJournal::compactNow(const StudentStore& db) {
+    waitCompaction();
+    flush();
+    std::lock_guard<std::mutex> lk(fdMutex);
+    bool reopen = fd >= 0;
+    if (reopen) sys_close(fd);
+    fd = -1;
+    bool ok = save_to_file(db, csvPath);
+    if (ok && !binPath.empty()) ok = save_binary(db, binPath);
+    std::error_code ec;
+    if (ok) {
+        fs::remove(oldPath, ec);
+        fs::resize_file(logPath, 0, ec);
+        bytes = 0;
+        lastCompact = std::chrono::steady_clock::now();
+    }
+    if (reopen) {
+        fd = sys_open(logPath.c_str(), O_APPEND_FLAGS, 0644);
+        sync_parent_dir(logPath);
+    }
+    compactFailed = !ok;
+    needSnapshot = !ok;
+    return ok;
+}
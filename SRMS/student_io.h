@@ -0,0 +1,169 @@
+// students.csv persistence + write-ahead journal (no raylib dependency)
+
+#pragma once
+#include "mapped_file.h"
+#include "student_snapshot.h"
+#include "student_store.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// ---------- CSV Helpers ----------
+std::string join_marks(const std::vector<int>& m);
+std::vector<int> parse_marks(std::string_view s);
+// One data row (no newline) in the students.csv layout; quotes fields as needed.
+std::string format_student_row(const Student& s);
+// Splits one data row into its roll, name, password and marks fields. Plain
+// fields are views into line; quoted ones are unescaped into owned. False if
+// there are fewer than four fields.
+bool split_student_row(std::string_view line, std::string_view f[4], std::string owned[4]);
+// Parses one data row. Returns false for rows load_from_file would skip.
+bool parse_student_row(std::string_view line, Student& out, int minSubjects);
+// Parses a whole students.csv image (header line included) and appends the rows.
+size_t parse_students_csv(const char* data, size_t size, int minSubjects, std::vector<Student>& out);
+
+// Snapshot only. Writes to <path>.tmp, fsyncs and renames it, then fsyncs the
+// directory, so neither a crash nor a power cut leaves a half or stale file.
+bool save_to_file(const StudentStore& db, const std::string& path);
+// Snapshot plus any journal left next to it. False if the snapshot is missing.
+bool load_from_file(StudentStore& db, const std::string& path, int minSubjects);
+
+// ---------- Binary Snapshot ----------
+// students.bin: 64-byte header, then 8-byte aligned columns
+//   int32  roll[count]
+//   uint16 markCount[count]
+//   int32  marks[markStride][count]         (one column per subject, zero padded)
+//   uint32 strOff[2 * count + 1]            (name i = heap[off[2i], off[2i+1]),
+//   char   heap[heapBytes]                   password i = heap[off[2i+1], off[2i+2]))
+// Rows are sorted by roll. Little-endian only; the header records a byte-order tag.
+const uint32_t BIN_VERSION = 2;
+bool save_binary(const StudentStore& db, const std::string& path);
+// Snapshot only; no journal replay. False on a missing, truncated or foreign file.
+bool load_binary(StudentStore& db, const std::string& path, int minSubjects);
+// Loads <binPath> when it exists and is newer than <csvPath>, otherwise the CSV,
+// then replays the CSV's journal either way.
+bool load_database(StudentStore& db, const std::string& csvPath, const std::string& binPath, int minSubjects);
+
+// ---------- Journal ----------
+// Each edit is appended to <csv>.journal as [u32 len][u32 crc32][payload] and
+// fsynced. Payload is "U<csv row>" for add/edit and "D<roll>" for delete.
+// Replay stops at the first torn or corrupt record, so a crash mid-append
+// loses at most the edit that was being written.
+//
+// Compaction rotates the live journal to <csv>.journal.1, then a worker thread
+// writes a fresh snapshot and removes .journal.1. The worker builds the rows
+// from the tracked StudentSnapshot (trackSnapshot()) when there is one, else
+// from a copy of the store the caller has to make first.
+// Replaying is idempotent, so a crash at any point of that sequence is safe.
+// Every rename and newly created journal is followed by an fsync of the
+// directory, so a power cut can't undo one and bring back an older file.
+//
+// By default every log call writes and fsyncs before returning. After
+// startWriter() the calls only queue the record: a writer thread drains the
+// queue, keeps the last record of each roll in the batch, and writes the
+// batch with one write() and one fsync (group commit). The queue is bounded,
+// so a producer that outruns the disk waits instead of growing it without
+// limit. A failed batch is dropped and the next maybeCompact() writes a full
+// snapshot instead, which covers those edits because the store has them.
+class StudentJournal {
+public:
+    explicit StudentJournal(const std::string& csvPath);
+    ~StudentJournal();   // flushes queued records
+
+    // Call after load_from_file(). Folds a leftover .journal.1 into the snapshot.
+    // With a binary path set, compaction refreshes that snapshot as well.
+    bool open(const StudentStore& db, const std::string& binPath = "");
+    void close();
+
+    bool logUpsert(const Student& s);
+    bool logErase(int roll);
+
+    // ---------- Snapshot ----------
+    // After trackSnapshot(), each log call also applies its edit to an
+    // immutable StudentSnapshot (about size() / 1024 rows copied per edit),
+    // so snapshot() always matches what was logged and worker threads can
+    // read it without a copy of the store made on this thread. Call these
+    // from the thread that logs.
+    void trackSnapshot(const StudentStore& db);
+    std::shared_ptr<const StudentSnapshot> snapshot() const { return snap; }
+    // For a change that bypassed the journal, such as an import.
+    void setSnapshot(std::shared_ptr<const StudentSnapshot> s) { snap = std::move(s); }
+
+    // ---------- Background writes ----------
+    bool startWriter();
+    // Blocks until every queued record has been written (or failed). False if
+    // a write failed since the last takeWriteError().
+    bool flush();
+    // Sequence number of the last queued record, and how many queued records
+    // have been dealt with; an edit is on disk once completed() reaches the
+    // queued() taken right after it, unless takeWriteError() says otherwise.
+    uint64_t queued() const { return queuedSeq; }
+    uint64_t completed() const { return completedSeq; }
+    // True once per failed batch.
+    bool takeWriteError() { return writeError.exchange(false); }
+    // A batch was lost and only a snapshot can make up for it.
+    bool snapshotNeeded() const { return needSnapshot; }
+    size_t batchesWritten() const { return batches; }
+    size_t recordsCoalesced() const { return coalesced; }
+    size_t maxPending = 1 << 16;
+
+    // Starts a background compaction once the journal passes maxBytes or maxAge,
+    // or right away with force (after a bulk change that bypassed the journal)
+    // or when a queued batch failed to write. True if a compaction started.
+    bool maybeCompact(const StudentStore& db, bool force = false);
+    // Synchronous compaction (waits for a running one first).
+    bool compactNow(const StudentStore& db);
+    bool compacting() const { return busy; }
+    bool lastCompactFailed() const { return compactFailed; }
+
+    size_t journalBytes() const { return bytes; }
+
+    size_t maxBytes = 4u << 20;
+    std::chrono::seconds maxAge{300};
+
+private:
+    struct Pending {
+        int roll;
+        std::string payload;
+    };
+    bool appendRecord(int roll, std::string&& payload);
+    bool writeRecords(const std::string& recs);
+    bool rotate();
+    void waitCompaction();
+    void writerLoop();
+    void stopWriter();
+
+    std::string csvPath, binPath, logPath, oldPath;
+    int fd = -1;
+    std::mutex fdMutex;   // fd and the file itself, shared with the writer
+    std::atomic<size_t> bytes{0};
+    std::chrono::steady_clock::time_point lastCompact, lastAttempt;
+    std::thread worker;
+    std::atomic<bool> busy{false};
+    std::atomic<bool> compactFailed{false};
+    std::shared_ptr<const StudentSnapshot> snap;
+
+    std::thread writer;
+    std::mutex queueMutex;
+    std::condition_variable queueReady, queueSpace, queueDone;
+    std::vector<Pending> pending;
+    bool writing = false;
+    bool stopping = false;
+    std::atomic<uint64_t> queuedSeq{0};
+    std::atomic<uint64_t> completedSeq{0};
+    std::atomic<bool> writeError{false};
+    std::atomic<bool> needSnapshot{false};
+    std::atomic<size_t> batches{0};
+    std::atomic<size_t> coalesced{0};
+};
+
+// Applies one journal file to db and returns the number of records replayed.
+// Replay stops at a torn tail, which is cut off only when truncate is set:
+// a reader may be looking at a record the writer is still appending.
+size_t replay_journal(StudentStore& db, const std::string& logPath, int minSubjects, bool truncate = false);
@@ -0,0 +1,107 @@
+#include "student_list.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void StudentListView::setViewport(float height, float rowHeight) {
+    viewH = std::max(0.0f, height);
+    rowH = std::max(1.0f, rowHeight);
+    // Two spare entries cover the partly visible rows at the top and bottom.
+    size_t need = (size_t)std::ceil(viewH / rowH) + 2;
+    if (cache.size() < need) {
+        cache.assign(need, Entry{});
+        for (auto& e : cache) e.text.reserve(64);
+    }
+}
+
+int StudentListView::rowsPerPage() const {
+    return std::max(1, (int)(viewH / rowH));
+}
+
+double StudentListView::maxScroll(size_t rows) const {
+    return std::max(0.0, (double)rows * rowH - viewH);
+}
+
+void StudentListView::clamp(size_t rows) {
+    double m = maxScroll(rows);
+    target = std::min(std::max(target, 0.0), m);
+    pos = std::min(std::max(pos, 0.0), m);
+}
+
+void StudentListView::tick(float dt, size_t rows) {
+    clamp(rows);
+    // Exponential ease: about 95% of the way in 0.2 s, independent of frame rate.
+    double k = 1.0 - std::exp(-15.0 * dt);
+    pos += (target - pos) * k;
+    if (std::fabs(target - pos) < 0.5) pos = target;
+}
+
+void StudentListView::pageDown(size_t rows) {
+    target += rowsPerPage() * (double)rowH;
+    clamp(rows);
+}
+
+void StudentListView::pageUp(size_t rows) {
+    target -= rowsPerPage() * (double)rowH;
+    clamp(rows);
+}
+
+void StudentListView::home() {
+    target = 0;
+}
+
+void StudentListView::end(size_t rows) {
+    target = maxScroll(rows);
+}
+
+void StudentListView::ensureVisible(size_t row, size_t rows) {
+    double top = (double)row * rowH;
+    if (top < target) target = top;
+    else if (top + rowH > target + viewH) target = top + rowH - viewH;
+    clamp(rows);
+}
+
+void StudentListView::moveSelection(int delta, size_t rows) {
+    if (rows == 0) { selected = -1; return; }
+    long s = selected < 0 ? 0 : (long)selected + delta;
+    s = std::min(std::max(s, 0L), (long)rows - 1);
+    selected = (int)s;
+    ensureVisible((size_t)s, rows);
+}
+
+void StudentListView::jumpTo(size_t row, size_t rows) {
+    if (row >= rows) return;
+    selected = (int)row;
+    target = (double)row * rowH - (viewH - rowH) / 2;
+    clamp(rows);
+}
+
+StudentListView::Window StudentListView::window(size_t rows) const {
+    Window w;
+    if (rows == 0) return w;
+    w.first = std::min((size_t)(pos / rowH), rows - 1);
+    w.offsetY = (float)((double)w.first * rowH - pos);
+    size_t shown = (size_t)std::ceil((viewH - w.offsetY) / rowH);
+    w.last = std::min(rows, w.first + shown);
+    return w;
+}
+
+const std::string& StudentListView::rowText(const StudentStore& db, size_t row, size_t slot) {
+    if (cache.empty()) setViewport(viewH, rowH);
+    if (cacheRev != db.revision()) {
+        for (auto& e : cache) e.slot = (size_t)-1;
+        cacheRev = db.revision();
+    }
+    Entry& e = cache[row % cache.size()];
+    if (e.slot != slot) {
+        const StudentInfo& info = db.info(slot);
+        char buf[64];
+        int n = snprintf(buf, sizeof buf, "%d | ", info.roll);
+        e.text.assign(buf, n);
+        e.text += info.name;
+        n = snprintf(buf, sizeof buf, " | Score:%d", (int)db.totalScore(slot));
+        e.text.append(buf, n);
+        e.slot = slot;
+    }
+    return e.text;
+}
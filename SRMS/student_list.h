@@ -0,0 +1,66 @@
+// Virtualized student list: scrolling, paging and row-text cache (no raylib dependency)
+
+#pragma once
+#include "student_store.h"
+#include <string>
+#include <vector>
+
+// Keeps the scroll position in pixels and formats only the rows on screen.
+// A row is a position in the list: scrolling, paging, the window and the
+// selection all count rows. The caller maps each row to a store slot (the
+// same number, or hits[row] for search results) and asks for the row's text
+// by both. The text is cached by row, with the slot kept to check the entry,
+// until the store's revision changes. The rows on screen are contiguous and
+// never more than the cache holds, so they can't evict each other, and a
+// frame with no edits does no string work and no heap allocation. The
+// position is a double: a float loses whole pixels past 2^24 px, about
+// 600k rows. The caller draws; this class never touches raylib.
+class StudentListView {
+public:
+    struct Window {
+        size_t first = 0;   // first row drawn (may be partly hidden above)
+        size_t last = 0;    // one past the last row drawn
+        float offsetY = 0;  // y of row `first` relative to the top of the list area
+    };
+
+    void setViewport(float height, float rowHeight);
+    float rowHeight() const { return rowH; }
+    int rowsPerPage() const;
+
+    // Wheel and drag move a target; tick() eases the shown position towards it.
+    void scrollBy(double px) { target += px; }
+    void tick(float dt, size_t rows);
+    double scrollY() const { return pos; }
+
+    void pageDown(size_t rows);
+    void pageUp(size_t rows);
+    void home();
+    void end(size_t rows);
+    // Moves the selection by delta rows and keeps it in view.
+    void moveSelection(int delta, size_t rows);
+    // Selects row and scrolls it to the middle of the view.
+    void jumpTo(size_t row, size_t rows);
+    // Back to the top with nothing selected, without easing (new results).
+    void reset() { pos = target = 0; selected = -1; }
+
+    Window window(size_t rows) const;
+    // "roll | name | Score:total" for the slot shown at row, formatted on a
+    // cache miss only.
+    const std::string& rowText(const StudentStore& db, size_t row, size_t slot);
+
+    int selected = -1;
+
+private:
+    double maxScroll(size_t rows) const;
+    void clamp(size_t rows);
+    void ensureVisible(size_t row, size_t rows);
+
+    struct Entry {
+        size_t slot = (size_t)-1;
+        std::string text;
+    };
+    std::vector<Entry> cache;   // direct-mapped by row % size
+    uint64_t cacheRev = (uint64_t)-1;
+    float viewH = 0, rowH = 1;
+    double pos = 0, target = 0;
+};
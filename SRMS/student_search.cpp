@@ -0,0 +1,297 @@
+#include "student_search.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+
+using std::string;
+using std::vector;
+
+// ---------- Parsing ----------
+static bool is_op_char(char c) { return c == '<' || c == '>' || c == '=' || c == '!'; }
+
+static bool all_digits(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s) if (c < '0' || c > '9') return false;
+    return true;
+}
+
+static bool parse_number(const string& s, double& out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    out = strtod(s.c_str(), &end);
+    return end == s.c_str() + s.size();
+}
+
+static bool parse_op(const string& s, MarkFilter::Op& op) {
+    if (s == "<") op = MarkFilter::LT;
+    else if (s == "<=") op = MarkFilter::LE;
+    else if (s == ">") op = MarkFilter::GT;
+    else if (s == ">=") op = MarkFilter::GE;
+    else if (s == "=" || s == "==") op = MarkFilter::EQ;
+    else if (s == "!=" || s == "<>") op = MarkFilter::NE;
+    else return false;
+    return true;
+}
+
+static string lower(const string& s) {
+    string out = s;
+    for (char& c : out) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    return out;
+}
+
+// Whitespace and commas separate tokens; runs of < > = ! are tokens of their own.
+static vector<string> tokenize(std::string_view text) {
+    vector<string> toks;
+    string cur;
+    bool curOp = false;
+    for (char c : text) {
+        bool sep = c == ' ' || c == '\t' || c == ',';
+        bool op = is_op_char(c);
+        if (sep || (!cur.empty() && op != curOp)) {
+            if (!cur.empty()) toks.push_back(cur);
+            cur.clear();
+        }
+        if (!sep) { cur.push_back(c); curOp = op; }
+    }
+    if (!cur.empty()) toks.push_back(cur);
+    return toks;
+}
+
+bool parse_query(std::string_view text, SearchQuery& q, string* err) {
+    q = SearchQuery();
+    vector<string> toks = tokenize(text);
+    vector<string> words;
+    auto fail = [&](const char* msg) {
+        if (err) *err = msg;
+        return false;
+    };
+    for (size_t i = 0; i < toks.size(); ++i) {
+        string t = lower(toks[i]);
+        if (t == "and") continue;
+        bool subj = t == "subject" || t == "sub" || t == "mark";
+        bool agg = t == "total" || t == "avg" || t == "average";
+        double num;
+        bool startsFilter = (subj || agg) && i + 1 < toks.size() &&
+                            (parse_number(toks[i + 1], num) || is_op_char(toks[i + 1][0]));
+        if (!startsFilter) { words.push_back(toks[i]); continue; }
+
+        MarkFilter f;
+        size_t j = i + 1;
+        if (subj) {
+            f.field = MarkFilter::SUBJECT;
+            if (j >= toks.size() || !all_digits(toks[j])) return fail("Filter needs a subject number");
+            f.subject = atoi(toks[j].c_str()) - 1;
+            if (f.subject < 0) return fail("Subjects start at 1");
+            ++j;
+        } else {
+            f.field = t == "total" ? MarkFilter::TOTAL : MarkFilter::AVERAGE;
+        }
+        if (j >= toks.size() || !parse_op(toks[j], f.op)) return fail("Filter needs <, <=, >, >=, = or !=");
+        ++j;
+        if (j >= toks.size() || !parse_number(toks[j], f.value)) return fail("Filter needs a value");
+        q.filters.push_back(f);
+        i = j;
+    }
+    if (words.size() == 1 && all_digits(words[0])) {
+        q.rollPrefix = words[0];
+    } else {
+        for (auto& w : words) {
+            if (!q.name.empty()) q.name += ' ';
+            q.name += w;
+        }
+    }
+    if (err) err->clear();
+    return true;
+}
+
+// ---------- Execution ----------
+static bool compare(double v, MarkFilter::Op op, double value) {
+    switch (op) {
+    case MarkFilter::LT: return v < value;
+    case MarkFilter::LE: return v <= value;
+    case MarkFilter::GT: return v > value;
+    case MarkFilter::GE: return v >= value;
+    case MarkFilter::EQ: return v == value;
+    case MarkFilter::NE: return v != value;
+    }
+    return false;
+}
+
+static bool keep(const MarksTable& m, size_t slot, const MarkFilter& f) {
+    double v;
+    if (f.field == MarkFilter::SUBJECT) {
+        if (f.subject >= m.subjects() || m.count(slot) <= f.subject) return false;
+        v = m.get(slot, f.subject);
+    } else if (f.field == MarkFilter::TOTAL) {
+        v = (double)m.rowTotal(slot);
+    } else {
+        int n = m.count(slot);
+        v = n ? (double)m.rowTotal(slot) / n : 0.0;
+    }
+    return compare(v, f.op, f.value);
+}
+
+// Writes every row index, advancing only past matches, so the loops have no
+// branches to mispredict on a ~50% filter.
+template <class Cmp>
+static size_t select_rows(const MarksTable& m, const MarkFilter& f, Cmp cmp, uint32_t* out) {
+    size_t n = m.rows(), k = 0;
+    const uint16_t* cnt = m.counts();
+    const int64_t* tot = m.totals();
+    double x = f.value;
+    if (f.field == MarkFilter::SUBJECT) {
+        if (f.subject >= m.subjects()) return 0;
+        int j = f.subject;
+        m.visitColumn(j, [&](const auto* col) {
+            for (size_t i = 0; i < n; ++i) { out[k] = (uint32_t)i; k += (cnt[i] > j) & cmp((double)col[i], x); }
+        });
+    } else if (f.field == MarkFilter::TOTAL) {
+        for (size_t i = 0; i < n; ++i) { out[k] = (uint32_t)i; k += cmp((double)tot[i], x); }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            out[k] = (uint32_t)i;
+            k += cmp(cnt[i] ? (double)tot[i] / cnt[i] : 0.0, x);
+        }
+    }
+    return k;
+}
+
+static void scan_filter(const MarksTable& m, const MarkFilter& f, vector<uint32_t>& out) {
+    out.resize(m.rows());
+    size_t k = 0;
+    switch (f.op) {
+    case MarkFilter::LT: k = select_rows(m, f, std::less<double>(), out.data()); break;
+    case MarkFilter::LE: k = select_rows(m, f, std::less_equal<double>(), out.data()); break;
+    case MarkFilter::GT: k = select_rows(m, f, std::greater<double>(), out.data()); break;
+    case MarkFilter::GE: k = select_rows(m, f, std::greater_equal<double>(), out.data()); break;
+    case MarkFilter::EQ: k = select_rows(m, f, std::equal_to<double>(), out.data()); break;
+    case MarkFilter::NE: k = select_rows(m, f, std::not_equal_to<double>(), out.data()); break;
+    }
+    out.resize(k);
+}
+
+// Rolls whose decimal form starts with a prefix fall in [p, p], [p0, p9],
+// [p00, p99], ... up to INT_MAX.
+// Unused entries are empty (lo > hi), so has() is a fixed-length loop the
+// compiler unrolls.
+struct RollRanges {
+    int lo[10] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    int hi[10] = {};
+    int count = 0;
+    bool has(int r) const {
+        bool in = false;
+        for (int i = 0; i < 10; ++i) in |= (r >= lo[i]) & (r <= hi[i]);
+        return in;
+    }
+};
+
+static RollRanges roll_ranges(const string& prefix) {
+    RollRanges rr;
+    if (prefix[0] == '0') {
+        // Rolls are printed without leading zeros, so only "0" itself matches.
+        if (prefix == "0") { rr.lo[0] = rr.hi[0] = 0; rr.count = 1; }
+        return rr;
+    }
+    if (prefix.size() > 10) return rr;
+    long long lo = atoll(prefix.c_str()), hi = lo;
+    for (; lo <= INT_MAX; lo = lo * 10, hi = hi * 10 + 9) {
+        rr.lo[rr.count] = (int)lo;
+        rr.hi[rr.count] = (int)std::min<long long>(hi, INT_MAX);
+        rr.count++;
+    }
+    return rr;
+}
+
+void run_query(const StudentStore& db, const SearchQuery& q, vector<uint32_t>& out, bool* fuzzy) {
+    out.clear();
+    if (fuzzy) *fuzzy = false;
+    const MarksTable& m = db.marks();
+    const int32_t* rolls = db.rolls().data();
+    size_t n = db.size();
+    RollRanges rr;
+    if (!q.rollPrefix.empty()) rr = roll_ranges(q.rollPrefix);
+
+    // Filters go first when present: a column scan is cheaper than text
+    // matching, and the text check then only sees the survivors.
+    if (!q.filters.empty()) {
+        scan_filter(m, q.filters[0], out);
+        for (size_t f = 1; f < q.filters.size(); ++f) {
+            size_t k = 0;
+            for (uint32_t slot : out)
+                if (keep(m, slot, q.filters[f])) out[k++] = slot;
+            out.resize(k);
+        }
+        if (!q.rollPrefix.empty()) {
+            size_t k = 0;
+            for (uint32_t slot : out)
+                if (rr.has(rolls[slot])) out[k++] = slot;
+            out.resize(k);
+        } else if (!q.name.empty()) {
+            db.nameIndex().filter(q.name, out);
+            if (out.empty() && q.name.size() >= 3) {
+                db.nameIndex().similar(q.name, 200, out);
+                size_t k = 0;
+                for (uint32_t slot : out) {
+                    bool ok = true;
+                    for (auto& f : q.filters) ok = ok && keep(m, slot, f);
+                    if (ok) out[k++] = slot;
+                }
+                out.resize(k);
+                if (fuzzy) *fuzzy = !out.empty();
+            }
+        }
+    } else if (!q.rollPrefix.empty()) {
+        // Match flags first (this loop vectorizes), then gather.
+        vector<uint8_t> hit(n);
+        for (size_t i = 0; i < n; ++i) hit[i] = rr.has(rolls[i]);
+        for (size_t i = 0; i < n; ++i)
+            if (hit[i]) out.push_back((uint32_t)i);
+    } else if (!q.name.empty()) {
+        const NameIndex& names = db.nameIndex();
+        names.substring(q.name, out);
+        if (out.empty() && q.name.size() >= 3) {
+            names.similar(q.name, 200, out);
+            if (fuzzy) *fuzzy = !out.empty();
+        }
+    } else {
+        out.resize(n);
+        for (size_t i = 0; i < n; ++i) out[i] = (uint32_t)i;
+    }
+
+    // The exact roll, if it matched, comes first so Enter can pick it.
+    if (!q.rollPrefix.empty() && rr.count) {
+        int exact = db.indexOf(rr.lo[0]);
+        auto it = std::find(out.begin(), out.end(), (uint32_t)exact);
+        if (exact >= 0 && it != out.end()) std::rotate(out.begin(), it, it + 1);
+    }
+}
+
+// ---------- Search Box ----------
+bool StudentSearch::update(const StudentStore& db, const string& newText) {
+    bool changed = false;
+    if (newText != text) {
+        text = newText;
+        SearchQuery q;
+        // A half-typed filter keeps the previous results on screen.
+        if (parse_query(text, q, &err)) {
+            query = std::move(q);
+            changed = true;
+        } else if (rev == db.revision()) {
+            return false;
+        }
+    } else if (rev == db.revision()) {
+        return false;
+    }
+    rev = db.revision();
+    auto t = std::chrono::steady_clock::now();
+    if (query.empty()) {
+        results.clear();
+        fuzzyHits = false;
+    } else {
+        run_query(db, query, results, &fuzzyHits);
+    }
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+    return changed;
+}
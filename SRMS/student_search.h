@@ -0,0 +1,58 @@
+// Student search: roll prefix, name and mark filters over a StudentStore (no raylib dependency)
+
+#pragma once
+#include "student_store.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct MarkFilter {
+    enum Field { SUBJECT, TOTAL, AVERAGE };
+    enum Op { LT, LE, GT, GE, EQ, NE };
+    Field field = SUBJECT;
+    int subject = 0;   // 0-based column, SUBJECT only
+    Op op = LT;
+    double value = 0;
+};
+
+struct SearchQuery {
+    std::string rollPrefix;   // digits only
+    std::string name;         // substring, fuzzy when nothing contains it
+    std::vector<MarkFilter> filters;
+    bool empty() const { return rollPrefix.empty() && name.empty() && filters.empty(); }
+};
+
+// Accepts free text plus any number of filters, e.g.
+//   "1203"                    roll prefix
+//   "ali"                     name contains "ali" (any case)
+//   "subject 2 < 40"          mark in subject 2 (1-based) below 40
+//   "ali, total >= 250 and avg > 80"
+// A lone number is a roll prefix; other words form the name text. False, with
+// err set, when a filter is incomplete or malformed.
+bool parse_query(std::string_view text, SearchQuery& q, std::string* err = nullptr);
+
+// Matching slots in slot order, except that an exact roll comes first and
+// fuzzy name hits (*fuzzy set) come best first. Filters narrow either.
+void run_query(const StudentStore& db, const SearchQuery& q, std::vector<uint32_t>& out, bool* fuzzy = nullptr);
+
+// Keeps the results of the search box current: re-runs the query when the
+// text or the store changes, otherwise costs nothing.
+class StudentSearch {
+public:
+    // True when the text changed, so callers can reset scroll and selection.
+    bool update(const StudentStore& db, const std::string& text);
+    bool active() const { return !query.empty(); }
+    const std::vector<uint32_t>& hits() const { return results; }
+    bool fuzzy() const { return fuzzyHits; }
+    const std::string& error() const { return err; }
+    double lastMs() const { return ms; }
+
+private:
+    std::string text;
+    uint64_t rev = (uint64_t)-1;
+    SearchQuery query;
+    std::vector<uint32_t> results;
+    bool fuzzyHits = false;
+    std::string err;
+    double ms = 0;
+};
@@ -0,0 +1,161 @@
+#include "student_snapshot.h"
+#include <algorithm>
+#include <numeric>
+
+using std::string;
+using std::vector;
+
+// ---------- Shard ----------
+void StudentSnapshot::Shard::clear() {
+    rolls.clear();
+    textOff.assign(1, 0);
+    nameLen.clear();
+    markOff.assign(1, 0);
+    marks.clear();
+    totals.clear();
+    text.clear();
+}
+
+void StudentSnapshot::Shard::reserve(size_t n, size_t textBytes, size_t markCount) {
+    rolls.reserve(n);
+    textOff.reserve(n + 1);
+    nameLen.reserve(n);
+    markOff.reserve(n + 1);
+    marks.reserve(markCount);
+    totals.reserve(n);
+    text.reserve(textBytes);
+}
+
+void StudentSnapshot::Shard::append(int roll, std::string_view name, std::string_view password,
+                                    const int32_t* m, int count) {
+    rolls.push_back(roll);
+    nameLen.push_back((uint32_t)name.size());
+    text.append(name.data(), name.size());
+    text.append(password.data(), password.size());
+    textOff.push_back((uint32_t)text.size());
+    int64_t total = 0;
+    for (int j = 0; j < count; ++j) total += m[j];
+    marks.insert(marks.end(), m, m + count);
+    markOff.push_back((uint32_t)marks.size());
+    totals.push_back(total);
+}
+
+void StudentSnapshot::Shard::appendFrom(const Shard& s, size_t i) {
+    rolls.push_back(s.rolls[i]);
+    nameLen.push_back(s.nameLen[i]);
+    text.append(s.text, s.textOff[i], s.textOff[i + 1] - s.textOff[i]);
+    textOff.push_back((uint32_t)text.size());
+    marks.insert(marks.end(), s.marks.begin() + s.markOff[i], s.marks.begin() + s.markOff[i + 1]);
+    markOff.push_back((uint32_t)marks.size());
+    totals.push_back(s.totals[i]);
+}
+
+// ---------- Snapshot ----------
+std::shared_ptr<const StudentSnapshot> StudentSnapshot::build(const StudentStore& db, uint64_t version) {
+    auto snap = std::make_shared<StudentSnapshot>();
+    snap->ver = version;
+    snap->rows = db.size();
+    // Counting sort of slots by shard, then by roll inside each shard.
+    const vector<int32_t>& rolls = db.rolls();
+    vector<uint32_t> start(SHARDS + 1, 0);
+    for (int32_t r : rolls) start[shardOf(r) + 1]++;
+    for (size_t s = 0; s < SHARDS; ++s) start[s + 1] += start[s];
+    vector<uint32_t> order(rolls.size());
+    vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < rolls.size(); ++i) order[fill[shardOf(rolls[i])]++] = (uint32_t)i;
+
+    const MarksTable& table = db.marks();
+    vector<int32_t> row;
+    snap->shards.resize(SHARDS);
+    for (size_t s = 0; s < SHARDS; ++s) {
+        auto b = order.begin() + start[s], e = order.begin() + start[s + 1];
+        std::sort(b, e, [&](uint32_t x, uint32_t y) { return rolls[x] < rolls[y]; });
+        auto shard = std::make_shared<Shard>();
+        shard->clear();
+        shard->reserve(e - b, 0, 0);
+        for (auto it = b; it != e; ++it) {
+            const StudentInfo& info = db.info(*it);
+            row.resize(table.count(*it));
+            for (int j = 0; j < (int)row.size(); ++j) row[j] = table.get(*it, j);
+            shard->append(info.roll, info.name, info.password, row.data(), (int)row.size());
+        }
+        snap->shards[s] = std::move(shard);
+    }
+    return snap;
+}
+
+std::shared_ptr<const StudentSnapshot> StudentSnapshot::apply(const vector<Edit>& edits) const {
+    auto next = std::make_shared<StudentSnapshot>(*this);
+    next->ver = ver + 1;
+    // Edits grouped by shard and roll; the last edit of a roll wins.
+    vector<uint32_t> idx(edits.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    std::stable_sort(idx.begin(), idx.end(), [&](uint32_t a, uint32_t b) {
+        size_t sa = shardOf(edits[a].roll), sb = shardOf(edits[b].roll);
+        return sa != sb ? sa < sb : edits[a].roll < edits[b].roll;
+    });
+    size_t k = 0;
+    while (k < idx.size()) {
+        size_t s = shardOf(edits[idx[k]].roll);
+        size_t end = k;
+        while (end < idx.size() && shardOf(edits[idx[end]].roll) == s) end++;
+
+        const Shard& old = *shards[s];
+        auto shard = std::make_shared<Shard>();
+        shard->clear();
+        // Room for the old rows plus the edits, so the merge never regrows.
+        size_t addText = 0, addMarks = 0;
+        for (size_t j = k; j < end; ++j) {
+            const Edit& e = edits[idx[j]];
+            addText += e.row.name.size() + e.row.password.size();
+            addMarks += e.row.marks.size();
+        }
+        shard->reserve(old.size() + (end - k), old.text.size() + addText, old.marks.size() + addMarks);
+        size_t i = 0;
+        while (k < end) {
+            // Skip to the last edit of this roll.
+            while (k + 1 < end && edits[idx[k + 1]].roll == edits[idx[k]].roll) k++;
+            const Edit& e = edits[idx[k++]];
+            int roll = e.roll;
+            while (i < old.size() && old.rolls[i] < roll) shard->appendFrom(old, i++);
+            bool present = i < old.size() && old.rolls[i] == roll;
+            if (present) i++;
+            if (!e.erase) {
+                shard->append(roll, e.row.name, e.row.password, e.row.marks.data(), (int)e.row.marks.size());
+                if (!present) next->rows++;
+            } else if (present) {
+                next->rows--;
+            }
+        }
+        while (i < old.size()) shard->appendFrom(old, i++);
+        next->shards[s] = std::move(shard);
+    }
+    return next;
+}
+
+void StudentSnapshot::rowAt(const Shard& s, size_t i, Row& out) {
+    const char* t = s.text.data() + s.textOff[i];
+    out.roll = s.rolls[i];
+    out.name = std::string_view(t, s.nameLen[i]);
+    out.password = std::string_view(t + s.nameLen[i], s.textOff[i + 1] - s.textOff[i] - s.nameLen[i]);
+    out.marks = s.marks.data() + s.markOff[i];
+    out.count = (int)(s.markOff[i + 1] - s.markOff[i]);
+    out.total = s.totals[i];
+}
+
+bool StudentSnapshot::find(int roll, Row& out) const {
+    const Shard& s = *shards[shardOf(roll)];
+    auto it = std::lower_bound(s.rolls.begin(), s.rolls.end(), roll);
+    if (it == s.rolls.end() || *it != roll) return false;
+    rowAt(s, it - s.rolls.begin(), out);
+    return true;
+}
+
+vector<StudentSnapshot::Row> StudentSnapshot::sorted() const {
+    vector<Row> out(rows);
+    size_t k = 0;
+    for (const auto& s : shards)
+        for (size_t i = 0; i < s->size(); ++i) rowAt(*s, i, out[k++]);
+    std::sort(out.begin(), out.end(), [](const Row& a, const Row& b) { return a.roll < b.roll; });
+    return out;
+}
@@ -0,0 +1,75 @@
+// Immutable, structurally shared snapshots of the store for concurrent readers (no raylib dependency)
+
+#pragma once
+#include "student_store.h"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// A snapshot never changes once built, so any number of threads can read it
+// without locks. Rows are spread over SHARDS shards by a hash of the roll and
+// kept sorted by roll inside each shard. An edit builds a new snapshot that
+// shares every shard but the ones it touches, so publishing one edit copies
+// about size() / SHARDS rows, not the whole roster.
+class StudentSnapshot {
+public:
+    static const int SHARD_BITS = 10;
+    static const size_t SHARDS = (size_t)1 << SHARD_BITS;
+
+    struct Row {
+        int roll = 0;
+        std::string_view name;
+        std::string_view password;
+        const int32_t* marks = nullptr;
+        int count = 0;
+        int64_t total = 0;
+    };
+    // One change: an upsert of row, or an erase. roll is always set.
+    struct Edit {
+        bool erase = false;
+        int roll = 0;
+        Student row;
+    };
+
+    static std::shared_ptr<const StudentSnapshot> build(const StudentStore& db, uint64_t version = 0);
+    // This snapshot with edits applied in order, as the next version.
+    std::shared_ptr<const StudentSnapshot> apply(const std::vector<Edit>& edits) const;
+
+    size_t size() const { return rows; }
+    uint64_t version() const { return ver; }
+    // The row stays valid for as long as this snapshot is alive.
+    bool find(int roll, Row& out) const;
+    // Every row, sorted by roll, for a worker to write out or load into a
+    // store. Valid for as long as this snapshot is alive.
+    std::vector<Row> sorted() const;
+
+    struct Shard;
+
+private:
+    static void rowAt(const Shard& s, size_t i, Row& out);
+    static size_t shardOf(int roll) {
+        return (size_t)(((uint64_t)(uint32_t)roll * 0x9E3779B97F4A7C15ull) >> (64 - SHARD_BITS));
+    }
+    std::vector<std::shared_ptr<const Shard>> shards;
+    size_t rows = 0;
+    uint64_t ver = 0;
+};
+
+// Rows of one shard in flat arrays, sorted by roll; name and password sit
+// back to back in text.
+struct StudentSnapshot::Shard {
+    std::vector<int32_t> rolls;
+    std::vector<uint32_t> textOff;   // size() + 1 entries
+    std::vector<uint32_t> nameLen;
+    std::vector<uint32_t> markOff;   // size() + 1 entries
+    std::vector<int32_t> marks;
+    std::vector<int64_t> totals;
+    std::string text;
+
+    size_t size() const { return rolls.size(); }
+    void clear();
+    void reserve(size_t n, size_t textBytes, size_t markCount);
+    void append(int roll, std::string_view name, std::string_view password, const int32_t* m, int count);
+    void appendFrom(const Shard& s, size_t i);
+};
@@ -0,0 +1,280 @@
+#include "student_store.h"
+#include <algorithm>
+#include <cmath>
+
+// ---------- Roll Index ----------
+void RollIndex::clear() {
+    cells.clear();
+    count = 0;
+    mask = 0;
+    shift = 64;
+}
+
+void RollIndex::reserve(size_t n) {
+    size_t cap = 16;
+    while (cap < n * 2) cap <<= 1;
+    if (cap > cells.size()) rehash(cap);
+}
+
+void RollIndex::rehash(size_t cap) {
+    std::vector<Cell> old;
+    old.swap(cells);
+    cells.assign(cap, Cell{0, NONE});
+    mask = cap - 1;
+    shift = 64;
+    for (size_t c = cap; c > 1; c >>= 1) shift--;
+    for (const Cell& c : old) {
+        if (c.val == NONE) continue;
+        size_t i = home(c.key);
+        while (cells[i].val != NONE) i = (i + 1) & mask;
+        cells[i] = c;
+    }
+}
+
+// Cell holding roll, or the empty cell where it would go.
+size_t RollIndex::probe(int roll) const {
+    size_t i = home(roll);
+    while (cells[i].val != NONE && cells[i].key != roll) i = (i + 1) & mask;
+    return i;
+}
+
+uint32_t RollIndex::get(int roll) const {
+    if (cells.empty()) return NONE;
+    return cells[probe(roll)].val;
+}
+
+uint32_t RollIndex::insert(int roll, uint32_t slot) {
+    if ((count + 1) * 2 > cells.size()) rehash(std::max<size_t>(16, cells.size() * 2));
+    size_t i = probe(roll);
+    if (cells[i].val != NONE) return cells[i].val;
+    cells[i] = Cell{roll, slot};
+    count++;
+    return slot;
+}
+
+void RollIndex::set(int roll, uint32_t slot) {
+    cells[probe(roll)].val = slot;
+}
+
+bool RollIndex::remove(int roll) {
+    if (cells.empty()) return false;
+    size_t i = probe(roll);
+    if (cells[i].val == NONE) return false;
+    // Pull later cells of the same probe run back into the hole.
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (cells[j].val == NONE) break;
+        size_t k = home(cells[j].key);
+        bool movable = (j > i) ? (k <= i || k > j) : (k <= i && k > j);
+        if (movable) { cells[i] = cells[j]; i = j; }
+    }
+    cells[i].val = NONE;
+    count--;
+    return true;
+}
+
+// ---------- Store ----------
+void StudentStore::reserve(size_t n) {
+    recs.reserve(n);
+    table.reserve(n);
+    byRoll.reserve(n);
+}
+
+void StudentStore::clear() {
+    rev++;
+    recs.clear();
+    table.clear();
+    byRoll.clear();
+    rollCol.clear();
+    ordered.clear();
+    orderedValid = true;
+    ranking.clear();
+    rankingValid = true;
+    names.clear();
+    namesValid = true;
+}
+
+void StudentStore::swap(StudentStore& o) {
+    std::swap(recs, o.recs);
+    std::swap(table, o.table);
+    std::swap(byRoll, o.byRoll);
+    std::swap(rollCol, o.rollCol);
+    std::swap(ordered, o.ordered);
+    std::swap(orderedValid, o.orderedValid);
+    ranking.swap(o.ranking);
+    std::swap(rankingValid, o.rankingValid);
+    std::swap(names, o.names);
+    std::swap(namesValid, o.namesValid);
+    rev = o.rev = std::max(rev, o.rev) + 1;
+}
+
+void StudentStore::assign(std::vector<Student>&& rows) {
+    clear();
+    int subjects = 0;
+    for (auto& s : rows) subjects = std::max(subjects, (int)s.marks.size());
+    recs.reserve(rows.size());
+    table.ensureSubjects(subjects);
+    table.resizeRows(rows.size());
+    byRoll.reserve(rows.size());
+    for (auto& s : rows) {
+        uint32_t slot = (uint32_t)recs.size();
+        uint32_t at = byRoll.insert(s.roll, slot);
+        table.setRow(at, s.marks);
+        if (at != slot) {
+            recs[at].name = std::move(s.name);
+            recs[at].password = std::move(s.password);
+            continue;
+        }
+        recs.push_back(StudentInfo{s.roll, std::move(s.name), std::move(s.password)});
+    }
+    table.resizeRows(recs.size());
+    rollCol.resize(recs.size());
+    for (size_t i = 0; i < recs.size(); ++i) rollCol[i] = recs[i].roll;
+    rows.clear();
+    orderedValid = rankingValid = namesValid = recs.empty();
+}
+
+bool StudentStore::assign(std::vector<StudentInfo>&& infos, MarksTable&& marks) {
+    clear();
+    if (marks.rows() != infos.size()) return false;
+    byRoll.reserve(infos.size());
+    for (size_t i = 0; i < infos.size(); ++i) {
+        if (byRoll.insert(infos[i].roll, (uint32_t)i) != i) { byRoll.clear(); return false; }
+    }
+    recs = std::move(infos);
+    rollCol.resize(recs.size());
+    for (size_t i = 0; i < recs.size(); ++i) rollCol[i] = recs[i].roll;
+    table = std::move(marks);
+    table.recomputeTotals();
+    orderedValid = rankingValid = namesValid = recs.empty();
+    return true;
+}
+
+const std::set<int>& StudentStore::orderedIndex() const {
+    if (!orderedValid) {
+        ordered.clear();
+        // Inserting in sorted order lets every end() hint hit.
+        std::vector<int> rolls;
+        rolls.reserve(recs.size());
+        for (auto& s : recs) rolls.push_back(s.roll);
+        std::sort(rolls.begin(), rolls.end());
+        for (int r : rolls) ordered.insert(ordered.end(), r);
+        orderedValid = true;
+    }
+    return ordered;
+}
+
+const ScoreRanking& StudentStore::scoreRanking() const {
+    if (!rankingValid) {
+        std::vector<std::pair<int, int64_t>> entries(recs.size());
+        for (size_t i = 0; i < recs.size(); ++i) entries[i] = {recs[i].roll, table.rowTotal(i)};
+        ranking.build(std::move(entries));
+        rankingValid = true;
+    }
+    return ranking;
+}
+
+bool StudentStore::warmNameIndex(size_t n) const {
+    if (namesValid) return true;
+    if (names.size() == 0) names.reserve(recs.size());
+    size_t end = std::min(recs.size(), names.size() + n);
+    for (size_t i = names.size(); i < end; ++i) names.add(recs[i].name);
+    namesValid = names.size() == recs.size();
+    return namesValid;
+}
+
+const NameIndex& StudentStore::nameIndex() const {
+    warmNameIndex(recs.size());
+    return names;
+}
+
+size_t StudentStore::rankOf(int roll) const {
+    uint32_t slot = byRoll.get(roll);
+    if (slot == RollIndex::NONE) return 0;
+    return scoreRanking().rankOf(roll, table.rowTotal(slot));
+}
+
+std::vector<int> StudentStore::topRolls(size_t k) const {
+    return scoreRanking().top(k);
+}
+
+double StudentStore::percentileOf(double score) const {
+    return scoreRanking().percentileOf((int64_t)std::floor(score));
+}
+
+Student StudentStore::get(size_t slot) const {
+    Student s;
+    s.roll = recs[slot].roll;
+    s.name = recs[slot].name;
+    s.password = recs[slot].password;
+    table.row(slot, s.marks);
+    return s;
+}
+
+int StudentStore::indexOf(int roll) const {
+    uint32_t slot = byRoll.get(roll);
+    return slot == RollIndex::NONE ? -1 : (int)slot;
+}
+
+const StudentInfo* StudentStore::find(int roll) const {
+    uint32_t slot = byRoll.get(roll);
+    return slot == RollIndex::NONE ? nullptr : &recs[slot];
+}
+
+bool StudentStore::insert(const Student& s) {
+    uint32_t slot = (uint32_t)recs.size();
+    if (byRoll.insert(s.roll, slot) != slot) return false;
+    rev++;
+    recs.push_back(StudentInfo{s.roll, s.name, s.password});
+    rollCol.push_back(s.roll);
+    table.appendRow(s.marks);
+    if (orderedValid) ordered.insert(s.roll);
+    if (rankingValid) ranking.add(s.roll, table.rowTotal(slot));
+    if (namesValid) names.add(s.name);
+    else names.clear();   // a partial warm-up restarts
+    return true;
+}
+
+bool StudentStore::update(const Student& s) {
+    uint32_t slot = byRoll.get(s.roll);
+    if (slot == RollIndex::NONE) return false;
+    rev++;
+    if (namesValid) names.rename(slot, s.name);
+    else names.clear();
+    recs[slot].name = s.name;
+    recs[slot].password = s.password;
+    int64_t before = table.rowTotal(slot);
+    table.setRow(slot, s.marks);
+    if (rankingValid && table.rowTotal(slot) != before) {
+        ranking.remove(s.roll, before);
+        ranking.add(s.roll, table.rowTotal(slot));
+    }
+    return true;
+}
+
+void StudentStore::upsert(const Student& s) {
+    if (!update(s)) insert(s);
+}
+
+bool StudentStore::erase(int roll) {
+    uint32_t slot = byRoll.get(roll);
+    if (slot == RollIndex::NONE) return false;
+    rev++;
+    if (rankingValid) ranking.remove(roll, table.rowTotal(slot));
+    if (namesValid) names.removeSwap(slot);
+    else names.clear();
+    uint32_t last = (uint32_t)recs.size() - 1;
+    if (slot != last) {
+        recs[slot] = std::move(recs[last]);
+        rollCol[slot] = rollCol[last];
+        table.moveRow(last, slot);
+        byRoll.set(recs[slot].roll, slot);
+    }
+    recs.pop_back();
+    rollCol.pop_back();
+    table.popRow();
+    byRoll.remove(roll);
+    if (orderedValid) ordered.erase(roll);
+    return true;
+}
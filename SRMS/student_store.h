@@ -0,0 +1,149 @@
+// Student records + roll indexes (no raylib dependency)
+
+#pragma once
+#include "marks_table.h"
+#include "name_index.h"
+#include "score_rank.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+// ---------- Data ----------
+// Row form of a student, used by forms, files and the journal. Inside the
+// store the marks live in a MarksTable column per subject instead.
+struct Student {
+    int roll = 0;
+    std::string name;
+    std::string password;
+    std::vector<int> marks;
+    double totalScore() const {
+        double s = 0;
+        for (int m : marks) s += m;
+        return s;
+    }
+    double averageScore() const {
+        if (marks.empty()) return 0.0;
+        return totalScore() / marks.size();
+    }
+};
+
+// The non-mark fields, as the store keeps them per slot.
+struct StudentInfo {
+    int roll = 0;
+    std::string name;
+    std::string password;
+};
+
+// ---------- Roll Index ----------
+// Open-addressing roll -> slot map: linear probing over one flat array, with
+// backward-shift deletion so there are no tombstones. Kept at most half full.
+class RollIndex {
+public:
+    static const uint32_t NONE = UINT32_MAX;
+    size_t size() const { return count; }
+    void clear();
+    void reserve(size_t n);
+    uint32_t get(int roll) const;                   // NONE if absent
+    // Inserts roll -> slot. If roll is already present, leaves it and returns its slot.
+    uint32_t insert(int roll, uint32_t slot);
+    void set(int roll, uint32_t slot);              // roll must be present
+    bool remove(int roll);
+private:
+    struct Cell { int32_t key; uint32_t val; };
+    size_t home(int roll) const { return (size_t)(((uint64_t)(uint32_t)roll * 0x9E3779B97F4A7C15ull) >> shift); }
+    size_t probe(int roll) const;
+    void rehash(size_t cap);
+    std::vector<Cell> cells;
+    size_t count = 0;
+    size_t mask = 0;
+    int shift = 64;
+};
+
+// ---------- Store ----------
+// Owns the records: StudentInfo in a dense array and marks in a MarksTable,
+// both indexed by slot. A hash index gives O(1) roll lookup and an ordered
+// index serves range queries by roll. Deletes swap the last record into the
+// hole, so slot numbers are only stable until the next erase().
+// The ordered index, the score ranking and the name index are built on first
+// use after a bulk assign() and then maintained per edit, so cold start only
+// pays for the hash index.
+class StudentStore {
+public:
+    size_t size() const { return recs.size(); }
+    bool empty() const { return recs.empty(); }
+    // Bumped by every mutation; views compare it to know when to refresh caches.
+    uint64_t revision() const { return rev; }
+    void reserve(size_t n);
+    void clear();
+    // Exchanges contents in O(1), so a store built on another thread can be
+    // put in place between two frames. Both revisions move past either old one.
+    void swap(StudentStore& o);
+    // Replaces the contents with rows (later duplicates of a roll win) and
+    // rebuilds both indexes in one pass. Faster than upserting row by row.
+    void assign(std::vector<Student>&& rows);
+    // Same, from ready-made columns (one MarksTable row per info). False, and
+    // the store left empty, if a roll repeats.
+    bool assign(std::vector<StudentInfo>&& infos, MarksTable&& marks);
+
+    const StudentInfo& info(size_t slot) const { return recs[slot]; }
+    // Roll of every slot, contiguous so scans don't stride over names.
+    const std::vector<int32_t>& rolls() const { return rollCol; }
+    const std::vector<StudentInfo>& infos() const { return recs; }
+    const MarksTable& marks() const { return table; }
+    // Materializes the row form (copies name, password and marks).
+    Student get(size_t slot) const;
+    double totalScore(size_t slot) const { return (double)table.rowTotal(slot); }
+    double averageScore(size_t slot) const {
+        int n = table.count(slot);
+        return n ? totalScore(slot) / n : 0.0;
+    }
+
+    // Slot of roll, or -1.
+    int indexOf(int roll) const;
+    const StudentInfo* find(int roll) const;
+    bool contains(int roll) const { return byRoll.get(roll) != RollIndex::NONE; }
+
+    bool insert(const Student& s);    // false if roll already present
+    bool update(const Student& s);    // false if roll missing
+    void upsert(const Student& s);
+    bool erase(int roll);
+
+    // ---------- Rankings (by total, best first) ----------
+    size_t rankOf(int roll) const;          // 1-based; 0 if absent
+    std::vector<int> topRolls(size_t k) const;
+    double percentileOf(double score) const;
+    // Builds the ranking now if a bulk assign() left it unbuilt, so the first
+    // of the calls above doesn't pay for it (~0.9 s at 1M students).
+    void warmRanking() const { scoreRanking(); }
+
+    // Trigram index over names, kept per edit once built.
+    const NameIndex& nameIndex() const;
+    // Builds up to n more names of that index, so a UI can spread the first
+    // build over frames. True once it is complete; an edit restarts it.
+    bool warmNameIndex(size_t n) const;
+
+    // Calls f(size_t slot) for every roll in [lo, hi], in roll order.
+    template <class F>
+    void forEachInRange(int lo, int hi, F f) const {
+        const std::set<int>& o = orderedIndex();
+        for (auto it = o.lower_bound(lo); it != o.end() && *it <= hi; ++it)
+            f((size_t)byRoll.get(*it));
+    }
+
+private:
+    const std::set<int>& orderedIndex() const;
+    const ScoreRanking& scoreRanking() const;
+
+    std::vector<StudentInfo> recs;
+    MarksTable table;
+    RollIndex byRoll;
+    std::vector<int32_t> rollCol;
+    mutable std::set<int> ordered;
+    mutable bool orderedValid = true;
+    mutable ScoreRanking ranking;
+    mutable bool rankingValid = true;
+    mutable NameIndex names;
+    mutable bool namesValid = true;
+    uint64_t rev = 0;
+};
@@ -0,0 +1,83 @@
+#include "work_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(unsigned n) {
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned w = 0; w < n; ++w) queues.push_back(std::make_unique<Queue>());
+    for (unsigned w = 1; w < n; ++w) threads.emplace_back([this, w] { workerLoop(w); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lk(m);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) t.join();
+}
+
+bool WorkStealingPool::take(unsigned worker, size_t& task) {
+    {
+        Queue& q = *queues[worker];
+        std::lock_guard<std::mutex> lk(q.m);
+        if (!q.tasks.empty()) {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned i = 1; i < size(); ++i) {
+        Queue& q = *queues[(worker + i) % size()];
+        std::lock_guard<std::mutex> lk(q.m);
+        if (!q.tasks.empty()) {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns once every deque was empty; tasks other workers already took may
+// still be running.
+void WorkStealingPool::drain(unsigned worker) {
+    size_t task;
+    while (take(worker, task)) (*job)(task, worker);
+}
+
+void WorkStealingPool::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lk(m);
+    for (;;) {
+        wake.wait(lk, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        lk.unlock();
+        drain(worker);
+        lk.lock();
+        if (--busy == 0) idle.notify_one();
+    }
+}
+
+void WorkStealingPool::run(size_t tasks, const std::function<void(size_t, unsigned)>& fn) {
+    if (tasks == 0) return;
+    // Tasks are pushed in reverse so each worker runs its block front to back.
+    unsigned n = size();
+    for (unsigned w = 0; w < n; ++w) {
+        size_t lo = tasks * w / n, hi = tasks * (w + 1) / n;
+        std::lock_guard<std::mutex> lk(queues[w]->m);
+        for (size_t t = hi; t > lo; --t) queues[w]->tasks.push_back(t - 1);
+    }
+    {
+        std::lock_guard<std::mutex> lk(m);
+        job = &fn;
+        busy = n - 1;
+        generation++;
+    }
+    wake.notify_all();
+    drain(0);
+    std::unique_lock<std::mutex> lk(m);
+    idle.wait(lk, [&] { return busy == 0; });
+    job = nullptr;
+}
@@ -0,0 +1,52 @@
+// Work-stealing thread pool for batch jobs (no raylib dependency)
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Each worker owns a deque of task ids. run() deals the tasks out in
+// contiguous blocks, one per worker; a worker takes from the back of its own
+// deque and, once that is empty, steals from the front of the others'. Tasks
+// of uneven cost (a chunk of long rows next to a chunk of short ones) even
+// out without every task going through one shared counter. Threads are
+// started once and sleep between runs.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads = 0);   // 0 = std::thread::hardware_concurrency()
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return (unsigned)queues.size(); }
+    // Calls fn(task, worker) for every task in [0, tasks) and returns once all
+    // are done. The calling thread works too, as worker 0. One run at a time.
+    void run(size_t tasks, const std::function<void(size_t task, unsigned worker)>& fn);
+    // Tasks taken from another worker's deque, over all runs.
+    size_t steals() const { return stolen; }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<size_t> tasks;
+    };
+    bool take(unsigned worker, size_t& task);
+    void drain(unsigned worker);
+    void workerLoop(unsigned worker);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex m;
+    std::condition_variable wake, idle;
+    const std::function<void(size_t, unsigned)>* job = nullptr;
+    uint64_t generation = 0;
+    unsigned busy = 0;
+    bool stopping = false;
+    std::atomic<size_t> stolen{0};
+};